@@ -0,0 +1,138 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <cstdint>
+
+// --- CPU scope profiler ------------------------------------------------------
+// PROFILE_SCOPE("name") times the enclosing block. Each thread appends to its
+// own fixed-size ring (single writer, no locks after the first event), so the
+// oldest events are overwritten once a thread records more than
+// EVENTS_PER_THREAD. dump() writes everything still held as Chrome trace_event
+// JSON (open in chrome://tracing or ui.perfetto.dev).
+//
+// Names must outlive the dump; string literals are the intended use.
+// dump() reads other threads' rings without stopping them, so call it at a
+// quiet point (between frames, at exit) to avoid torn events.
+//
+// Define CPU_PROFILER_DISABLED to compile every scope out.
+
+class CpuProfiler {
+public:
+    static constexpr uint32_t EVENTS_PER_THREAD = 1u << 15;   // power of two
+
+    class Scope {
+    public:
+        explicit Scope(const char* n) : name(n), start(now()) {}
+        ~Scope() { record(name, start, now()); }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    private:
+        const char* name;
+        uint64_t start;
+    };
+
+    // Label the calling thread in the trace viewer. A no-op when profiling is
+    // compiled out, so naming a thread does not allocate its event ring.
+#ifdef CPU_PROFILER_DISABLED
+    static void setThreadName(const char*) {}
+#else
+    static void setThreadName(const char* name) { local().threadName = name; }
+#endif
+
+    static bool dump(const std::string& path) {
+        std::ofstream out(path, std::ios::trunc);
+        if (!out) return false;
+        out << std::fixed << std::setprecision(3);   // microseconds, ns resolution
+        out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+        bool first = true;
+        Registry& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        for (const auto& t : reg.threads) {
+            if (t->threadName) {
+                out << (first ? "" : ",\n") << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":0,\"tid\":" << t->tid
+                    << ",\"args\":{\"name\":\"" << escaped(t->threadName) << "\"}}";
+                first = false;
+            }
+            uint64_t head = t->head.load(std::memory_order_acquire);
+            uint64_t begin = head > EVENTS_PER_THREAD ? head - EVENTS_PER_THREAD : 0;
+            for (uint64_t i = begin; i < head; ++i) {
+                const Event& e = t->events[i & (EVENTS_PER_THREAD - 1)];
+                out << (first ? "" : ",\n") << "{\"ph\":\"X\",\"name\":\"" << escaped(e.name) << "\",\"pid\":0,\"tid\":"
+                    << t->tid << ",\"ts\":" << e.startNs / 1000.0 << ",\"dur\":" << (e.endNs - e.startNs) / 1000.0 << "}";
+                first = false;
+            }
+        }
+        out << "\n]}\n";
+        return (bool)out;
+    }
+
+private:
+    struct Event { const char* name; uint64_t startNs, endNs; };
+
+    struct ThreadBuffer {
+        std::unique_ptr<Event[]> events{ new Event[EVENTS_PER_THREAD] };
+        std::atomic<uint64_t> head{ 0 };
+        uint32_t tid = 0;
+        const char* threadName = nullptr;
+    };
+
+    // Buffers are owned here so they outlive the threads that wrote them.
+    struct Registry {
+        std::mutex mutex;
+        std::vector<std::unique_ptr<ThreadBuffer>> threads;
+    };
+
+    static Registry& registry() {
+        static Registry reg;
+        return reg;
+    }
+
+    static ThreadBuffer& local() {
+        thread_local ThreadBuffer* buffer = nullptr;
+        if (!buffer) {
+            Registry& reg = registry();
+            std::lock_guard<std::mutex> lock(reg.mutex);
+            reg.threads.push_back(std::make_unique<ThreadBuffer>());
+            buffer = reg.threads.back().get();
+            buffer->tid = (uint32_t)reg.threads.size();
+        }
+        return *buffer;
+    }
+
+    static uint64_t now() {
+        static const auto epoch = std::chrono::steady_clock::now();
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - epoch).count();
+    }
+
+    static void record(const char* name, uint64_t start, uint64_t end) {
+        ThreadBuffer& t = local();
+        uint64_t h = t.head.load(std::memory_order_relaxed);
+        t.events[h & (EVENTS_PER_THREAD - 1)] = { name, start, end };
+        t.head.store(h + 1, std::memory_order_release);
+    }
+
+    static std::string escaped(const char* s) {
+        std::string out;
+        for (; *s; ++s) {
+            if (*s == '"' || *s == '\\') out += '\\';
+            out += *s;
+        }
+        return out;
+    }
+};
+
+#define CPU_PROFILER_CONCAT2(a, b) a##b
+#define CPU_PROFILER_CONCAT(a, b) CPU_PROFILER_CONCAT2(a, b)
+
+#ifdef CPU_PROFILER_DISABLED
+#define PROFILE_SCOPE(name) ((void)0)
+#else
+#define PROFILE_SCOPE(name) CpuProfiler::Scope CPU_PROFILER_CONCAT(profileScope_, __LINE__)(name)
+#endif
@@ -0,0 +1,102 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <fstream>
+#include <chrono>
+#include <algorithm>
+#include <cstdint>
+
+// --- Frame latency -----------------------------------------------------------
+// Per-frame latency from the input poll a frame was built from to the moment
+// its fence is seen signalled: the GPU has finished the frame and the present
+// waiting on it can go ahead. Display-side queueing (FIFO depth, scanout) is
+// not visible without present-timing extensions, so FIFO profiles read low by
+// up to the swapchain depth in refresh intervals.
+//
+// Completion is noticed when the app polls or waits on a fence, so with more
+// than one frame in flight a sample can be late by up to one CPU frame. The
+// last WINDOW samples are kept for min/avg/p99; if a log path is given every
+// sample is also appended there as CSV.
+
+class FrameLatency {
+public:
+    using clock = std::chrono::steady_clock;
+    static constexpr uint32_t WINDOW = 512;
+
+    struct Summary {
+        double minMs = 0.0, avgMs = 0.0, p99Ms = 0.0;   // input -> GPU done
+        double submitMs = 0.0;                          // input -> queue submit, average
+        uint64_t samples = 0;
+    };
+
+    void init(uint32_t framesInFlight, const std::string& logPath = {}) {
+        frames.assign(framesInFlight, {});
+        if (!logPath.empty()) {
+            log.open(logPath, std::ios::trunc);
+            if (log) log << "frame,input_to_submit_ms,input_to_done_ms\n";
+        }
+    }
+
+    bool logging() const { return log.is_open() && (bool)log; }
+
+    // The frame about to be built in `slot` took its input at `input`.
+    void begin(uint32_t slot, clock::time_point input) {
+        frames[slot] = { input, input, false, true, ++serial };
+    }
+
+    void submitted(uint32_t slot, clock::time_point t) {
+        frames[slot].submit = t;
+        frames[slot].submitted = true;
+    }
+
+    // `slot`'s fence was seen signalled at `t`; later calls for the same frame are ignored.
+    void completed(uint32_t slot, clock::time_point t) {
+        Frame& f = frames[slot];
+        if (!f.pending || !f.submitted) return;
+        f.pending = false;
+        double submitMs = std::chrono::duration<double, std::milli>(f.submit - f.input).count();
+        double doneMs = std::chrono::duration<double, std::milli>(t - f.input).count();
+        if (window.size() < WINDOW) window.push_back(doneMs);
+        else window[head % WINDOW] = doneMs;
+        head++;
+        submitSum += submitMs;
+        count++;
+        if (logging()) log << f.serial << "," << submitMs << "," << doneMs << "\n";
+    }
+
+    bool pending(uint32_t slot) const { return frames[slot].pending && frames[slot].submitted; }
+
+    Summary summary() const {
+        Summary s;
+        s.samples = count;
+        if (window.empty()) return s;
+        std::vector<double> sorted(window);
+        std::sort(sorted.begin(), sorted.end());
+        s.minMs = sorted.front();
+        double sum = 0.0;
+        for (double v : sorted) sum += v;
+        s.avgMs = sum / sorted.size();
+        s.p99Ms = sorted[std::min(sorted.size() - 1, (size_t)(sorted.size() * 0.99))];
+        s.submitMs = submitSum / (double)count;
+        return s;
+    }
+
+    void reset() {
+        window.clear();
+        head = count = 0;
+        submitSum = 0.0;
+    }
+
+private:
+    struct Frame {
+        clock::time_point input, submit;
+        bool submitted = false, pending = false;
+        uint64_t serial = 0;
+    };
+
+    std::vector<Frame> frames;
+    std::vector<double> window;
+    uint64_t head = 0, count = 0, serial = 0;
+    double submitSum = 0.0;
+    std::ofstream log;
+};
@@ -0,0 +1,331 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <algorithm>
+#include <cstdint>
+
+// --- Block-based GPU memory sub-allocator ---------------------------------
+// One pool per (memory type, strategy, linear/optimal resource kind). Each pool
+// owns a list of large VkDeviceMemory blocks and carves allocations out of them,
+// so the whole app needs a handful of vkAllocateMemory calls instead of one per
+// buffer/image. Host-visible blocks are mapped once and stay mapped.
+
+enum class AllocStrategy {
+    Linear, // bump pointer; block rewinds when its last allocation is freed (staging, per-frame data)
+    Buddy   // power-of-two buddy system; frees coalesce (long-lived buffers and images)
+};
+
+struct GpuMemoryBlock;
+
+struct GpuAllocation {
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkDeviceSize   offset = 0;
+    VkDeviceSize   size = 0;
+    void*          mapped = nullptr; // host pointer at `offset` (host-visible memory only)
+
+    // bookkeeping for free()
+    GpuMemoryBlock* block = nullptr;
+    VkDeviceSize    reserved = 0;     // bytes taken out of the block (size + padding / buddy rounding)
+    uint32_t        order = 0;        // buddy order
+
+    explicit operator bool() const { return memory != VK_NULL_HANDLE; }
+};
+
+struct GpuMemoryBlock {
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkDeviceSize   size = 0;
+    void*          mapped = nullptr;
+    AllocStrategy  strategy = AllocStrategy::Buddy;
+    bool           dedicated = false;
+    uint32_t       liveCount = 0;
+    VkDeviceSize   used = 0;          // linear: head, buddy: sum of handed-out nodes
+
+    // buddy: free node offsets per order (order 0 = minNodeSize)
+    std::vector<std::vector<VkDeviceSize>> freeLists;
+};
+
+class GpuAllocator {
+public:
+    struct Stats {
+        VkDeviceSize liveBytes = 0;      // bytes requested by live allocations
+        VkDeviceSize wastedBytes = 0;    // alignment padding, buddy rounding, dead linear space
+        VkDeviceSize reservedBytes = 0;  // total size of all VkDeviceMemory blocks
+        uint32_t     blockCount = 0;     // live vkAllocateMemory objects
+        uint32_t     allocationCount = 0;
+    };
+
+    static constexpr VkDeviceSize DEFAULT_BLOCK_SIZE = 64ull * 1024 * 1024;
+    static constexpr VkDeviceSize MIN_NODE_SIZE = 256;
+
+    void init(VkPhysicalDevice physicalDevice, VkDevice dev, VkDeviceSize blockSize = DEFAULT_BLOCK_SIZE) {
+        device = dev;
+        vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProps);
+        VkPhysicalDeviceProperties props{};
+        vkGetPhysicalDeviceProperties(physicalDevice, &props);
+        maxAllocationCount = props.limits.maxMemoryAllocationCount;
+
+        // buddy blocks must be a power of two
+        defaultBlockSize = MIN_NODE_SIZE;
+        while (defaultBlockSize < blockSize) defaultBlockSize <<= 1;
+    }
+
+    void destroy() {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto& p : pools) {
+            for (auto& b : p.blocks) releaseBlock(*b);
+            p.blocks.clear();
+        }
+        pools.clear();
+        device = VK_NULL_HANDLE;
+    }
+
+    uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags props) const {
+        for (uint32_t i = 0; i < memProps.memoryTypeCount; i++) {
+            if ((typeFilter & (1u << i)) && (memProps.memoryTypes[i].propertyFlags & props) == props) return i;
+        }
+        throw std::runtime_error("failed to find suitable memory type");
+    }
+
+    // `optimalImage` keeps optimal-tiling images out of the pools used for buffers
+    // and linear images, so neighbours never violate bufferImageGranularity.
+    GpuAllocation allocate(const VkMemoryRequirements& req, VkMemoryPropertyFlags props,
+        bool optimalImage, AllocStrategy strategy = AllocStrategy::Buddy)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        uint32_t type = findMemoryType(req.memoryTypeBits, props);
+        Pool& pool = getPool(type, strategy, optimalImage);
+
+        VkDeviceSize alignment = std::max<VkDeviceSize>(req.alignment, 1);
+
+        // big resources get their own block; splitting them buys nothing
+        if (req.size > defaultBlockSize / 2) {
+            GpuMemoryBlock& b = newBlock(pool, req.size, true);
+            b.liveCount = 1;
+            b.used = req.size;
+            GpuAllocation a{};
+            a.memory = b.memory; a.offset = 0; a.size = req.size;
+            a.mapped = b.mapped; a.block = &b; a.reserved = req.size;
+            liveBytes += a.size;
+            allocationCount++;
+            return a;
+        }
+
+        for (auto& b : pool.blocks) {
+            if (b->dedicated) continue;
+            GpuAllocation a{};
+            if (tryAllocate(*b, req.size, alignment, a)) return a;
+        }
+
+        GpuMemoryBlock& b = newBlock(pool, defaultBlockSize, false);
+        GpuAllocation a{};
+        if (!tryAllocate(b, req.size, alignment, a))
+            throw std::runtime_error("GpuAllocator: allocation does not fit in a fresh block");
+        return a;
+    }
+
+    void free(GpuAllocation& a) {
+        if (!a.block) return;
+        std::lock_guard<std::mutex> lock(mutex);
+        GpuMemoryBlock& b = *a.block;
+
+        if (b.strategy == AllocStrategy::Buddy && !b.dedicated) {
+            buddyFree(b, a.offset, a.order);
+            b.used -= a.reserved;
+        }
+        b.liveCount--;
+        if (b.strategy == AllocStrategy::Linear && b.liveCount == 0) b.used = 0; // rewind
+
+        liveBytes -= a.size;
+        allocationCount--;
+
+        if (b.liveCount == 0) trimPool(b);
+        a = GpuAllocation{};
+    }
+
+    Stats stats() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        Stats s{};
+        s.liveBytes = liveBytes;
+        s.allocationCount = allocationCount;
+        VkDeviceSize used = 0;
+        for (auto& p : pools) {
+            for (auto& b : p.blocks) {
+                s.blockCount++;
+                s.reservedBytes += b->size;
+                used += b->used;
+            }
+        }
+        s.wastedBytes = used - liveBytes;
+        return s;
+    }
+
+    VkDeviceSize blockSize() const { return defaultBlockSize; }
+
+private:
+    struct Pool {
+        uint32_t memoryType = 0;
+        AllocStrategy strategy = AllocStrategy::Buddy;
+        bool optimalImage = false;
+        std::vector<std::unique_ptr<GpuMemoryBlock>> blocks;
+    };
+
+    VkDevice device = VK_NULL_HANDLE;
+    VkPhysicalDeviceMemoryProperties memProps{};
+    uint32_t maxAllocationCount = 4096;
+    VkDeviceSize defaultBlockSize = DEFAULT_BLOCK_SIZE;
+
+    std::vector<Pool> pools;
+    VkDeviceSize liveBytes = 0;
+    uint32_t allocationCount = 0;
+    mutable std::mutex mutex;
+
+    static VkDeviceSize alignUp(VkDeviceSize v, VkDeviceSize a) { return (v + a - 1) / a * a; }
+
+    Pool& getPool(uint32_t type, AllocStrategy strategy, bool optimalImage) {
+        for (auto& p : pools) {
+            if (p.memoryType == type && p.strategy == strategy && p.optimalImage == optimalImage) return p;
+        }
+        pools.push_back({});
+        Pool& p = pools.back();
+        p.memoryType = type; p.strategy = strategy; p.optimalImage = optimalImage;
+        return p;
+    }
+
+    uint32_t liveBlockCount() const {
+        uint32_t n = 0;
+        for (auto& p : pools) n += (uint32_t)p.blocks.size();
+        return n;
+    }
+
+    GpuMemoryBlock& newBlock(Pool& pool, VkDeviceSize size, bool dedicated) {
+        if (liveBlockCount() >= maxAllocationCount)
+            throw std::runtime_error("GpuAllocator: maxMemoryAllocationCount reached");
+
+        VkMemoryAllocateInfo ai{ VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
+        ai.allocationSize = size;
+        ai.memoryTypeIndex = pool.memoryType;
+
+        auto b = std::make_unique<GpuMemoryBlock>();
+        if (vkAllocateMemory(device, &ai, nullptr, &b->memory) != VK_SUCCESS)
+            throw std::runtime_error("GpuAllocator: vkAllocateMemory failed");
+        b->size = size;
+        b->strategy = pool.strategy;
+        b->dedicated = dedicated;
+
+        if (memProps.memoryTypes[pool.memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+            if (vkMapMemory(device, b->memory, 0, VK_WHOLE_SIZE, 0, &b->mapped) != VK_SUCCESS) {
+                vkFreeMemory(device, b->memory, nullptr);
+                throw std::runtime_error("GpuAllocator: vkMapMemory failed");
+            }
+        }
+
+        if (b->strategy == AllocStrategy::Buddy && !dedicated) {
+            uint32_t orders = 1;
+            while ((MIN_NODE_SIZE << (orders - 1)) < size) orders++;
+            b->freeLists.resize(orders);
+            b->freeLists[orders - 1].push_back(0);
+        }
+
+        pool.blocks.push_back(std::move(b));
+        return *pool.blocks.back();
+    }
+
+    void releaseBlock(GpuMemoryBlock& b) {
+        if (b.mapped) vkUnmapMemory(device, b.memory);
+        vkFreeMemory(device, b.memory, nullptr);
+        b.memory = VK_NULL_HANDLE;
+        b.mapped = nullptr;
+    }
+
+    // Keep one empty shared block per pool around so a create/destroy
+    // pattern doesn't bounce vkAllocateMemory; release anything beyond that.
+    void trimPool(GpuMemoryBlock& emptied) {
+        for (auto& p : pools) {
+            auto it = std::find_if(p.blocks.begin(), p.blocks.end(),
+                [&](const std::unique_ptr<GpuMemoryBlock>& b) { return b.get() == &emptied; });
+            if (it == p.blocks.end()) continue;
+
+            bool keep = false;
+            if (!emptied.dedicated) {
+                keep = true;
+                for (auto& b : p.blocks) {
+                    if (b.get() != &emptied && !b->dedicated && b->liveCount == 0) { keep = false; break; }
+                }
+            }
+            if (!keep) {
+                releaseBlock(**it);
+                p.blocks.erase(it);
+            }
+            return;
+        }
+    }
+
+    bool tryAllocate(GpuMemoryBlock& b, VkDeviceSize size, VkDeviceSize alignment, GpuAllocation& out) {
+        VkDeviceSize offset = 0;
+        VkDeviceSize reserved = 0;
+        uint32_t order = 0;
+
+        if (b.strategy == AllocStrategy::Linear) {
+            offset = alignUp(b.used, alignment);
+            if (offset + size > b.size) return false;
+            reserved = offset + size - b.used;
+            b.used = offset + size;
+        }
+        else {
+            // a buddy node of size 2^k sits on a 2^k boundary, so rounding the
+            // request up to the alignment also satisfies the alignment
+            VkDeviceSize need = std::max({ size, alignment, MIN_NODE_SIZE });
+            while ((MIN_NODE_SIZE << order) < need) order++;
+            if (order >= b.freeLists.size() || !buddyAlloc(b, order, offset)) return false;
+            reserved = MIN_NODE_SIZE << order;
+            b.used += reserved;
+        }
+
+        b.liveCount++;
+        out.memory = b.memory;
+        out.offset = offset;
+        out.size = size;
+        out.mapped = b.mapped ? static_cast<char*>(b.mapped) + offset : nullptr;
+        out.block = &b;
+        out.reserved = reserved;
+        out.order = order;
+
+        liveBytes += size;
+        allocationCount++;
+        return true;
+    }
+
+    static bool buddyAlloc(GpuMemoryBlock& b, uint32_t order, VkDeviceSize& offset) {
+        uint32_t k = order;
+        while (k < b.freeLists.size() && b.freeLists[k].empty()) k++;
+        if (k == b.freeLists.size()) return false;
+
+        VkDeviceSize node = b.freeLists[k].back();
+        b.freeLists[k].pop_back();
+        // split down, keeping the lower half and freeing the upper buddy
+        while (k > order) {
+            k--;
+            b.freeLists[k].push_back(node + (MIN_NODE_SIZE << k));
+        }
+        offset = node;
+        return true;
+    }
+
+    static void buddyFree(GpuMemoryBlock& b, VkDeviceSize offset, uint32_t order) {
+        uint32_t k = order;
+        while (k + 1 < b.freeLists.size()) {
+            VkDeviceSize buddy = offset ^ (MIN_NODE_SIZE << k);
+            auto& list = b.freeLists[k];
+            auto it = std::find(list.begin(), list.end(), buddy);
+            if (it == list.end()) break;
+            *it = list.back();
+            list.pop_back();
+            offset = std::min(offset, buddy);
+            k++;
+        }
+        b.freeLists[k].push_back(offset);
+    }
+};
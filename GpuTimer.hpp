@@ -0,0 +1,250 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <string>
+#include <optional>
+#include <algorithm>
+#include <stdexcept>
+#include <cstdint>
+#include <chrono>
+
+// --- GPU pass timer ----------------------------------------------------------
+// Timestamp queries around named scopes in a frame's command buffer. Each frame
+// in flight owns a slice of the query pool; its results are read back the next
+// time that slot is recorded (after its fence has been waited on), so reading
+// never stalls. GPU times are kept over a rolling window per scope name and
+// reported as min/avg/p99.
+// When the device has pipelineStatisticsQuery enabled, each scope also gets a
+// pipeline-statistics query (vertices, primitives, shader invocations).
+// The CPU time spent recording each scope is tracked alongside, and still
+// works when the queue has no timestamp support.
+// Scopes must not nest: statistics queries of one pool can't overlap.
+
+class GpuTimer {
+public:
+    static constexpr uint32_t WINDOW = 256;   // GPU samples kept per scope
+
+    // Per-frame averages of the counters collected for one scope
+    struct PipelineStats {
+        double inputVertices = 0.0;
+        double vertexInvocations = 0.0;
+        double clippingPrimitives = 0.0;
+        double fragmentInvocations = 0.0;
+        double computeInvocations = 0.0;
+    };
+
+    struct Result {
+        std::string name;
+        double      gpuMs = 0.0;     // rolling average GPU execution time
+        double      minMs = 0.0;     // rolling minimum
+        double      p99Ms = 0.0;     // rolling 99th percentile
+        double      cpuMs = 0.0;     // average CPU time spent recording
+        uint64_t    samples = 0;     // GPU samples read back
+        std::optional<PipelineStats> stats;
+    };
+
+    void init(VkPhysicalDevice gpu, VkDevice dev, uint32_t queueFamily, uint32_t framesInFlight,
+        bool pipelineStatistics = false, uint32_t maxScopesPerFrame = 16)
+    {
+        device = dev;
+        frames = framesInFlight;
+        maxScopes = maxScopesPerFrame;
+
+        VkPhysicalDeviceProperties props{};
+        vkGetPhysicalDeviceProperties(gpu, &props);
+        periodNs = props.limits.timestampPeriod;
+
+        uint32_t count = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties(gpu, &count, nullptr);
+        std::vector<VkQueueFamilyProperties> families(count);
+        vkGetPhysicalDeviceQueueFamilyProperties(gpu, &count, families.data());
+        supported = queueFamily < count && families[queueFamily].timestampValidBits > 0 && periodNs > 0.0f;
+        if (!supported) return;
+
+        VkQueryPoolCreateInfo qi{ VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO };
+        qi.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        qi.queryCount = frames * maxScopes * 2;
+        if (vkCreateQueryPool(device, &qi, nullptr, &pool) != VK_SUCCESS)
+            throw std::runtime_error("failed to create timestamp query pool");
+
+        if (pipelineStatistics) {
+            VkQueryPoolCreateInfo si{ VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO };
+            si.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+            si.queryCount = frames * maxScopes;
+            si.pipelineStatistics = STAT_FLAGS;
+            if (vkCreateQueryPool(device, &si, nullptr, &statsPool) != VK_SUCCESS)
+                throw std::runtime_error("failed to create pipeline statistics query pool");
+        }
+
+        slots.resize(frames);
+    }
+
+    void destroy() {
+        if (pool != VK_NULL_HANDLE) vkDestroyQueryPool(device, pool, nullptr);
+        if (statsPool != VK_NULL_HANDLE) vkDestroyQueryPool(device, statsPool, nullptr);
+        pool = VK_NULL_HANDLE;
+        statsPool = VK_NULL_HANDLE;
+    }
+
+    bool isSupported() const { return supported; }
+    bool hasPipelineStats() const { return statsPool != VK_NULL_HANDLE; }
+    // Flags of the statistics query open around each scope; secondaries
+    // executed inside a scope must inherit exactly these.
+    VkQueryPipelineStatisticFlags statisticFlags() const { return statsPool ? STAT_FLAGS : 0; }
+
+    // Call right after vkBeginCommandBuffer for `frame`.
+    void beginFrame(VkCommandBuffer cb, uint32_t frame) {
+        if (!supported) return;
+        current = frame;
+        collect(frame);
+        vkCmdResetQueryPool(cb, pool, frame * maxScopes * 2, maxScopes * 2);
+        if (statsPool) vkCmdResetQueryPool(cb, statsPool, frame * maxScopes, maxScopes);
+        slots[frame].names.clear();
+    }
+
+    void begin(VkCommandBuffer cb, const char* name) {
+        openScope = name;
+        openStart = std::chrono::steady_clock::now();
+        openQuery = false;
+        if (!supported) return;
+        Slot& s = slots[current];
+        if (s.names.size() >= maxScopes) return;
+        s.names.push_back(name);
+        uint32_t scope = (uint32_t)s.names.size() - 1;
+        vkCmdWriteTimestamp2(cb, VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT, pool, query(current, scope, 0));
+        if (statsPool) vkCmdBeginQuery(cb, statsPool, current * maxScopes + scope, 0);
+        openQuery = true;
+    }
+
+    void end(VkCommandBuffer cb) {
+        if (openScope) {
+            Accum& a = accum(openScope);
+            a.cpuTotalMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - openStart).count();
+            a.cpuSamples++;
+            openScope = nullptr;
+        }
+        if (!openQuery) return;
+        openQuery = false;
+        uint32_t scope = (uint32_t)slots[current].names.size() - 1;
+        if (statsPool) vkCmdEndQuery(cb, statsPool, current * maxScopes + scope);
+        vkCmdWriteTimestamp2(cb, VK_PIPELINE_STAGE_2_BOTTOM_OF_PIPE_BIT, pool, query(current, scope, 1));
+    }
+
+    // Read back every frame still outstanding. Only valid once the device is idle.
+    void resolve() {
+        if (!supported) return;
+        for (uint32_t f = 0; f < frames; ++f) {
+            collect(f);
+            slots[f].names.clear();
+        }
+    }
+
+    // Drop accumulated averages and anything not yet read back.
+    void reset() {
+        totals.clear();
+        for (Slot& s : slots) s.names.clear();
+    }
+
+    std::vector<Result> results() const {
+        std::vector<Result> out;
+        for (const Accum& a : totals) out.push_back(summarize(a));
+        return out;
+    }
+
+    std::optional<Result> result(const std::string& name) const {
+        for (const Accum& a : totals) if (a.name == name) return summarize(a);
+        return std::nullopt;
+    }
+
+private:
+    static constexpr VkQueryPipelineStatisticFlags STAT_FLAGS =
+        VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_VERTICES_BIT |
+        VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
+        VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT |
+        VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT |
+        VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT;
+    static constexpr uint32_t STAT_COUNT = 5;   // bits set in STAT_FLAGS, in bit order
+
+    struct Slot { std::vector<const char*> names; };
+    struct Accum {
+        std::string name;
+        std::vector<double> window;   // last WINDOW GPU times, ring-indexed by samples
+        uint64_t samples = 0;
+        double cpuTotalMs = 0.0;
+        uint64_t cpuSamples = 0;
+        uint64_t statTotals[STAT_COUNT] = {};
+        uint64_t statSamples = 0;
+    };
+
+    VkDevice device = VK_NULL_HANDLE;
+    VkQueryPool pool = VK_NULL_HANDLE;
+    VkQueryPool statsPool = VK_NULL_HANDLE;
+    uint32_t frames = 0, maxScopes = 0, current = 0;
+    float periodNs = 0.0f;
+    bool supported = false;
+    std::vector<Slot> slots;
+    std::vector<Accum> totals;
+    const char* openScope = nullptr;
+    bool openQuery = false;
+    std::chrono::steady_clock::time_point openStart;
+
+    uint32_t query(uint32_t frame, uint32_t scope, uint32_t edge) const {
+        return (frame * maxScopes + scope) * 2 + edge;
+    }
+
+    void collect(uint32_t frame) {
+        Slot& s = slots[frame];
+        if (s.names.empty()) return;
+        std::vector<uint64_t> ticks(s.names.size() * 2);
+        VkResult r = vkGetQueryPoolResults(device, pool, query(frame, 0, 0), (uint32_t)ticks.size(),
+            ticks.size() * sizeof(uint64_t), ticks.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+        if (r == VK_SUCCESS) {   // VK_NOT_READY: skip this sample rather than stall
+            for (size_t i = 0; i < s.names.size(); ++i) {
+                Accum& a = accum(s.names[i]);
+                double ms = (double)(ticks[i * 2 + 1] - ticks[i * 2]) * periodNs / 1e6;
+                if (a.window.size() < WINDOW) a.window.push_back(ms);
+                else a.window[a.samples % WINDOW] = ms;
+                a.samples++;
+            }
+        }
+
+        if (!statsPool) return;
+        std::vector<uint64_t> counters(s.names.size() * STAT_COUNT);
+        r = vkGetQueryPoolResults(device, statsPool, frame * maxScopes, (uint32_t)s.names.size(),
+            counters.size() * sizeof(uint64_t), counters.data(), STAT_COUNT * sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+        if (r != VK_SUCCESS) return;
+        for (size_t i = 0; i < s.names.size(); ++i) {
+            Accum& a = accum(s.names[i]);
+            for (uint32_t c = 0; c < STAT_COUNT; ++c) a.statTotals[c] += counters[i * STAT_COUNT + c];
+            a.statSamples++;
+        }
+    }
+
+    Accum& accum(const char* name) {
+        for (Accum& a : totals) if (a.name == name) return a;
+        totals.push_back({ name });
+        return totals.back();
+    }
+
+    static Result summarize(const Accum& a) {
+        Result r;
+        r.name = a.name;
+        r.samples = a.samples;
+        r.cpuMs = a.cpuSamples ? a.cpuTotalMs / (double)a.cpuSamples : 0.0;
+        if (!a.window.empty()) {
+            std::vector<double> sorted = a.window;
+            std::sort(sorted.begin(), sorted.end());
+            double sum = 0.0;
+            for (double ms : sorted) sum += ms;
+            r.gpuMs = sum / (double)sorted.size();
+            r.minMs = sorted.front();
+            r.p99Ms = sorted[std::min(sorted.size() - 1, (size_t)((double)sorted.size() * 0.99))];
+        }
+        if (a.statSamples) {
+            double n = (double)a.statSamples;
+            r.stats = PipelineStats{ a.statTotals[0] / n, a.statTotals[1] / n, a.statTotals[2] / n,
+                a.statTotals[3] / n, a.statTotals[4] / n };
+        }
+        return r;
+    }
+};
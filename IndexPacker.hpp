@@ -0,0 +1,73 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <cstring>
+#include <cstdint>
+
+// --- Index packing -----------------------------------------------------------
+// Collects the index lists of several meshes into one shared index buffer.
+// Each mesh gets the narrowest type its vertex count allows: UINT16 while
+// every vertex index stays below the 0xFFFF restart value, UINT32 otherwise.
+// Ranges start on 4-byte boundaries so either type can be bound at its own
+// offset. Restart markers in the input (RESTART_INDEX, as in the strips from
+// Week_3/GeometryUtil.hpp) are rewritten to the chosen type's restart value.
+
+struct IndexRange {
+    VkIndexType type = VK_INDEX_TYPE_UINT32;
+    VkDeviceSize offset = 0;      // bytes into the shared buffer
+    uint32_t count = 0;
+    uint32_t restart = 0xFFFFFFFFu;
+};
+
+class IndexPacker {
+public:
+    static constexpr uint32_t RESTART_INDEX = 0xFFFFFFFFu;
+
+    static VkIndexType typeFor(uint32_t vertexCount) {
+        return vertexCount <= 0xFFFFu ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+    }
+
+    // `indices` address `vertexCount` vertices; returns where they landed.
+    IndexRange add(const std::vector<uint32_t>& indices, uint32_t vertexCount) {
+        IndexRange r;
+        r.type = typeFor(vertexCount);
+        r.count = (uint32_t)indices.size();
+        r.offset = (bytes.size() + 3) & ~size_t(3);
+
+        const bool narrow = r.type == VK_INDEX_TYPE_UINT16;
+        r.restart = narrow ? 0xFFFFu : RESTART_INDEX;
+        bytes.resize(r.offset + (size_t)r.count * (narrow ? 2 : 4));
+        unsigned char* dst = bytes.data() + r.offset;
+        if (narrow) {
+            for (uint32_t i = 0; i < r.count; ++i) {
+                uint16_t v = indices[i] == RESTART_INDEX ? (uint16_t)0xFFFFu : (uint16_t)indices[i];
+                std::memcpy(dst + i * 2, &v, 2);
+            }
+        }
+        else {
+            std::memcpy(dst, indices.data(), (size_t)r.count * 4);
+        }
+
+        ranges++;
+        wideBytes += (VkDeviceSize)r.count * 4;
+        return r;
+    }
+
+    const void* data() const { return bytes.data(); }
+    VkDeviceSize size() const { return bytes.size(); }
+    uint32_t rangeCount() const { return ranges; }
+    // What the same ranges would take as UINT32, for logging.
+    VkDeviceSize wideSize() const { return wideBytes; }
+
+    void clear() {
+        bytes.clear();
+        bytes.shrink_to_fit();
+        ranges = 0;
+        wideBytes = 0;
+    }
+
+private:
+    std::vector<unsigned char> bytes;
+    uint32_t ranges = 0;
+    VkDeviceSize wideBytes = 0;
+};
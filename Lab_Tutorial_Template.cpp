@@ -12,6 +12,19 @@
 
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
+#undef STB_IMAGE_IMPLEMENTATION
+
+#define STB_IMAGE_RESIZE_IMPLEMENTATION
+#include <stb_image_resize2.h>
+#undef STB_IMAGE_RESIZE_IMPLEMENTATION
+
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
+#undef STB_IMAGE_WRITE_IMPLEMENTATION
+
+#define STB_PERLIN_IMPLEMENTATION
+#include <stb_perlin.h>
+#undef STB_PERLIN_IMPLEMENTATION
 
 #include <iostream>
 #include <fstream>
@@ -21,15 +34,38 @@
 #include <vector>
 #include <cstring>
 #include <cstdlib>
+#include <cstdio>
 #include <cstdint>
 #include <limits>
 #include <array>
 #include <optional>
 #include <set>
 #include <cmath>
+#include <sstream>
+#include <string>
+
+#include "GpuAllocator.hpp"
+#include "UploadBatcher.hpp"
+#include "PipelineCache.hpp"
+#include "TextureCache.hpp"
+#include "ThreadPool.hpp"
+#include "GpuTimer.hpp"
+#include "CpuProfiler.hpp"
+#include "UniformRing.hpp"
+#include "NormalMatrix.hpp"
+#include "ParallelRecorder.hpp"
+#include "RenderGraph.hpp"
+#include "RetireQueue.hpp"
+#include "FrameLatency.hpp"
+#include "MeshOptimizer.hpp"
+#include "IndexPacker.hpp"
+#include "VertexFormats.hpp"
+#include "TerrainChunks.hpp"
 
 // --- Small step logger (helps catch where init dies) ---
 #define STEP(msg) do { std::cerr << "[STEP] " << msg << std::endl; } while(0)
+// Logged like STEP, and timed as a CPU profiler scope
+#define STAGE(name, call) do { STEP(name); PROFILE_SCOPE(name); call; } while(0)
 
 static void glfwErrorCallback(int code, const char* desc) {
     std::cerr << "[GLFW] (" << code << ") " << desc << std::endl;
@@ -38,7 +74,8 @@ static void glfwErrorCallback(int code, const char* desc) {
 // --- Configuration ---
 const uint32_t WIDTH = 800;
 const uint32_t HEIGHT = 600;
-const int MAX_FRAMES_IN_FLIGHT = 2;
+// Upper bound for --frames-in-flight; the count in use is picked at startup
+const uint32_t MAX_FRAMES_IN_FLIGHT = 3;
 
 const std::vector<const char*> validationLayers = {
     "VK_LAYER_KHRONOS_validation"
@@ -47,6 +84,94 @@ const std::vector<const char*> deviceExtensions = {
     VK_KHR_SWAPCHAIN_EXTENSION_NAME
 };
 
+// Full-screen effect applied when the offscreen scene is composited to the swapchain
+enum class PostEffect {
+    Glow = 0,   // glow.frag composite over the bloom pyramid
+    BoxBlur,    // blur.frag, single-pass 7x7 box (49 fetches)
+    Gaussian    // gaussian.frag, separable H + V passes through the "blur" image
+};
+
+// Frames in flight and present-mode preference: latency against throughput
+enum class LatencyProfile {
+    LowLatency = 0,   // 1 frame in flight, MAILBOX > IMMEDIATE > FIFO
+    Balanced,         // 2 frames in flight, MAILBOX > FIFO
+    Throughput        // 3 frames in flight, FIFO
+};
+
+static uint32_t profileFramesInFlight(LatencyProfile p) {
+    switch (p) {
+    case LatencyProfile::LowLatency: return 1;
+    case LatencyProfile::Throughput: return 3;
+    default:                         return 2;
+    }
+}
+
+static const char* profileName(LatencyProfile p) {
+    switch (p) {
+    case LatencyProfile::LowLatency: return "low-latency";
+    case LatencyProfile::Throughput: return "throughput";
+    default:                         return "balanced";
+    }
+}
+
+// Vertex buffer layout of the scene meshes; the value is the VERTEX_FORMAT
+// specialization constant of shader.vert / instanced.vert
+enum class VertexEncoding {
+    Float32 = 0,   // Vertex, 44 bytes
+    Compact,       // CompactVertexF, 24 bytes: float pos, RGBA8, oct normal, half uv
+    Quantized      // CompactVertexQ, 20 bytes: as Compact with unorm16 pos in the mesh bounds
+};
+
+static const char* vertexEncodingName(VertexEncoding e) {
+    switch (e) {
+    case VertexEncoding::Compact:   return "compact";
+    case VertexEncoding::Quantized: return "quantized";
+    default:                        return "float32";
+    }
+}
+
+static const char* presentModeName(VkPresentModeKHR m) {
+    switch (m) {
+    case VK_PRESENT_MODE_IMMEDIATE_KHR:    return "IMMEDIATE";
+    case VK_PRESENT_MODE_MAILBOX_KHR:      return "MAILBOX";
+    case VK_PRESENT_MODE_FIFO_KHR:         return "FIFO";
+    case VK_PRESENT_MODE_FIFO_RELAXED_KHR: return "FIFO_RELAXED";
+    default:                               return "other";
+    }
+}
+
+// --- Command-line options ---
+struct AppOptions {
+    bool benchAllocator = false;   // --bench-alloc: time the GPU sub-allocator, then exit
+    PostEffect post = PostEffect::Glow; // --post glow|box|gaussian
+    int   blurRadius = 8;          // --blur-radius: Gaussian taps each side of the centre
+    float blurSigma = 4.0f;        // --blur-sigma: Gaussian sigma in texels
+    bool computePost = false;      // --compute: start on the compute post path
+    bool benchPost = false;        // --bench-post: time every post path on the GPU, then exit
+    // --headless: no window or surface; render into an owned image ring, report
+    // timings, then exit. Runs on any ICD, e.g. Mesa lavapipe on CI via
+    // VK_DRIVER_FILES=/usr/share/vulkan/icd.d/lvp_icd.x86_64.json
+    bool headless = false;
+    uint32_t frames = 300;         // --frames: headless frame count
+    uint32_t width = WIDTH;        // --size WxH: headless render resolution
+    uint32_t height = HEIGHT;
+    std::string output;            // --output: PNG of the last headless frame
+    std::string trace;             // --trace: Chrome trace of CPU scopes, written on exit (and on T)
+    uint32_t stressCubes = 0;      // --stress N: draw an N-cube grid instead of the single cube
+    bool benchInstancing = false;  // --bench-instancing: instanced vs push-constant draws, then exit
+    bool benchNormals = false;     // --bench-normals: scalar vs batched normal matrices (CPU only), then exit
+    int recordThreads = -1;        // --record-threads N: workers recording per-cube draws (0 = inline, -1 = pool size)
+    bool benchRecording = false;   // --bench-recording: per-cube draws recorded inline vs on 1..N workers, then exit
+    LatencyProfile latency = LatencyProfile::Balanced; // --latency low|balanced|throughput
+    uint32_t framesInFlight = 0;   // --frames-in-flight N: override the profile's count (1..MAX_FRAMES_IN_FLIGHT)
+    std::string frameLog;          // --frame-log: per-frame latency as CSV
+    VertexEncoding vertexFormat = VertexEncoding::Float32; // --vertex-format float|compact|quantized
+    bool benchVertexFormats = false; // --bench-vertex-formats: encode cost and scene fetch per layout, then exit
+    bool terrain = false;          // --terrain: stream a chunked Perlin terrain under a flying camera
+    int terrainRadius = 4;         // --terrain-radius N: tiles kept on each side of the camera's tile
+    bool benchTerrain = false;     // --bench-terrain: tile builds inline vs on the pool, then a streamed flight, then exit
+};
+
 #ifdef NDEBUG
 const bool enableValidationLayers = false;
 #else
@@ -79,14 +204,7 @@ struct Vertex {
         b.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
         return b;
     }
-    static std::array<VkVertexInputAttributeDescription, 4> getAttributeDescriptions() {
-        std::array<VkVertexInputAttributeDescription, 4> a{};
-        a[0] = { 0, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, pos) };
-        a[1] = { 1, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, color) };
-        a[2] = { 2, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, normal) };
-        a[3] = { 3, 0, VK_FORMAT_R32G32_SFLOAT,   offsetof(Vertex, uv) };
-        return a;
-    }
+    static std::array<VkVertexInputAttributeDescription, 4> getAttributeDescriptions();
 
     static std::array<VkVertexInputAttributeDescription, 2> getTexturedAttributeDescriptions() {
         std::array<VkVertexInputAttributeDescription, 2> a{};
@@ -107,21 +225,49 @@ struct Vertex {
     }
 };
 
+template <>
+struct VertexLayout<Vertex> {
+    static constexpr std::array<VkVertexInputAttributeDescription, 4> attributes{ {
+        vertexAttribute<glm::vec3>(0, offsetof(Vertex, pos)),
+        vertexAttribute<glm::vec3>(1, offsetof(Vertex, color)),
+        vertexAttribute<glm::vec3>(2, offsetof(Vertex, normal)),
+        vertexAttribute<glm::vec2>(3, offsetof(Vertex, uv)),
+    } };
+};
+
+inline std::array<VkVertexInputAttributeDescription, 4> Vertex::getAttributeDescriptions() {
+    return VertexLayout<Vertex>::attributes;
+}
+
 struct UniformBufferObject {
     alignas(16) glm::mat4 model;
     alignas(16) glm::mat4 view;
     alignas(16) glm::mat4 proj;
     alignas(16) glm::vec3 lightPos;
     alignas(16) glm::vec3 eyePos;
+    alignas(16) glm::mat3x4 normalMatrix;   // transpose(inverse(mat3(model))), std140 mat3
+    alignas(16) glm::vec4 posBias;          // VertexEncoding::Quantized: pos = bias + q * scale
+    alignas(16) glm::vec4 posScale;
 };
 
 struct PushConstants {
-    glm::mat4 modelOverride; // 64 bytes
-    uint32_t  useOverride;   // 4
-    uint32_t  unlit;         // 4
-    uint32_t  _pad0;         // 4
-    uint32_t  _pad1;         // 4   -> total 80 bytes
+    glm::mat4   modelOverride;  // 64 bytes
+    glm::mat3x4 normalOverride; // 48
+    uint32_t    useOverride;    // 4
+    uint32_t    unlit;          // 4
+    uint32_t    _pad0;          // 4
+    uint32_t    _pad1;          // 4   -> total 128 bytes
 };
+static_assert(sizeof(PushConstants) <= 128, "PushConstants must fit the guaranteed maxPushConstantsSize");
+
+// One element of the instance SSBO read by instanced.vert (std430)
+struct InstanceData {
+    glm::mat4   model;
+    glm::mat3x4 normalMatrix;
+    uint32_t    flags;         // bit 0: unlit
+    uint32_t    _pad[3];
+};
+static_assert(sizeof(InstanceData) == 128, "InstanceData must match instanced.vert");
 
 auto faceUV = [](float S, glm::vec2 uv) { return uv; };
 
@@ -206,16 +352,21 @@ static void DestroyDebugUtilsMessengerEXT(
 
 enum class RenderMode {
     SceneDirect = 0,  // pass 1 only, to swapchain
-    SceneRTT         // pass 1 to offscreen, pass 2 to swapchain
+    SceneRTT,        // pass 1 to offscreen, pass 2 to swapchain
+    SceneCompute     // pass 1 to offscreen, post in compute, blit to swapchain
 };
 
 
 class HelloTriangleApplication {
 public:
+    explicit HelloTriangleApplication(const AppOptions& opts = {}) : options(opts),
+        framesInFlight(opts.framesInFlight ? opts.framesInFlight : profileFramesInFlight(opts.latency)),
+        postEffect(opts.post), vertexEncoding(opts.vertexFormat) {}
     void run();
 
 private:
     // Core
+    AppOptions options;
 
     std::chrono::steady_clock::time_point startTime;
 
@@ -226,11 +377,25 @@ private:
         float pad1;
     };
 
+    // gaussian.frag and the bloom passes; shares the post layout's push range with FirePush
+    struct BlurPush {
+        float texelStepX;
+        float texelStepY;
+        float pad0;
+        float pad1;
+    };
+
     GLFWwindow* window = {};
     bool framebufferResized = false;
     uint32_t currentFrame = 0;
+    // Per-frame resources (command buffers, sync objects, uniform ring regions,
+    // descriptor copies, ...) are sized by this, from the latency profile
+    const uint32_t framesInFlight;
+    VkPresentModeKHR presentMode = VK_PRESENT_MODE_FIFO_KHR;
+    FrameLatency latency;
 
     RenderMode renderMode = RenderMode::SceneRTT;
+    PostEffect postEffect = PostEffect::Glow;
 
 	// Vulkan components
     VkInstance instance = VK_NULL_HANDLE;
@@ -242,69 +407,162 @@ private:
     VkQueue presentQueue = VK_NULL_HANDLE;
     VkCommandPool commandPool = VK_NULL_HANDLE;
 
+    // All buffer/image memory is sub-allocated from here
+    GpuAllocator allocator;
+    // Staging copies + layout transitions, submitted as one batch
+    UploadBatcher uploads;
+    // Seeded from disk at startup, written back once pipelines exist
+    PipelineCache pipelineCache;
+    // CPU workers for decode, other parallel init work and scene recording
+    ThreadPool workers;
+    // Per-thread, per-frame pools of secondaries for the scene pass
+    ParallelRecorder recorder;
+    uint32_t recordThreads = 0;      // 0: per-cube draws go straight into the primary
+
     // Swapchain
     VkSwapchainKHR swapChain = VK_NULL_HANDLE;
     std::vector<VkImage> swapChainImages;
     VkFormat swapChainImageFormat = VK_FORMAT_UNDEFINED;
     VkExtent2D swapChainExtent{ 0,0 };
     std::vector<VkImageView> swapChainImageViews;
-
-    // Depth resources
-    VkImage depthImage;
-    VkDeviceMemory depthImageMemory;
-    VkImageView depthImageView;
+    // Layout the final pass leaves swapChainImages in
+    VkImageLayout presentLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+
+    // Headless: owned images stand in for the swapchain and are cycled in order
+    static constexpr uint32_t HEADLESS_RING_SIZE = 3;
+    std::vector<GpuAllocation> headlessImageMemory;
+    uint32_t headlessFrame = 0;
+    // CPU cost of each drawFrame phase, summed over the headless run
+    struct FrameCpuTimes {
+        double waitMs = 0.0, updateMs = 0.0, recordMs = 0.0, submitMs = 0.0;
+        uint64_t frames = 0;
+    } frameCpu;
+
+    // Per-frame passes and the transient images between them (scene colour,
+    // depth, blur targets, bloom pyramid, compute intermediates)
+    RenderGraph frameGraph;
+    VkFormat depthFormat = VK_FORMAT_UNDEFINED;
+    uint64_t graphGeneration = 0;   // bumped whenever frameGraph reallocates
+    // Old swapchains and graph images, destroyed once the frames using them retire
+    RetireQueue retireQueue;
 
     // Pipeline / descriptors
     VkDescriptorSetLayout descriptorSetLayout = VK_NULL_HANDLE;
     VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
     VkPipeline graphicsPipeline = VK_NULL_HANDLE;
+    VkPipeline instancedPipeline = VK_NULL_HANDLE;   // instanced.vert + shader.frag
 
-    // Texture
-    VkImage textureImage = VK_NULL_HANDLE;
-    VkDeviceMemory textureImageMemory = VK_NULL_HANDLE;
-    VkImageView textureImageView = VK_NULL_HANDLE;
-    VkSampler textureSampler = VK_NULL_HANDLE;
-
-    VkImage textureImage2;
-    VkDeviceMemory textureImageMemory2;
-    VkImageView textureImageView2;
-    VkSampler textureSampler2;
+    // Textures (images + samplers owned by the cache)
+    TextureCache textures;
+    TextureHandle rockTexture = INVALID_TEXTURE;
+    TextureHandle woodTexture = INVALID_TEXTURE;
 
     // Depth format finder
     VkFormat findDepthFormat();
 
-    // --- Offscreen RTT resources (Exercise 1) ---
-    VkImage        offscreenImage;
-    VkDeviceMemory offscreenImageMemory;
-    VkImageView    offscreenImageView;
-    VkSampler      offscreenSampler;
+    // --- Offscreen RTT (Exercise 1): the "scene" graph image, sampled by every post pass ---
+    VkSampler      offscreenSampler = VK_NULL_HANDLE;
+
+    // Bloom pyramid behind glow.frag: a half-res mip chain, blurred by
+    // downsampling to the smallest level and upsampling back, one view per level
+    static constexpr uint32_t BLOOM_LEVELS = 5;
+    std::array<VkExtent2D, BLOOM_LEVELS> bloomExtents{};
 
     // Post-process pipeline + descriptors
     VkPipeline      postPipeline;
+    VkPipeline      boxBlurPipeline = VK_NULL_HANDLE;
+    VkPipeline      gaussianPipeline = VK_NULL_HANDLE;
+    VkPipeline      bloomDownPipeline = VK_NULL_HANDLE;
+    VkPipeline      bloomUpPipeline = VK_NULL_HANDLE;
     VkDescriptorSetLayout postDescriptorSetLayout;
     VkPipelineLayout postPipelineLayout;
-    std::vector<VkDescriptorSet> postDescriptorSets;
 
-    // For cube index rendering
+    // Compute post path (RenderMode::SceneCompute). Targets stay in GENERAL;
+    // the final one is blitted to the swapchain, which can't be a storage image.
+    struct ComputePush {
+        int32_t dirX;
+        int32_t dirY;
+        float time;
+        float intensity;
+    };
+    static constexpr VkFormat COMPUTE_POST_FORMAT = VK_FORMAT_R16G16B16A16_SFLOAT;
+    static constexpr uint32_t BLUR_TILE = 256;        // blur_tiled.comp local_size_x
+    static constexpr int32_t GLOW_BLUR_RADIUS = 24;   // wide kernel feeding glow.comp
+    static constexpr int32_t MAX_BLUR_RADIUS = 64;    // apron blur_tiled.comp's shared tile can hold
+    static constexpr float GLOW_BLUR_SIGMA = 10.0f;
+    bool computePostSupported = false;
+    bool swapChainBlitDst = false;
+    VkDescriptorSetLayout computeDescriptorSetLayout = VK_NULL_HANDLE;
+    VkPipelineLayout computePipelineLayout = VK_NULL_HANDLE;
+    VkPipeline     blurComputePipeline = VK_NULL_HANDLE;
+    VkPipeline     glowBlurComputePipeline = VK_NULL_HANDLE;
+    VkPipeline     glowComputePipeline = VK_NULL_HANDLE;
+
+    // Post and compute sets sample frameGraph images, so there is one copy per
+    // frame in flight: a frame rewrites only its own copy, after its fence,
+    // when the graph has reallocated since it last did.
+    struct GraphSets {
+        VkDescriptorSet post = VK_NULL_HANDLE;   // samples "scene" (+ "bloom")
+        VkDescriptorSet blur = VK_NULL_HANDLE;   // samples "blur" (vertical Gaussian pass)
+        std::array<VkDescriptorSet, BLOOM_LEVELS> bloomDown{};    // [i] samples the source of level i
+        std::array<VkDescriptorSet, BLOOM_LEVELS - 1> bloomUp{};  // [i] samples level i + 1
+        VkDescriptorSet computeBlurH = VK_NULL_HANDLE;
+        VkDescriptorSet computeBlurV = VK_NULL_HANDLE;
+        VkDescriptorSet computeGlow = VK_NULL_HANDLE;
+        uint64_t generation = 0;                 // graphGeneration the views were written from
+    };
+    std::vector<GraphSets> graphSets;
+
+    // Per-pass GPU time, read back from timestamp queries
+    GpuTimer gpuTimer;
+    std::chrono::steady_clock::time_point lastTimingLog;
+    bool traceKeyDown = false;
+
+    // Per-instance model matrices + flags (set 0, binding 3). The CPU copy
+    // feeds the push-constant path when comparing the two.
+    std::vector<InstanceData> instances;
+    VkBuffer instanceBuffer = VK_NULL_HANDLE;
+    GpuAllocation instanceBufferMemory;
+    bool instancedDraw = true;       // stress scene: one instanced draw, else one draw per cube
+    uint32_t sceneDrawCalls = 0;     // draws recorded in the scene pass last frame
+
+    // One index buffer shared by every mesh; each draws from its own range
     VkBuffer indexBuffer = VK_NULL_HANDLE;
-    VkDeviceMemory indexBufferMemory = VK_NULL_HANDLE;
-    uint32_t indexCount = 0;
+    GpuAllocation indexBufferMemory;
+    IndexRange cubeIndices;
+    IndexPacker indexPacker;   // filled by createVertexBuffers, uploaded by createIndexBuffer
 
     // For cube vertices
     VkBuffer vertexBuffer = VK_NULL_HANDLE;
-    VkDeviceMemory vertexBufferMemory = VK_NULL_HANDLE;
+    GpuAllocation vertexBufferMemory;
 
     // Buffers
     VkBuffer cubeVertexBuffer = VK_NULL_HANDLE;
-    VkDeviceMemory cubeVertexBufferMemory = VK_NULL_HANDLE;
-
-    std::vector<VkBuffer> uniformBuffers;
-    std::vector<VkDeviceMemory> uniformBuffersMemory;
-    std::vector<void*> uniformBuffersMapped;
+    GpuAllocation cubeVertexBufferMemory;
+    VertexEncoding vertexEncoding = VertexEncoding::Float32;   // layout of every scene vertex buffer
+    std::vector<Vertex> cubeMesh;   // optimized source, kept so the cube can be re-encoded
+    PositionBounds cubeBounds;      // dequantization for VertexEncoding::Quantized
+
+    // Chunked terrain (--terrain). Tiles are built on the workers and copied
+    // into slots of the streamer's vertex buffer; every tile draws the same
+    // grid indices and shares one set of tile-local bounds.
+    static constexpr float TERRAIN_FLY_SPEED = 6.0f;   // world units per second
+    TerrainSettings terrainSettings;
+    TerrainGrid terrainGrid;
+    TerrainStreamer terrain;
+    IndexRange terrainIndices;
+    PositionBounds terrainBounds;
+    uint32_t terrainUboOffset = 0;
+    glm::vec3 cameraPos{ 0.0f, 1.5f, 3.0f };   // set by updateUniformBuffer
+
+    // Every frame's UBOs, addressed by dynamic offset
+    static constexpr uint32_t UBO_SLICES_PER_FRAME = 4096;
+    UniformRing uniformRing;
+    uint32_t sceneUboOffset = 0;
 
     // Descriptors
     VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
-    std::vector<VkDescriptorSet> descriptorSets;
+    VkDescriptorSet descriptorSet = VK_NULL_HANDLE;   // scene UBO (dynamic) + textures
 
     // Sync
     std::vector<VkCommandBuffer> commandBuffers;
@@ -326,27 +584,33 @@ private:
     void createLogicalDevice();
     void createSwapChain();
     void createImageViews();
-    void createDepthResources();
     void createDescriptorSetLayout();
     void createGraphicsPipeline();
     void createCommandPool();
 
-    void createTextureImage();
-    void createTextureImageView();
-    void createTextureSampler();
+    void createTextures();
 
-    void createTextureImage2();
-    void createTextureImageView2();
-    void createTextureSampler2();
 
-	void createOffscreenResources();
+	void createOffscreenSampler();
 	void createPostDescriptorSetLayout();
 	void createPostDescriptorSets();
+	void updatePostDescriptorSets(uint32_t frame);
 	void createPostPipeline();
+    VkPipeline createFullscreenPipeline(const char* fragPath, const VkSpecializationInfo* spec);
+    int32_t blurRadius(const char* user) const;
+    void createComputePost();
+    VkPipeline createComputePipeline(const char* path, const VkSpecializationInfo* spec);
+    void createComputeDescriptorSets();
+    void updateComputeDescriptorSets(uint32_t frame);
 
     void createVertexBuffers();
+    void uploadVertices(const std::vector<Vertex>& verts, const PositionBounds& bounds, VkBuffer& buf, GpuAllocation& mem);
+    void setVertexEncoding(VertexEncoding encoding);
     void createUniformBuffers();
     void createIndexBuffer();
+    void createInstanceBuffer();
+    void createTerrain();
+    std::vector<unsigned char> buildTerrainTile(int32_t x, int32_t z, VertexEncoding encoding) const;
     void createDescriptorPool();
     void createDescriptorSets();
     void createCommandBuffers();
@@ -354,11 +618,45 @@ private:
 
     // Draw / swapchain
     void drawFrame();
+    void drawHeadlessFrame();
     void recreateSwapChain();
     void cleanupSwapChain();
     void recordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex);
+    void buildFrameGraph(uint32_t imageIndex);
+    void recordScene(VkCommandBuffer cb);
+    void recordPost(VkCommandBuffer cb, uint32_t imageIndex);
+    void bindSceneState(VkCommandBuffer cb, VkPipeline pipeline);
+    void recordSceneDraws(VkCommandBuffer cb, size_t first, size_t count);
+    void recordSceneParallel(VkCommandBuffer cb);
+    void recordTerrain(VkCommandBuffer cb);
+    void recordBloom(VkCommandBuffer cb);
+    void recordComputePass(VkCommandBuffer cb, VkPipeline pipeline, VkDescriptorSet set,
+        uint32_t groupsX, uint32_t groupsY, int32_t dirX, int32_t dirY);
+    void recordFullscreenPass(VkCommandBuffer cb, VkImageView target, VkExtent2D extent, VkPipeline pipeline,
+        VkDescriptorSet set, const void* push, uint32_t pushSize);
+    void recordImageBarrier(VkCommandBuffer cb, VkImage image, uint32_t baseMip, uint32_t mipCount,
+        VkImageLayout oldLayout, VkImageLayout newLayout,
+        VkPipelineStageFlags2 srcStage, VkAccessFlags2 srcAccess,
+        VkPipelineStageFlags2 dstStage, VkAccessFlags2 dstAccess);
     void updateUniformBuffer(uint32_t currentImage);
 
+    // Diagnostics
+    void logMemoryStats(const char* label);
+    void logGpuTimes();
+    void logFrameLatency();
+    void pollFrameLatency();
+    void logTerrainStats();
+    void runAllocatorBenchmark();
+    void runPostBenchmark();
+    void runHeadless();
+    void runInstancingBenchmark();
+    void runNormalMatrixBenchmark();
+    void runRecordingBenchmark();
+    void runVertexFormatBenchmark();
+    void runTerrainBenchmark();
+    void dumpTrace();
+    void writeFramePng(VkImage image, const std::string& path);
+
     // Helpers
     void populateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT& createInfo);
     bool isDeviceSuitable(VkPhysicalDevice device);
@@ -373,20 +671,20 @@ private:
     static std::vector<char> readFile(const std::string& filename);
     VkShaderModule createShaderModule(const std::vector<char>& code);
     void createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties,
-        VkBuffer& buffer, VkDeviceMemory& bufferMemory);
-    void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
-    uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
+        VkBuffer& buffer, GpuAllocation& bufferMemory, AllocStrategy strategy = AllocStrategy::Buddy);
+    void copyBuffer(VkBuffer srcBuffer, VkDeviceSize srcOffset, VkBuffer dstBuffer, VkDeviceSize size);
 
-    VkImageView createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectMask);
+    VkImageView createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectMask,
+        uint32_t mipLevels = 1, uint32_t baseMipLevel = 0);
     void createImage(uint32_t w, uint32_t h, VkFormat fmt, VkImageTiling tiling,
-        VkImageUsageFlags usage, VkMemoryPropertyFlags props, VkImage& image, VkDeviceMemory& memory);
-
-    VkCommandBuffer beginSingleTimeCommands();
-    void endSingleTimeCommands(VkCommandBuffer);
+        VkImageUsageFlags usage, VkMemoryPropertyFlags props, VkImage& image, GpuAllocation& memory,
+        uint32_t mipLevels = 1);
 
+    // Recorded into the upload batch; nothing runs until uploads.flush()
     void transitionImageLayout(VkImage image, VkFormat format,
-        VkImageLayout oldLayout, VkImageLayout newLayout, VkImageAspectFlags aspectMask);
-    void copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t w, uint32_t h);
+        VkImageLayout oldLayout, VkImageLayout newLayout, VkImageAspectFlags aspectMask,
+        uint32_t mipLevels = 1);
+    void copyBufferToImage(VkBuffer buffer, VkDeviceSize offset, VkImage image, uint32_t w, uint32_t h);
 
     static void framebufferResizeCallback(GLFWwindow* window, int width, int height);
     static VKAPI_ATTR VkBool32 VKAPI_CALL debugCallback(
@@ -400,10 +698,19 @@ private:
 // --- Implementation --------------------------------------------------------
 
 void HelloTriangleApplication::run() {
-    initWindow();
+    if (options.benchNormals) { runNormalMatrixBenchmark(); return; }
+    if (!options.headless) initWindow();
     initVulkan();
-    mainLoop();
+    if (options.benchAllocator) runAllocatorBenchmark();
+    else if (options.benchPost) runPostBenchmark();
+    else if (options.benchInstancing) runInstancingBenchmark();
+    else if (options.benchRecording) runRecordingBenchmark();
+    else if (options.benchVertexFormats) runVertexFormatBenchmark();
+    else if (options.benchTerrain) runTerrainBenchmark();
+    else if (options.headless) runHeadless();
+    else mainLoop();
     cleanup();
+    if (!options.trace.empty()) dumpTrace();
 }
 
 void HelloTriangleApplication::initWindow() {
@@ -416,48 +723,78 @@ void HelloTriangleApplication::initWindow() {
 }
 
 void HelloTriangleApplication::initVulkan() {
-    STEP("createInstance");        createInstance();
-    STEP("setupDebugMessenger");   setupDebugMessenger();
-    STEP("createSurface");         createSurface();
-    STEP("pickPhysicalDevice");    pickPhysicalDevice();
-    STEP("createLogicalDevice");   createLogicalDevice();
-
-    STEP("createSwapChain");       createSwapChain();
-    STEP("createImageViews");      createImageViews();
-    STEP("createDescriptorSetLayout"); createDescriptorSetLayout();
-    STEP("createGraphicsPipeline"); createGraphicsPipeline();
-    STEP("createCommandPool");     createCommandPool();
-    STEP("createDepthResources");  createDepthResources();
-
-    STEP("createTextureImage");    createTextureImage();
-    STEP("createTextureImageView"); createTextureImageView();
-    STEP("createTextureSampler");  createTextureSampler();
-
-    STEP("createTextureImage2");    createTextureImage2();
-    STEP("createTextureImageView2"); createTextureImageView2();
-    STEP("createTextureSampler2");  createTextureSampler2();
-
-    STEP("createOffScreenResources"); createOffscreenResources();
-    STEP("createPostDescriptorSetLayout"); createPostDescriptorSetLayout();
-    STEP("createPostPipeline"); createPostPipeline();
+    PROFILE_SCOPE("initVulkan");
+    auto initStart = std::chrono::steady_clock::now();
+
+    STAGE("createInstance", createInstance());
+    STAGE("setupDebugMessenger", setupDebugMessenger());
+    if (!options.headless) STAGE("createSurface", createSurface());
+    STAGE("pickPhysicalDevice", pickPhysicalDevice());
+    STAGE("createLogicalDevice", createLogicalDevice());
+
+    STAGE("createSwapChain", createSwapChain());
+    STAGE("createImageViews", createImageViews());
+    STAGE("createDescriptorSetLayout", createDescriptorSetLayout());
+    STEP("pipelineCache (" << (pipelineCache.isWarm() ? "warm" : "cold")
+        << (pipelineCache.whyCold().empty() ? "" : ": " + pipelineCache.whyCold()) << ")");
+    auto pipeStart = std::chrono::steady_clock::now();
+    STAGE("createGraphicsPipeline", createGraphicsPipeline());
+    double pipeMs = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - pipeStart).count();
+    STAGE("createCommandPool", createCommandPool());
+
+    STAGE("createTextures", createTextures());
+
+    STAGE("createOffscreenSampler", createOffscreenSampler());
+    STAGE("createPostDescriptorSetLayout", createPostDescriptorSetLayout());
+    pipeStart = std::chrono::steady_clock::now();
+    STAGE("createPostPipeline", createPostPipeline());
+    STAGE("createComputePost", createComputePost());
+    pipeMs += std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - pipeStart).count();
+    STEP("pipelines built in " << pipeMs << " ms ("
+        << (pipelineCache.isWarm() ? "warm" : "cold") << " cache)");
+    if (!pipelineCache.save())
+        STEP("pipelineCache: could not write " << PipelineCache::DEFAULT_PATH);
 
     STEP("build geometry");
 
-    STEP("createVertexBuffers");   createVertexBuffers();
-    STEP("createUniformBuffers");  createUniformBuffers();
-
-    STEP("createDescriptorPool");  createDescriptorPool();
-    STEP("createDescriptorSets");  createDescriptorSets();
-    STEP("createPostDescriptorSets"); createPostDescriptorSets();
-    STEP("createIndexBuffer"); createIndexBuffer();
+    STAGE("createVertexBuffers", createVertexBuffers());
+    STAGE("createUniformBuffers", createUniformBuffers());
+    STAGE("createInstanceBuffer", createInstanceBuffer());
+    STAGE("createTerrain", createTerrain());
+
+    STAGE("createDescriptorPool", createDescriptorPool());
+    STAGE("createDescriptorSets", createDescriptorSets());
+    STAGE("createPostDescriptorSets", createPostDescriptorSets());
+    STAGE("createComputeDescriptorSets", createComputeDescriptorSets());
+    STAGE("createIndexBuffer", createIndexBuffer());
+    STAGE("flush uploads", uploads.flush());
+
+    STAGE("createCommandBuffers", createCommandBuffers());
+    STAGE("createSyncObjects", createSyncObjects());
+    logMemoryStats("after init");
+
+    const UploadBatcher::Stats& up = uploads.getStats();
+    STEP("uploads: " << up.copies << " copies + " << up.transitions << " transitions ("
+        << up.stagedBytes / 1024 << " KiB) in " << up.submits << " submit(s), " << up.waits
+        << " wait(s); per-op path would need " << up.legacySubmits() << " submits + "
+        << up.legacySubmits() << " queue waits");
+    double initMs = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - initStart).count();
+    STEP("initVulkan took " << initMs << " ms");
+
+    if (options.computePost) {
+        if (computePostSupported) renderMode = RenderMode::SceneCompute;
+        else STEP("compute post path unavailable on this device; staying on the fragment path");
+    }
 
-    STEP("createCommandBuffers");  createCommandBuffers();
-    STEP("createSyncObjects");     createSyncObjects();
     startTime = std::chrono::steady_clock::now();
 }
 
 
 void HelloTriangleApplication::mainLoop() {
+    lastTimingLog = std::chrono::steady_clock::now();
     while (!glfwWindowShouldClose(window)) {
         glfwPollEvents();
 
@@ -468,67 +805,113 @@ void HelloTriangleApplication::mainLoop() {
         //if (glfwGetKey(window, GLFW_KEY_2) == GLFW_PRESS) {
         //    renderMode = RenderMode::SceneRTT;      // both passes (RTT)
         //}
+        if (glfwGetKey(window, GLFW_KEY_3) == GLFW_PRESS) postEffect = PostEffect::Glow;
+        if (glfwGetKey(window, GLFW_KEY_4) == GLFW_PRESS) postEffect = PostEffect::BoxBlur;
+        if (glfwGetKey(window, GLFW_KEY_5) == GLFW_PRESS) postEffect = PostEffect::Gaussian;
+        if (glfwGetKey(window, GLFW_KEY_6) == GLFW_PRESS) renderMode = RenderMode::SceneRTT;
+        if (glfwGetKey(window, GLFW_KEY_7) == GLFW_PRESS && computePostSupported)
+            renderMode = RenderMode::SceneCompute;
+
+        // I / P: stress scene drawn instanced or with per-cube push constants
+        if (glfwGetKey(window, GLFW_KEY_I) == GLFW_PRESS) instancedDraw = true;
+        if (glfwGetKey(window, GLFW_KEY_P) == GLFW_PRESS) instancedDraw = false;
+
+        // T: write the CPU trace so far (once per press)
+        bool traceKey = glfwGetKey(window, GLFW_KEY_T) == GLFW_PRESS;
+        if (traceKey && !traceKeyDown && !options.trace.empty()) dumpTrace();
+        traceKeyDown = traceKey;
 
         drawFrame();
+
+        auto now = std::chrono::steady_clock::now();
+        if (now - lastTimingLog > std::chrono::seconds(5)) {
+            lastTimingLog = now;
+            logGpuTimes();
+            logFrameLatency();
+            logTerrainStats();
+        }
     }
     vkDeviceWaitIdle(device);
+    logGpuTimes();
+    logFrameLatency();
+    logTerrainStats();
 }
 
 
 void HelloTriangleApplication::cleanup() {
+    vkDeviceWaitIdle(device);
+    retireQueue.flush();
     cleanupSwapChain();
 
     vkDestroyPipeline(device, graphicsPipeline, nullptr);
+    vkDestroyPipeline(device, instancedPipeline, nullptr);
     vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
     vkDestroyDescriptorSetLayout(device, descriptorSetLayout, nullptr);
 
-    vkDestroySampler(device, textureSampler, nullptr);
-    vkDestroyImageView(device, textureImageView, nullptr);
-    vkDestroyImage(device, textureImage, nullptr);
-    vkFreeMemory(device, textureImageMemory, nullptr);
-
-    vkDestroySampler(device, textureSampler2, nullptr);
-    vkDestroyImageView(device, textureImageView2, nullptr);
-    vkDestroyImage(device, textureImage2, nullptr);
-    vkFreeMemory(device, textureImageMemory2, nullptr);
+    textures.destroy();
 
     // offscreen RTT
     vkDestroySampler(device, offscreenSampler, nullptr);
 
     // post pipeline
     vkDestroyPipeline(device, postPipeline, nullptr);
+    vkDestroyPipeline(device, boxBlurPipeline, nullptr);
+    vkDestroyPipeline(device, gaussianPipeline, nullptr);
+    vkDestroyPipeline(device, bloomDownPipeline, nullptr);
+    vkDestroyPipeline(device, bloomUpPipeline, nullptr);
     vkDestroyPipelineLayout(device, postPipelineLayout, nullptr);
     vkDestroyDescriptorSetLayout(device, postDescriptorSetLayout, nullptr);
 
+    // compute post path
+    vkDestroyPipeline(device, blurComputePipeline, nullptr);
+    vkDestroyPipeline(device, glowBlurComputePipeline, nullptr);
+    vkDestroyPipeline(device, glowComputePipeline, nullptr);
+    vkDestroyPipelineLayout(device, computePipelineLayout, nullptr);
+    vkDestroyDescriptorSetLayout(device, computeDescriptorSetLayout, nullptr);
+
+    frameGraph.destroy();
 
     if (cubeVertexBuffer) {
         vkDestroyBuffer(device, cubeVertexBuffer, nullptr);
-        vkFreeMemory(device, cubeVertexBufferMemory, nullptr);
+        allocator.free(cubeVertexBufferMemory);
     }
-
-    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-        vkDestroyBuffer(device, uniformBuffers[i], nullptr);
-        vkFreeMemory(device, uniformBuffersMemory[i], nullptr);
+    if (indexBuffer) {
+        vkDestroyBuffer(device, indexBuffer, nullptr);
+        allocator.free(indexBufferMemory);
+    }
+    if (instanceBuffer) {
+        vkDestroyBuffer(device, instanceBuffer, nullptr);
+        allocator.free(instanceBufferMemory);
     }
+    terrain.destroy();
+
+    uniformRing.destroy();
     vkDestroyDescriptorPool(device, descriptorPool, nullptr);
 
-    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+    for (size_t i = 0; i < framesInFlight; i++) {
         vkDestroySemaphore(device, renderFinishedSemaphores[i], nullptr);
         vkDestroySemaphore(device, imageAvailableSemaphores[i], nullptr);
         vkDestroyFence(device, inFlightFences[i], nullptr);
     }
 
+    recorder.destroy();
     vkDestroyCommandPool(device, commandPool, nullptr);
+    gpuTimer.destroy();
+    uploads.destroy();
+    pipelineCache.destroy();
+    allocator.destroy();
     vkDestroyDevice(device, nullptr);
 
     if (enableValidationLayers) {
         DestroyDebugUtilsMessengerEXT(instance, debugMessenger, nullptr);
     }
-    vkDestroySurfaceKHR(instance, surface, nullptr);
+    if (surface) vkDestroySurfaceKHR(instance, surface, nullptr);
     vkDestroyInstance(instance, nullptr);
 
-    glfwDestroyWindow(window);
-    glfwTerminate();
+    if (window) {
+        glfwDestroyWindow(window);
+        glfwTerminate();
+    }
 }
 
 // --- Vulkan setup (mostly identical to your version) -----------------------
@@ -609,9 +992,12 @@ bool HelloTriangleApplication::checkValidationLayerSupport() {
     return true;
 }
 std::vector<const char*> HelloTriangleApplication::getRequiredExtensions() {
-    uint32_t glfwExtensionCount = 0;
-    const char** glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
-    std::vector<const char*> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
+    std::vector<const char*> extensions;
+    if (!options.headless) {
+        uint32_t glfwExtensionCount = 0;
+        const char** glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+        extensions.assign(glfwExtensions, glfwExtensions + glfwExtensionCount);
+    }
     if (enableValidationLayers) extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
     
     #ifdef __APPLE__
@@ -641,6 +1027,12 @@ QueueFamilyIndices HelloTriangleApplication::findQueueFamilies(VkPhysicalDevice
     vkGetPhysicalDeviceQueueFamilyProperties(dev, &count, qf.data());
     for (uint32_t i = 0; i < count; i++) {
         if (qf[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) indices.graphicsFamily = i;
+        if (options.headless) {
+            // nothing is presented; the graphics queue stands in
+            indices.presentFamily = indices.graphicsFamily;
+            if (indices.isComplete()) break;
+            continue;
+        }
         VkBool32 presentSupport = VK_FALSE;
         vkGetPhysicalDeviceSurfaceSupportKHR(dev, i, surface, &presentSupport);
         if (presentSupport) indices.presentFamily = i;
@@ -652,6 +1044,7 @@ bool HelloTriangleApplication::checkDeviceExtensionSupport(VkPhysicalDevice dev)
     uint32_t extensionCount = 0; vkEnumerateDeviceExtensionProperties(dev, nullptr, &extensionCount, nullptr);
     std::vector<VkExtensionProperties> exts(extensionCount);
     vkEnumerateDeviceExtensionProperties(dev, nullptr, &extensionCount, exts.data());
+    if (options.headless) return true;
     std::set<std::string> required(deviceExtensions.begin(), deviceExtensions.end());
     for (auto& e : exts) required.erase(e.extensionName);
     return required.empty();
@@ -671,8 +1064,10 @@ bool HelloTriangleApplication::isDeviceSuitable(VkPhysicalDevice dev) {
     if (!indices.isComplete()) return false;
     if (!checkDeviceExtensionSupport(dev)) return false;
 
-    SwapChainSupportDetails sc = querySwapChainSupport(dev);
-    if (sc.formats.empty() || sc.presentModes.empty()) return false;
+    if (!options.headless) {
+        SwapChainSupportDetails sc = querySwapChainSupport(dev);
+        if (sc.formats.empty() || sc.presentModes.empty()) return false;
+    }
 
     VkPhysicalDeviceDynamicRenderingFeatures drf{};
     drf.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES;
@@ -713,6 +1108,12 @@ void HelloTriangleApplication::createLogicalDevice() {
     f2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
     f2.pNext = &drf;
     f2.features.samplerAnisotropy = VK_TRUE;
+    // optional: per-pass vertex/fragment/compute counters in GpuTimer. The scene
+    // scope can wrap secondaries, so its statistics query must be inheritable.
+    VkPhysicalDeviceFeatures available{};
+    vkGetPhysicalDeviceFeatures(physicalDevice, &available);
+    f2.features.inheritedQueries = available.inheritedQueries;
+    f2.features.pipelineStatisticsQuery = available.pipelineStatisticsQuery && available.inheritedQueries;
 
     VkDeviceCreateInfo ci{};
     ci.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -720,8 +1121,10 @@ void HelloTriangleApplication::createLogicalDevice() {
     ci.queueCreateInfoCount = (uint32_t)qinfos.size();
     ci.pQueueCreateInfos = qinfos.data();
     ci.pEnabledFeatures = nullptr;
-    ci.enabledExtensionCount = (uint32_t)deviceExtensions.size();
-    ci.ppEnabledExtensionNames = deviceExtensions.data();
+    if (!options.headless) {
+        ci.enabledExtensionCount = (uint32_t)deviceExtensions.size();
+        ci.ppEnabledExtensionNames = deviceExtensions.data();
+    }
     if (enableValidationLayers) {
         ci.enabledLayerCount = (uint32_t)validationLayers.size();
         ci.ppEnabledLayerNames = validationLayers.data();
@@ -732,6 +1135,14 @@ void HelloTriangleApplication::createLogicalDevice() {
 
     vkGetDeviceQueue(device, idx.graphicsFamily.value(), 0, &graphicsQueue);
     vkGetDeviceQueue(device, idx.presentFamily.value(), 0, &presentQueue);
+
+    allocator.init(physicalDevice, device);
+    frameGraph.init(device, allocator);
+    retireQueue.init(framesInFlight);
+    frameGraph.setRetire([this](std::function<void()> destroy) { retireQueue.defer(std::move(destroy)); });
+    pipelineCache.init(physicalDevice, device);
+    gpuTimer.init(physicalDevice, device, idx.graphicsFamily.value(), framesInFlight,
+        f2.features.pipelineStatisticsQuery == VK_TRUE);
 }
 VkSurfaceFormatKHR HelloTriangleApplication::chooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& af) {
     for (auto& f : af) {
@@ -740,8 +1151,17 @@ VkSurfaceFormatKHR HelloTriangleApplication::chooseSwapSurfaceFormat(const std::
     }
     return af[0];
 }
+// First mode the surface offers from the latency profile's preference list;
+// FIFO is always supported and ends every list.
 VkPresentModeKHR HelloTriangleApplication::chooseSwapPresentMode(const std::vector<VkPresentModeKHR>& ap) {
-    for (auto& p : ap) if (p == VK_PRESENT_MODE_MAILBOX_KHR) return p;
+    std::vector<VkPresentModeKHR> prefer;
+    switch (options.latency) {
+    case LatencyProfile::LowLatency: prefer = { VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_IMMEDIATE_KHR }; break;
+    case LatencyProfile::Balanced:   prefer = { VK_PRESENT_MODE_MAILBOX_KHR }; break;
+    case LatencyProfile::Throughput: break;
+    }
+    for (VkPresentModeKHR want : prefer)
+        if (std::find(ap.begin(), ap.end(), want) != ap.end()) return want;
     return VK_PRESENT_MODE_FIFO_KHR;
 }
 VkExtent2D HelloTriangleApplication::chooseSwapExtent(const VkSurfaceCapabilitiesKHR& caps) {
@@ -753,9 +1173,32 @@ VkExtent2D HelloTriangleApplication::chooseSwapExtent(const VkSurfaceCapabilitie
     return e;
 }
 void HelloTriangleApplication::createSwapChain() {
+    if (options.headless) {
+        // Same role as the swapchain images: colour target of the final pass,
+        // blit destination for the compute path, copy source for --output.
+        swapChainImageFormat = VK_FORMAT_R8G8B8A8_SRGB;
+        swapChainExtent = { options.width, options.height };
+        STEP("latency profile " << profileName(options.latency) << ": " << framesInFlight
+            << " frame(s) in flight, headless (no present)");
+        swapChainBlitDst = true;
+        presentLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        swapChainImages.resize(HEADLESS_RING_SIZE);
+        headlessImageMemory.resize(HEADLESS_RING_SIZE);
+        for (uint32_t i = 0; i < HEADLESS_RING_SIZE; i++) {
+            createImage(swapChainExtent.width, swapChainExtent.height, swapChainImageFormat, VK_IMAGE_TILING_OPTIMAL,
+                VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, swapChainImages[i], headlessImageMemory[i]);
+        }
+        return;
+    }
+
     auto sup = querySwapChainSupport(physicalDevice);
     auto fmt = chooseSwapSurfaceFormat(sup.formats);
     auto pm = chooseSwapPresentMode(sup.presentModes);
+    if (pm != presentMode || swapChain == VK_NULL_HANDLE)
+        STEP("latency profile " << profileName(options.latency) << ": " << framesInFlight
+            << " frame(s) in flight, present mode " << presentModeName(pm));
+    presentMode = pm;
     auto ext = chooseSwapExtent(sup.capabilities);
 
     uint32_t imageCount = sup.capabilities.minImageCount + 1;
@@ -771,6 +1214,9 @@ void HelloTriangleApplication::createSwapChain() {
     ci.imageExtent = ext;
     ci.imageArrayLayers = 1;
     ci.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+    // the compute post path blits its result in
+    swapChainBlitDst = (sup.capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_DST_BIT) != 0;
+    if (swapChainBlitDst) ci.imageUsage |= VK_IMAGE_USAGE_TRANSFER_DST_BIT;
 
     QueueFamilyIndices idx = findQueueFamilies(physicalDevice);
     uint32_t qidx[] = { idx.graphicsFamily.value(), idx.presentFamily.value() };
@@ -786,6 +1232,9 @@ void HelloTriangleApplication::createSwapChain() {
     ci.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
     ci.presentMode = pm;
     ci.clipped = VK_TRUE;
+    // on recreation the old swapchain hands its resources over; its images
+    // stay valid for the frames still presenting them
+    ci.oldSwapchain = swapChain;
 
     if (vkCreateSwapchainKHR(device, &ci, nullptr, &swapChain) != VK_SUCCESS)
         throw std::runtime_error("Failed to create swapchain");
@@ -821,57 +1270,10 @@ VkFormat HelloTriangleApplication::findDepthFormat() {
     throw std::runtime_error("failed to find supported depth format!");
 }
 
-void HelloTriangleApplication::createDepthResources() {
-    VkFormat depthFormat = findDepthFormat();
-
-    createImage(
-        swapChainExtent.width,
-        swapChainExtent.height,
-        depthFormat,
-        VK_IMAGE_TILING_OPTIMAL,
-        VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
-        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-        depthImage,
-        depthImageMemory
-    );
-
-    depthImageView = createImageView(
-        depthImage,
-        depthFormat,
-        VK_IMAGE_ASPECT_DEPTH_BIT
-    );
-
-    transitionImageLayout(
-        depthImage,
-        depthFormat,
-        VK_IMAGE_LAYOUT_UNDEFINED,
-        VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL,
-        VK_IMAGE_ASPECT_DEPTH_BIT
-    );
-}
-
-void HelloTriangleApplication::createOffscreenResources() {
-    // Use the swapchain's format (exercise requirement)
-    VkFormat offscreenFormat = swapChainImageFormat;
-
-    createImage(
-        swapChainExtent.width,
-        swapChainExtent.height,
-        offscreenFormat,
-        VK_IMAGE_TILING_OPTIMAL,
-        VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT |
-        VK_IMAGE_USAGE_SAMPLED_BIT,
-        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-        offscreenImage,
-        offscreenImageMemory
-    );
-
-    offscreenImageView = createImageView(
-        offscreenImage,
-        offscreenFormat,
-        VK_IMAGE_ASPECT_COLOR_BIT
-    );
-
+// The scene, blur, bloom and compute targets themselves are transients of
+// frameGraph; only the sampler they are read through lives here.
+void HelloTriangleApplication::createOffscreenSampler() {
+    // Linear filtering is what lets the Gaussian merge two taps into one fetch
     VkSamplerCreateInfo info{};
     info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
     info.magFilter = VK_FILTER_LINEAR;
@@ -879,18 +1281,16 @@ void HelloTriangleApplication::createOffscreenResources() {
     info.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
     info.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
     info.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-    vkCreateSampler(device, &info, nullptr, &offscreenSampler);
-
+    if (vkCreateSampler(device, &info, nullptr, &offscreenSampler) != VK_SUCCESS)
+        throw std::runtime_error("failed to create offscreen sampler");
 }
 
-
-
 void HelloTriangleApplication::createDescriptorSetLayout() {
-    // binding 0 = UBO
+    // binding 0 = UBO, a slice of uniformRing picked by dynamic offset
     VkDescriptorSetLayoutBinding ubo{};
     ubo.binding = 0;
     ubo.descriptorCount = 1;
-    ubo.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    ubo.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
     ubo.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
 
     // binding 1 = first texture (coin)
@@ -907,7 +1307,14 @@ void HelloTriangleApplication::createDescriptorSetLayout() {
     tex2.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
     tex2.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
 
-    std::array<VkDescriptorSetLayoutBinding, 3> bindings{ ubo, tex1, tex2 };
+    // binding 3 = per-instance data (instanced.vert)
+    VkDescriptorSetLayoutBinding inst{};
+    inst.binding = 3;
+    inst.descriptorCount = 1;
+    inst.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    inst.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+
+    std::array<VkDescriptorSetLayoutBinding, 4> bindings{ ubo, tex1, tex2, inst };
 
     VkDescriptorSetLayoutCreateInfo info{};
     info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
@@ -920,12 +1327,7 @@ void HelloTriangleApplication::createDescriptorSetLayout() {
 }
 
 void HelloTriangleApplication::createPostDescriptorSetLayout() {
-    // binding 0 — UBO (not actually used in glow.frag, but harmless)
-    VkDescriptorSetLayoutBinding ubo{};
-    ubo.binding = 0;
-    ubo.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-    ubo.descriptorCount = 1;
-    ubo.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+    // no binding 0: the fullscreen passes take no UBO, only push constants
 
     // binding 1 — the offscreen sharp scene texture
     VkDescriptorSetLayoutBinding sceneTex{};
@@ -934,7 +1336,14 @@ void HelloTriangleApplication::createPostDescriptorSetLayout() {
     sceneTex.descriptorCount = 1;
     sceneTex.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
 
-    std::array<VkDescriptorSetLayoutBinding, 2> bindings{ ubo, sceneTex };
+    // binding 2 — the blurred bloom pyramid (glow.frag only)
+    VkDescriptorSetLayoutBinding bloomTex{};
+    bloomTex.binding = 2;
+    bloomTex.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    bloomTex.descriptorCount = 1;
+    bloomTex.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+    std::array<VkDescriptorSetLayoutBinding, 2> bindings{ sceneTex, bloomTex };
 
     VkDescriptorSetLayoutCreateInfo ci{};
     ci.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
@@ -947,64 +1356,151 @@ void HelloTriangleApplication::createPostDescriptorSetLayout() {
 
 
 void HelloTriangleApplication::createPostDescriptorSets() {
-    postDescriptorSets.resize(MAX_FRAMES_IN_FLIGHT);
-
-    std::vector<VkDescriptorSetLayout> layouts(
-        MAX_FRAMES_IN_FLIGHT, postDescriptorSetLayout
-    );
+    graphSets.resize(framesInFlight);
+    // post + blur, then the bloom sets: per pyramid level, per frame in flight
+    const uint32_t perFrame = 2 + BLOOM_LEVELS + (BLOOM_LEVELS - 1);
+    std::vector<VkDescriptorSetLayout> layouts(perFrame, postDescriptorSetLayout);
+    std::vector<VkDescriptorSet> sets(perFrame);
 
     VkDescriptorSetAllocateInfo ai{};
     ai.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
     ai.descriptorPool = descriptorPool;
-    ai.descriptorSetCount = MAX_FRAMES_IN_FLIGHT;
+    ai.descriptorSetCount = (uint32_t)layouts.size();
     ai.pSetLayouts = layouts.data();
 
-    if (vkAllocateDescriptorSets(device, &ai, postDescriptorSets.data()) != VK_SUCCESS)
-        throw std::runtime_error("failed to allocate post descriptor sets");
-
-    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-
-        VkDescriptorBufferInfo buf{};
-        buf.buffer = uniformBuffers[i];
-        buf.offset = 0;
-        buf.range = sizeof(UniformBufferObject);
-
-        VkDescriptorImageInfo sceneTex{};
-        sceneTex.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-        sceneTex.imageView = offscreenImageView;
-        sceneTex.sampler = offscreenSampler;
-
-        std::array<VkWriteDescriptorSet, 2> writes{};
-
-        // binding 0 → UBO
-        writes[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        writes[0].dstSet = postDescriptorSets[i];
-        writes[0].dstBinding = 0;
-        writes[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-        writes[0].descriptorCount = 1;
-        writes[0].pBufferInfo = &buf;
-
-        // binding 1 → scene (sharp RTT)
-        writes[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        writes[1].dstSet = postDescriptorSets[i];
-        writes[1].dstBinding = 1;
-        writes[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-        writes[1].descriptorCount = 1;
-        writes[1].pImageInfo = &sceneTex;
-
-        vkUpdateDescriptorSets(
-            device,
-            (uint32_t)writes.size(),
-            writes.data(),
-            0, nullptr
-        );
+    for (GraphSets& g : graphSets) {
+        if (vkAllocateDescriptorSets(device, &ai, sets.data()) != VK_SUCCESS)
+            throw std::runtime_error("failed to allocate post descriptor sets");
+        g.post = sets[0];
+        g.blur = sets[1];
+        std::copy(sets.begin() + 2, sets.begin() + 2 + BLOOM_LEVELS, g.bloomDown.begin());
+        std::copy(sets.begin() + 2 + BLOOM_LEVELS, sets.end(), g.bloomUp.begin());
+    }
+}
+
+// Points `frame`'s post sets at the current frameGraph images. Views of
+// images the current post path doesn't use don't exist, and the bindings
+// that would sample them are left as they are.
+void HelloTriangleApplication::updatePostDescriptorSets(uint32_t frame) {
+    const GraphSets& g = graphSets[frame];
+    const VkImageView scene = frameGraph.view("scene");
+    const VkImageView blur = frameGraph.view("blur");
+    const VkImageView bloom0 = frameGraph.view("bloom", 0);
+
+    std::vector<VkDescriptorImageInfo> infos;
+    std::vector<VkWriteDescriptorSet> writes;
+    infos.reserve(3 + BLOOM_LEVELS * 2);
+    auto sample = [&](VkDescriptorSet set, uint32_t binding, VkImageView view) {
+        if (view == VK_NULL_HANDLE) return;
+        VkDescriptorImageInfo info{};
+        info.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        info.imageView = view;
+        info.sampler = offscreenSampler;
+        infos.push_back(info);
+
+        VkWriteDescriptorSet w{};
+        w.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        w.dstSet = set;
+        w.dstBinding = binding;
+        w.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        w.descriptorCount = 1;
+        w.pImageInfo = &infos.back();
+        writes.push_back(w);
+    };
+
+    // binding 1 → scene (sharp RTT), binding 2 → top of the bloom pyramid
+    sample(g.post, 1, scene);
+    sample(g.post, 2, bloom0);
+    // same bindings, sampling the horizontal Gaussian result instead
+    sample(g.blur, 1, blur);
+
+    // Bloom passes only read binding 1: the scene or the neighbouring level
+    if (bloom0 != VK_NULL_HANDLE) {
+        for (uint32_t level = 0; level < BLOOM_LEVELS; level++)
+            sample(g.bloomDown[level], 1, level == 0 ? scene : frameGraph.view("bloom", level - 1));
+        for (uint32_t level = 0; level + 1 < BLOOM_LEVELS; level++)
+            sample(g.bloomUp[level], 1, frameGraph.view("bloom", level + 1));
     }
+
+    if (!writes.empty())
+        vkUpdateDescriptorSets(device, (uint32_t)writes.size(), writes.data(), 0, nullptr);
 }
 
+void HelloTriangleApplication::createComputeDescriptorSets() {
+    std::array<VkDescriptorSetLayout, 3> layouts;
+    layouts.fill(computeDescriptorSetLayout);
+    std::array<VkDescriptorSet, 3> sets{};
 
+    VkDescriptorSetAllocateInfo ai{};
+    ai.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    ai.descriptorPool = descriptorPool;
+    ai.descriptorSetCount = (uint32_t)layouts.size();
+    ai.pSetLayouts = layouts.data();
+    for (GraphSets& g : graphSets) {
+        if (vkAllocateDescriptorSets(device, &ai, sets.data()) != VK_SUCCESS)
+            throw std::runtime_error("failed to allocate compute post descriptor sets");
+        g.computeBlurH = sets[0];
+        g.computeBlurV = sets[1];
+        g.computeGlow = sets[2];
+    }
+}
 
+// A set is only written when every image it names is live this frame.
+void HelloTriangleApplication::updateComputeDescriptorSets(uint32_t frame) {
+    const GraphSets& g = graphSets[frame];
+    auto sampled = [&](VkImageView view, VkImageLayout layout) {
+        VkDescriptorImageInfo info{};
+        info.sampler = offscreenSampler;
+        info.imageView = view;
+        info.imageLayout = layout;
+        return info;
+    };
+    auto storage = [](VkImageView view) {
+        VkDescriptorImageInfo info{};
+        info.imageView = view;
+        info.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+        return info;
+    };
 
+    const VkImageView scene = frameGraph.view("scene");
+    const VkImageView temp = frameGraph.view("compute temp");
+    const VkImageView blur = frameGraph.view("compute blur");
+    const VkImageView out = frameGraph.view("compute out");
+
+    // blur H: scene -> temp, blur V: temp -> blur, glow: blur + scene -> out
+    std::array<VkDescriptorImageInfo, 7> infos{
+        sampled(scene, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL), storage(temp),
+        sampled(temp, VK_IMAGE_LAYOUT_GENERAL), storage(blur),
+        sampled(blur, VK_IMAGE_LAYOUT_GENERAL),
+        sampled(scene, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL), storage(out),
+    };
+    struct { VkDescriptorSet set; uint32_t binding; } targets[7] = {
+        { g.computeBlurH, 0 }, { g.computeBlurH, 2 },
+        { g.computeBlurV, 0 }, { g.computeBlurV, 2 },
+        { g.computeGlow, 0 }, { g.computeGlow, 1 }, { g.computeGlow, 2 },
+    };
 
+    std::vector<VkWriteDescriptorSet> writes;
+    for (size_t i = 0; i < infos.size(); i++) {
+        // skip the whole set if any of its images is missing
+        bool complete = true;
+        for (size_t j = 0; j < infos.size(); j++)
+            if (targets[j].set == targets[i].set && infos[j].imageView == VK_NULL_HANDLE) complete = false;
+        if (!complete) continue;
+
+        VkWriteDescriptorSet w{};
+        w.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        w.dstSet = targets[i].set;
+        w.dstBinding = targets[i].binding;
+        w.descriptorType = targets[i].binding == 2 ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE
+            : VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        w.descriptorCount = 1;
+        w.pImageInfo = &infos[i];
+        writes.push_back(w);
+    }
+    if (!writes.empty())
+        vkUpdateDescriptorSets(device, (uint32_t)writes.size(), writes.data(), 0, nullptr);
+}
 
 void HelloTriangleApplication::createGraphicsPipeline() {
     auto vertShaderCode = readFile("shaders/vert.spv");
@@ -1026,8 +1522,21 @@ void HelloTriangleApplication::createGraphicsPipeline() {
 
     VkPipelineShaderStageCreateInfo stages[] = { vssi, fssi };
 
-    auto bindDesc = Vertex::getBindingDescription();
-    auto attrDesc = Vertex::getAttributeDescriptions();
+    // Vertex input and the vertex shaders' VERTEX_FORMAT follow vertexEncoding
+    VkVertexInputBindingDescription bindDesc = Vertex::getBindingDescription();
+    std::array<VkVertexInputAttributeDescription, 4> attrDesc = Vertex::getAttributeDescriptions();
+    if (vertexEncoding == VertexEncoding::Compact) {
+        bindDesc = vertexBinding<CompactVertexF>();
+        attrDesc = VertexLayout<CompactVertexF>::attributes;
+    }
+    else if (vertexEncoding == VertexEncoding::Quantized) {
+        bindDesc = vertexBinding<CompactVertexQ>();
+        attrDesc = VertexLayout<CompactVertexQ>::attributes;
+    }
+    const int32_t vertexFormat = (int32_t)vertexEncoding;
+    VkSpecializationMapEntry vertexFormatEntry{ 0, 0, sizeof(int32_t) };
+    VkSpecializationInfo vertexSpec{ 1, &vertexFormatEntry, sizeof(int32_t), &vertexFormat };
+    stages[0].pSpecializationInfo = &vertexSpec;
 
     VkPipelineVertexInputStateCreateInfo vi{};
     vi.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
@@ -1100,7 +1609,7 @@ void HelloTriangleApplication::createGraphicsPipeline() {
     depth.stencilTestEnable = VK_FALSE;
 
     // Dynamic rendering info includes depth format
-    VkFormat depthFormat = findDepthFormat();
+    depthFormat = findDepthFormat();
 
     VkPipelineRenderingCreateInfo rend{};
     rend.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO;
@@ -1125,17 +1634,76 @@ void HelloTriangleApplication::createGraphicsPipeline() {
     gp.renderPass = VK_NULL_HANDLE;
     gp.subpass = 0;
 
-    if (vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &gp, nullptr, &graphicsPipeline) != VK_SUCCESS)
+    if (vkCreateGraphicsPipelines(device, pipelineCache.handle(), 1, &gp, nullptr, &graphicsPipeline) != VK_SUCCESS)
         throw std::runtime_error("Failed to create graphics pipeline!");
 
+    // Same state, vertex stage reads the model matrix from the instance SSBO
+    auto instVertCode = readFile("shaders/instanced.vert.spv");
+    VkShaderModule ivs = createShaderModule(instVertCode);
+    stages[0].module = ivs;
+    if (vkCreateGraphicsPipelines(device, pipelineCache.handle(), 1, &gp, nullptr, &instancedPipeline) != VK_SUCCESS)
+        throw std::runtime_error("Failed to create instanced pipeline!");
+
+    vkDestroyShaderModule(device, ivs, nullptr);
     vkDestroyShaderModule(device, fs, nullptr);
     vkDestroyShaderModule(device, vs, nullptr);
 }
 
 void HelloTriangleApplication::createPostPipeline() {
+    // --- NEW: push constant range for FirePush ---
+    VkPushConstantRange pcRange{};
+    pcRange.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+    pcRange.offset = 0;
+    pcRange.size = sizeof(FirePush);
+    static_assert(sizeof(BlurPush) <= sizeof(FirePush), "BlurPush must fit the post push range");
+
+    // pipeline layout: post descriptor set + push constants, shared by every post effect
+    VkPipelineLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    layoutInfo.setLayoutCount = 1;
+    layoutInfo.pSetLayouts = &postDescriptorSetLayout;
+    layoutInfo.pushConstantRangeCount = 1;
+    layoutInfo.pPushConstantRanges = &pcRange;
+
+    if (vkCreatePipelineLayout(device, &layoutInfo, nullptr, &postPipelineLayout) != VK_SUCCESS)
+        throw std::runtime_error("post pipeline layout failed");
+
+    postPipeline = createFullscreenPipeline("shaders/glow.frag.spv", nullptr);
+    boxBlurPipeline = createFullscreenPipeline("shaders/blur.frag.spv", nullptr);
+
+    // Kernel shape is baked in at pipeline creation
+    struct { int32_t radius; float sigma; } blurSpec{ blurRadius("gaussian"), options.blurSigma };
+    std::array<VkSpecializationMapEntry, 2> entries{};
+    entries[0] = { 0, 0, sizeof(int32_t) };
+    entries[1] = { 1, sizeof(int32_t), sizeof(float) };
+    VkSpecializationInfo spec{};
+    spec.mapEntryCount = (uint32_t)entries.size();
+    spec.pMapEntries = entries.data();
+    spec.dataSize = sizeof(blurSpec);
+    spec.pData = &blurSpec;
+    gaussianPipeline = createFullscreenPipeline("shaders/gaussian.frag.spv", &spec);
+
+    bloomDownPipeline = createFullscreenPipeline("shaders/bloom_down.frag.spv", nullptr);
+    bloomUpPipeline = createFullscreenPipeline("shaders/bloom_up.frag.spv", nullptr);
+
+    int gaussFetches = 2 * (1 + 2 * ((blurSpec.radius + 1) / 2));
+    STEP("post: box blur 49 fetches/pixel, gaussian r=" << blurSpec.radius << " sigma=" << blurSpec.sigma
+        << " " << gaussFetches << " fetches/pixel over 2 passes");
+}
+
+// --blur-radius as both Gaussian paths bake it in, so fragment and compute
+// blur the same amount
+int32_t HelloTriangleApplication::blurRadius(const char* user) const {
+    const int32_t r = std::clamp(options.blurRadius, 1, MAX_BLUR_RADIUS);
+    if (r != options.blurRadius)
+        STEP(user << ": --blur-radius " << options.blurRadius << " clamped to " << r);
+    return r;
+}
+
+VkPipeline HelloTriangleApplication::createFullscreenPipeline(const char* fragPath, const VkSpecializationInfo* spec) {
 
     auto vsCode = readFile("shaders/fullscreen.vert.spv");
-    auto fsCode = readFile("shaders/glow.frag.spv");
+    auto fsCode = readFile(fragPath);
 
     VkShaderModule vertShaderModule = createShaderModule(vsCode);
     VkShaderModule fragShaderModule = createShaderModule(fsCode);
@@ -1151,6 +1719,7 @@ void HelloTriangleApplication::createPostPipeline() {
     fragStage.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
     fragStage.module = fragShaderModule;
     fragStage.pName = "main";
+    fragStage.pSpecializationInfo = spec;
 
     VkPipelineShaderStageCreateInfo shaderStages[] = {
         vertStage, fragStage
@@ -1183,6 +1752,13 @@ void HelloTriangleApplication::createPostPipeline() {
     viewportState.scissorCount = 1;
     viewportState.pScissors = &scissor;
 
+    // set per pass: bloom levels render below swapchain size
+    std::array<VkDynamicState, 2> dynamicStates{ VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+    VkPipelineDynamicStateCreateInfo dynamicState{};
+    dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+    dynamicState.dynamicStateCount = (uint32_t)dynamicStates.size();
+    dynamicState.pDynamicStates = dynamicStates.data();
+
     VkPipelineRasterizationStateCreateInfo raster{};
     raster.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
     raster.polygonMode = VK_POLYGON_MODE_FILL;
@@ -1207,23 +1783,6 @@ void HelloTriangleApplication::createPostPipeline() {
     blend.attachmentCount = 1;
     blend.pAttachments = &colorBlendAttachment;
 
-    // --- NEW: push constant range for FirePush ---
-    VkPushConstantRange pcRange{};
-    pcRange.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
-    pcRange.offset = 0;
-    pcRange.size = sizeof(FirePush);
-
-    // pipeline layout: post descriptor set + push constants
-    VkPipelineLayoutCreateInfo layoutInfo{};
-    layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-    layoutInfo.setLayoutCount = 1;
-    layoutInfo.pSetLayouts = &postDescriptorSetLayout;
-    layoutInfo.pushConstantRangeCount = 1;
-    layoutInfo.pPushConstantRanges = &pcRange;
-
-    if (vkCreatePipelineLayout(device, &layoutInfo, nullptr, &postPipelineLayout) != VK_SUCCESS)
-        throw std::runtime_error("post pipeline layout failed");
-
     VkGraphicsPipelineCreateInfo pipeInfo{};
     pipeInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
     pipeInfo.stageCount = 2;
@@ -1234,6 +1793,7 @@ void HelloTriangleApplication::createPostPipeline() {
     pipeInfo.pRasterizationState = &raster;
     pipeInfo.pMultisampleState = &multisample;
     pipeInfo.pColorBlendState = &blend;
+    pipeInfo.pDynamicState = &dynamicState;
     pipeInfo.layout = postPipelineLayout;
     pipeInfo.renderPass = VK_NULL_HANDLE;
     pipeInfo.pDepthStencilState = nullptr;
@@ -1244,11 +1804,95 @@ void HelloTriangleApplication::createPostPipeline() {
     dynRender.pColorAttachmentFormats = &swapChainImageFormat;
     pipeInfo.pNext = &dynRender;
 
-    if (vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipeInfo, nullptr, &postPipeline) != VK_SUCCESS)
-        throw std::runtime_error("post pipeline failed");
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    if (vkCreateGraphicsPipelines(device, pipelineCache.handle(), 1, &pipeInfo, nullptr, &pipeline) != VK_SUCCESS)
+        throw std::runtime_error(std::string("post pipeline failed: ") + fragPath);
 
     vkDestroyShaderModule(device, vertShaderModule, nullptr);
     vkDestroyShaderModule(device, fragShaderModule, nullptr);
+    return pipeline;
+}
+
+void HelloTriangleApplication::createComputePost() {
+    // binding 0 — source (scene or previous pass), binding 1 — sharp scene (glow only),
+    // binding 2 — storage target
+    std::array<VkDescriptorSetLayoutBinding, 3> bindings{};
+    for (uint32_t i = 0; i < 3; i++) {
+        bindings[i].binding = i;
+        bindings[i].descriptorType = i < 2 ? VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER : VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        bindings[i].descriptorCount = 1;
+        bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+
+    VkDescriptorSetLayoutCreateInfo ci{};
+    ci.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    ci.bindingCount = (uint32_t)bindings.size();
+    ci.pBindings = bindings.data();
+    if (vkCreateDescriptorSetLayout(device, &ci, nullptr, &computeDescriptorSetLayout) != VK_SUCCESS)
+        throw std::runtime_error("failed to create compute post descriptor layout");
+
+    VkPushConstantRange pcRange{};
+    pcRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    pcRange.offset = 0;
+    pcRange.size = sizeof(ComputePush);
+
+    VkPipelineLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    layoutInfo.setLayoutCount = 1;
+    layoutInfo.pSetLayouts = &computeDescriptorSetLayout;
+    layoutInfo.pushConstantRangeCount = 1;
+    layoutInfo.pPushConstantRanges = &pcRange;
+    if (vkCreatePipelineLayout(device, &layoutInfo, nullptr, &computePipelineLayout) != VK_SUCCESS)
+        throw std::runtime_error("compute post pipeline layout failed");
+
+    // same kernel parameters as the fragment Gaussian; the radius also sizes the shared tile
+    struct { int32_t radius; float sigma; } blurSpec{ blurRadius("compute blur"), options.blurSigma };
+    struct { int32_t radius; float sigma; } glowSpec{ GLOW_BLUR_RADIUS, GLOW_BLUR_SIGMA };
+    std::array<VkSpecializationMapEntry, 2> entries{};
+    entries[0] = { 0, 0, sizeof(int32_t) };
+    entries[1] = { 1, sizeof(int32_t), sizeof(float) };
+    VkSpecializationInfo spec{};
+    spec.mapEntryCount = (uint32_t)entries.size();
+    spec.pMapEntries = entries.data();
+    spec.dataSize = sizeof(blurSpec);
+    spec.pData = &blurSpec;
+    blurComputePipeline = createComputePipeline("shaders/blur_tiled.comp.spv", &spec);
+    spec.pData = &glowSpec;
+    glowBlurComputePipeline = createComputePipeline("shaders/blur_tiled.comp.spv", &spec);
+    glowComputePipeline = createComputePipeline("shaders/glow.comp.spv", nullptr);
+
+    // storage + blit out of the intermediate format, blit into the swapchain
+    VkFormatProperties target{}, swap{};
+    vkGetPhysicalDeviceFormatProperties(physicalDevice, COMPUTE_POST_FORMAT, &target);
+    vkGetPhysicalDeviceFormatProperties(physicalDevice, swapChainImageFormat, &swap);
+    const VkFormatFeatureFlags need = VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT |
+        VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT | VK_FORMAT_FEATURE_BLIT_SRC_BIT;
+    computePostSupported = swapChainBlitDst
+        && (target.optimalTilingFeatures & need) == need
+        && (swap.optimalTilingFeatures & VK_FORMAT_FEATURE_BLIT_DST_BIT) != 0;
+    STEP("compute post path " << (computePostSupported ? "available" : "unavailable")
+        << " (tile " << BLUR_TILE << " + " << 2 * blurSpec.radius << " apron texels per workgroup)");
+}
+
+VkPipeline HelloTriangleApplication::createComputePipeline(const char* path, const VkSpecializationInfo* spec) {
+    auto code = readFile(path);
+    VkShaderModule module = createShaderModule(code);
+
+    VkComputePipelineCreateInfo ci{};
+    ci.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    ci.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    ci.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    ci.stage.module = module;
+    ci.stage.pName = "main";
+    ci.stage.pSpecializationInfo = spec;
+    ci.layout = computePipelineLayout;
+
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    if (vkCreateComputePipelines(device, pipelineCache.handle(), 1, &ci, nullptr, &pipeline) != VK_SUCCESS)
+        throw std::runtime_error(std::string("compute pipeline failed: ") + path);
+
+    vkDestroyShaderModule(device, module, nullptr);
+    return pipeline;
 }
 
 
@@ -1262,206 +1906,139 @@ void HelloTriangleApplication::createCommandPool() {
     ci.queueFamilyIndex = q.graphicsFamily.value();
     if (vkCreateCommandPool(device, &ci, nullptr, &commandPool) != VK_SUCCESS)
         throw std::runtime_error("Failed to create command pool");
-}
-
-// --- Textures (simple load, no mipmaps) -----------------------------------
-static stbi_uc* loadTextureOrFallback(int* w, int* h, int* ch) {
-    stbi_uc* p = stbi_load("rocks.jpg", w, h, ch, STBI_rgb_alpha);
-    if (p) return p;
-    // 2x2 checker fallback
-    *w = 2; *h = 2; *ch = 4;
-    stbi_uc* c = (stbi_uc*)malloc(4 * 4);
-    // pattern
-    unsigned char A[4] = { 200,200,200,255 };
-    unsigned char B[4] = { 50,50,50,255 };
-    memcpy(c + 0, A, 4); memcpy(c + 4, B, 4);
-    memcpy(c + 8, B, 4); memcpy(c + 12, A, 4);
-    return c;
-}
-
-void HelloTriangleApplication::createTextureImage() {
-    int w, h, ch;
-    stbi_uc* pixels = loadTextureOrFallback(&w, &h, &ch);
-    VkDeviceSize imageSize = (VkDeviceSize)w * h * 4;
-
-    VkBuffer staging; VkDeviceMemory stagingMem;
-    createBuffer(imageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-        staging, stagingMem);
-
-    void* data;
-    vkMapMemory(device, stagingMem, 0, imageSize, 0, &data);
-    memcpy(data, pixels, (size_t)imageSize);
-    vkUnmapMemory(device, stagingMem);
-    stbi_image_free(pixels); // ok for malloc’d too
-
-    createImage((uint32_t)w, (uint32_t)h, VK_FORMAT_R8G8B8A8_SRGB,
-        VK_IMAGE_TILING_OPTIMAL,
-        VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-        textureImage, textureImageMemory);
 
-    transitionImageLayout(textureImage, VK_FORMAT_R8G8B8A8_SRGB,
-        VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-        VK_IMAGE_ASPECT_COLOR_BIT);
-    copyBufferToImage(staging, textureImage, (uint32_t)w, (uint32_t)h);
-    transitionImageLayout(textureImage, VK_FORMAT_R8G8B8A8_SRGB,
-        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-        VK_IMAGE_ASPECT_COLOR_BIT);
+    uploads.init(device, graphicsQueue, q.graphicsFamily.value(), allocator);
 
-    vkDestroyBuffer(device, staging, nullptr);
-    vkFreeMemory(device, stagingMem, nullptr);
+    recorder.init(device, q.graphicsFamily.value(), framesInFlight, workers.size());
+    recordThreads = options.recordThreads < 0 ? recorder.threadCount()
+        : std::min<uint32_t>((uint32_t)options.recordThreads, recorder.threadCount());
 }
-void HelloTriangleApplication::createTextureImageView() {
-    textureImageView = createImageView(textureImage, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_ASPECT_COLOR_BIT);
-}
-void HelloTriangleApplication::createTextureSampler() {
-    VkPhysicalDeviceProperties props{}; vkGetPhysicalDeviceProperties(physicalDevice, &props);
-    VkSamplerCreateInfo info{};
-    info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
-    info.magFilter = VK_FILTER_LINEAR; info.minFilter = VK_FILTER_LINEAR;
-    info.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-    info.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-    info.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-    info.anisotropyEnable = VK_TRUE;
-    info.maxAnisotropy = props.limits.maxSamplerAnisotropy;
-    info.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
-    info.unnormalizedCoordinates = VK_FALSE;
-    info.compareEnable = VK_FALSE;
-    info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
-    if (vkCreateSampler(device, &info, nullptr, &textureSampler) != VK_SUCCESS)
-        throw std::runtime_error("Failed to create sampler");
-}
-
-// load tile (or fallback)
-static stbi_uc* loadTextureOrFallback2(int* w, int* h, int* ch) {
-    // try tile file first
-    stbi_uc* p = stbi_load("wood.jpg", w, h, ch, STBI_rgb_alpha);
-    if (p) return p;
-    // fallback: same 2x2 checker
-    *w = 2; *h = 2; *ch = 4;
-    stbi_uc* c = (stbi_uc*)malloc(4 * 4);
-    unsigned char A[4] = { 180,180,180,255 };
-    unsigned char B[4] = { 80, 80, 80,255 };
-    memcpy(c + 0, A, 4); memcpy(c + 4, B, 4);
-    memcpy(c + 8, B, 4); memcpy(c + 12, A, 4);
-    return c;
-}
-
-void HelloTriangleApplication::createTextureImage2() {
-    int w, h, ch;
-    stbi_uc* pixels = loadTextureOrFallback2(&w, &h, &ch);
-    VkDeviceSize imageSize = (VkDeviceSize)w * h * 4;
-
-    VkBuffer staging; VkDeviceMemory stagingMem;
-    createBuffer(imageSize,
-        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-        staging, stagingMem);
-
-    void* data;
-    vkMapMemory(device, stagingMem, 0, imageSize, 0, &data);
-    memcpy(data, pixels, (size_t)imageSize);
-    vkUnmapMemory(device, stagingMem);
-    stbi_image_free(pixels);
-
-    createImage((uint32_t)w, (uint32_t)h, VK_FORMAT_R8G8B8A8_SRGB,
-        VK_IMAGE_TILING_OPTIMAL,
-        VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-        textureImage2, textureImageMemory2);
 
-    transitionImageLayout(textureImage2, VK_FORMAT_R8G8B8A8_SRGB,
-        VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-        VK_IMAGE_ASPECT_COLOR_BIT);
-    copyBufferToImage(staging, textureImage2, (uint32_t)w, (uint32_t)h);
-    transitionImageLayout(textureImage2, VK_FORMAT_R8G8B8A8_SRGB,
-        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-        VK_IMAGE_ASPECT_COLOR_BIT);
+// --- Textures --------------------------------------------------------------
+void HelloTriangleApplication::createTextures() {
+    textures.init(physicalDevice, device, allocator, uploads);
 
-    vkDestroyBuffer(device, staging, nullptr);
-    vkFreeMemory(device, stagingMem, nullptr);
-}
+    VkSamplerCreateInfo sampler = textures.defaultSampler();
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<TextureHandle> handles = textures.loadMany({
+        { "rocks.jpg", sampler },
+        { "wood.jpg",  sampler },
+    }, workers);
+    rockTexture = handles[0];
+    woodTexture = handles[1];
+    double wallMs = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - t0).count();
 
-void HelloTriangleApplication::createTextureImageView2() {
-    textureImageView2 = createImageView(
-        textureImage2,
-        VK_FORMAT_R8G8B8A8_SRGB,
-        VK_IMAGE_ASPECT_COLOR_BIT
-    );
-}
-
-void HelloTriangleApplication::createTextureSampler2() {
-    VkPhysicalDeviceProperties props{};
-    vkGetPhysicalDeviceProperties(physicalDevice, &props);
-
-    VkSamplerCreateInfo info{ };
-    info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
-    info.magFilter = VK_FILTER_LINEAR;
-    info.minFilter = VK_FILTER_LINEAR;
-    info.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-    info.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-    info.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-    info.anisotropyEnable = VK_TRUE;
-    info.maxAnisotropy = props.limits.maxSamplerAnisotropy;
-    info.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
-    info.unnormalizedCoordinates = VK_FALSE;
-    info.compareEnable = VK_FALSE;
-    info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
-
-    if (vkCreateSampler(device, &info, nullptr, &textureSampler2) != VK_SUCCESS) {
-        throw std::runtime_error("failed to create tile sampler");
-    }
+    const TextureCache::Stats& ts = textures.getStats();
+    STEP("decode: " << wallMs << " ms wall on " << workers.size() << " worker(s), "
+        << ts.decodeMs << " ms if run serially");
+    STEP("textures: " << ts.requests << " requested, " << ts.images << " image(s) / "
+        << ts.mipLevels << " mip level(s) via " << (textures.usesGpuMips() ? "GPU blit" : "CPU resize") << ", "
+        << ts.samplers << " sampler(s), " << ts.pathHits + ts.contentHits << " dedup hit(s), "
+        << ts.fallbacks << " fallback(s)");
+    STEP("cooked: " << ts.cooked << " uploaded block-compressed, "
+        << ts.cookedExpanded << " expanded to RGBA8 (no BC support)");
+    if (ts.cookedStale)
+        STEP("cooked: " << ts.cookedStale << " .rtex file(s) older than their source image were ignored; "
+            "re-run TextureCooker on them");
 }
 
 
 // --- Vertex buffers for cube and sphere ------------------------------------
+// Every mesh goes through optimizeMesh before upload: duplicate vertices are
+// welded, triangles reordered for the post-transform cache and vertices for
+// fetch order. Its indices are appended to indexPacker, which picks 16- or
+// 32-bit indices per mesh; createIndexBuffer uploads them as one buffer.
 void HelloTriangleApplication::createVertexBuffers() {
-    auto makeVB = [&](const std::vector<Vertex>& verts, VkBuffer& buf, VkDeviceMemory& mem) {
-        VkDeviceSize size = sizeof(Vertex) * verts.size();
-        VkBuffer staging; VkDeviceMemory stagingMem;
-        createBuffer(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-            staging, stagingMem);
-        void* data; vkMapMemory(device, stagingMem, 0, size, 0, &data);
-        memcpy(data, verts.data(), (size_t)size);
-        vkUnmapMemory(device, stagingMem);
-
-        createBuffer(size, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, buf, mem);
-        copyBuffer(staging, buf, size);
-        vkDestroyBuffer(device, staging, nullptr);
-        vkFreeMemory(device, stagingMem, nullptr);
+    auto makeVB = [&](const char* name, const std::vector<Vertex>& source, VkBuffer& buf, GpuAllocation& mem,
+        IndexRange& indices, std::vector<Vertex>& optimized, PositionBounds& bounds) {
+        OptimizedMesh<Vertex> mesh = optimizeMesh(source);
+        const MeshOptStats& s = mesh.stats;
+        STEP(name << " mesh: " << s.verticesIn << " -> " << s.verticesOut << " vertices, " << s.triangles
+            << " triangles, ACMR " << s.acmrBefore << " -> " << s.acmrAfter
+            << ", ATVR " << s.atvrBefore << " -> " << s.atvrAfter);
+
+        bounds = positionBounds(mesh.vertices.data(), mesh.vertices.size());
+        uploadVertices(mesh.vertices, bounds, buf, mem);
+        indices = indexPacker.add(mesh.indices, (uint32_t)mesh.vertices.size());
+        optimized = std::move(mesh.vertices);
         };
 
-    makeVB(cubeVertices, cubeVertexBuffer, cubeVertexBufferMemory);
+    makeVB("cube", cubeVertices, cubeVertexBuffer, cubeVertexBufferMemory, cubeIndices, cubeMesh, cubeBounds);
+
+    // terrain tiles have no vertex buffer yet, but their shared grid is
+    // optimized once and its indices packed with the rest
+    if (options.terrain) {
+        terrainSettings.radius = options.terrainRadius;
+        terrainGrid = buildTerrainGrid(terrainSettings.tileQuads);
+        const MeshOptStats& s = terrainGrid.stats;
+        STEP("terrain tile grid: " << s.verticesOut << " vertices, " << s.triangles << " triangles, ACMR "
+            << s.acmrBefore << " -> " << s.acmrAfter);
+        terrainIndices = indexPacker.add(terrainGrid.indices, terrainSettings.tileVertices());
+        const float limit = terrainSettings.heightLimit();
+        terrainBounds.min = glm::vec3(0.0f, -limit, 0.0f);
+        terrainBounds.extent = glm::vec3(terrainSettings.tileSize(), 2.0f * limit, terrainSettings.tileSize());
+    }
+    STEP("vertex format: " << vertexEncodingName(vertexEncoding));
 }
 
-void HelloTriangleApplication::createIndexBuffer() {
-    // auto-generated index list for cubeVertices
-    std::vector<uint32_t> indices(cubeVertices.size());
-    for (uint32_t i = 0; i < indices.size(); i++) {
-        indices[i] = i;
+// Encodes `verts` in vertexEncoding into a new device-local vertex buffer.
+void HelloTriangleApplication::uploadVertices(const std::vector<Vertex>& verts, const PositionBounds& bounds,
+    VkBuffer& buf, GpuAllocation& mem)
+{
+    const void* data = verts.data();
+    VkDeviceSize size = sizeof(Vertex) * verts.size();
+    std::vector<CompactVertexF> compact;
+    std::vector<CompactVertexQ> quantized;
+    if (vertexEncoding == VertexEncoding::Compact) {
+        compact.resize(verts.size());
+        encodeVertices(verts.data(), verts.size(), bounds, compact.data());
+        data = compact.data();
+        size = sizeof(CompactVertexF) * compact.size();
+    }
+    else if (vertexEncoding == VertexEncoding::Quantized) {
+        quantized.resize(verts.size());
+        encodeVertices(verts.data(), verts.size(), bounds, quantized.data());
+        data = quantized.data();
+        size = sizeof(CompactVertexQ) * quantized.size();
     }
 
-    indexCount = static_cast<uint32_t>(indices.size());
-    VkDeviceSize bufferSize = sizeof(uint32_t) * indexCount;
+    createBuffer(size, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, buf, mem);
+    uploads.uploadBuffer(data, size, buf);
+}
+
+// Re-encodes the cube and rebuilds the scene pipelines for another layout.
+// Waits for the device, so it is only for benchmarks.
+void HelloTriangleApplication::setVertexEncoding(VertexEncoding encoding) {
+    vkDeviceWaitIdle(device);
+    vertexEncoding = encoding;
 
-    VkBuffer stagingBuffer;
-    VkDeviceMemory stagingBufferMemory;
-    createBuffer(
-        bufferSize,
-        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-        stagingBuffer,
-        stagingBufferMemory
-    );
+    vkDestroyBuffer(device, cubeVertexBuffer, nullptr);
+    allocator.free(cubeVertexBufferMemory);
+    uploadVertices(cubeMesh, cubeBounds, cubeVertexBuffer, cubeVertexBufferMemory);
+    uploads.flush();
 
-    // copy indices into staging buffer
-    void* data;
-    vkMapMemory(device, stagingBufferMemory, 0, bufferSize, 0, &data);
-    memcpy(data, indices.data(), (size_t)bufferSize);
-    vkUnmapMemory(device, stagingBufferMemory);
+    vkDestroyPipeline(device, graphicsPipeline, nullptr);
+    vkDestroyPipeline(device, instancedPipeline, nullptr);
+    vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
+    createGraphicsPipeline();
+
+    // resident tiles are in the old layout: start streaming again
+    if (options.terrain) {
+        terrain.destroy();
+        createTerrain();
+    }
+}
+
+void HelloTriangleApplication::createIndexBuffer() {
+    VkDeviceSize bufferSize = indexPacker.size();
+    STEP("index buffer: " << indexPacker.rangeCount() << " mesh(es), " << bufferSize << " bytes ("
+        << indexPacker.wideSize() << " as uint32)");
+
+    // copy indices into the staging ring
+    UploadBatcher::StagingSlice staging = uploads.stage(bufferSize);
+    memcpy(staging.data, indexPacker.data(), (size_t)bufferSize);
 
     // GPU index buffer
     createBuffer(
@@ -1472,44 +2049,114 @@ void HelloTriangleApplication::createIndexBuffer() {
         indexBufferMemory
     );
 
-    copyBuffer(stagingBuffer, indexBuffer, bufferSize);
+    copyBuffer(staging.buffer, staging.offset, indexBuffer, bufferSize);
+    indexPacker.clear();
+}
+
+
+// Stress grid for --stress: N cubes on the XZ plane under the camera, each
+// with its own spin; every eighth is unlit. Without --stress a single
+// instance is still created so binding 3 always has a buffer behind it.
+void HelloTriangleApplication::createInstanceBuffer() {
+    const uint32_t n = std::max(1u, options.stressCubes);
+    const uint32_t side = (uint32_t)std::ceil(std::sqrt((double)n));
+    const float extent = 4.0f;
+    const float spacing = extent / (float)side;
 
-    vkDestroyBuffer(device, stagingBuffer, nullptr);
-    vkFreeMemory(device, stagingBufferMemory, nullptr);
+    instances.resize(n);
+    for (uint32_t i = 0; i < n; i++) {
+        float x = -0.5f * extent + spacing * ((float)(i % side) + 0.5f);
+        float z = -0.5f * extent + spacing * ((float)(i / side) + 0.5f);
+        glm::mat4 m = glm::translate(glm::mat4(1.0f), glm::vec3(x, 0.0f, z));
+        m = glm::rotate(m, 0.37f * (float)i, glm::vec3(0.0f, 1.0f, 0.0f));
+        instances[i].model = glm::scale(m, glm::vec3(spacing * 0.6f));
+        instances[i].flags = (i % 8 == 7) ? 1u : 0u;
+    }
+    normalMatrices(&instances[0].model, sizeof(InstanceData), &instances[0].normalMatrix, sizeof(InstanceData), n);
+
+    VkDeviceSize size = sizeof(InstanceData) * instances.size();
+    createBuffer(size, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, instanceBuffer, instanceBufferMemory);
+    uploads.uploadBuffer(instances.data(), size, instanceBuffer);
+}
+
+// Starts streaming for --terrain. Tiles are generated and encoded in the
+// current vertexEncoding on the workers; slots freed by tiles that fall out of
+// range go back through retireQueue.
+void HelloTriangleApplication::createTerrain() {
+    if (!options.terrain) return;
+    const VertexEncoding encoding = vertexEncoding;
+    const VkDeviceSize stride = encoding == VertexEncoding::Compact ? sizeof(CompactVertexF)
+        : encoding == VertexEncoding::Quantized ? sizeof(CompactVertexQ) : sizeof(Vertex);
+    terrain.init(device, allocator, workers, terrainSettings, stride, framesInFlight,
+        [this, encoding](int32_t x, int32_t z) { return buildTerrainTile(x, z, encoding); },
+        [this](std::function<void()> release) { retireQueue.defer(std::move(release)); });
+    STEP("terrain: " << terrainSettings.tileSize() << " m tiles, radius " << terrainSettings.radius << ", "
+        << terrain.capacity() << " slots x " << terrain.bytesPerTile() / 1024 << " KiB, up to "
+        << terrainSettings.uploadsPerFrame << " upload(s) per frame");
+}
+
+// Tile (x, z) as vertex data in `encoding`. Runs on the workers, so it reads
+// nothing but the terrain settings, grid and bounds.
+std::vector<unsigned char> HelloTriangleApplication::buildTerrainTile(int32_t x, int32_t z, VertexEncoding encoding) const {
+    std::vector<Vertex> verts(terrainSettings.tileVertices());
+    generateTerrainTile(terrainSettings, terrainGrid, x, z, verts.data(),
+        [](const glm::vec3& pos, const glm::vec3& normal, const glm::vec2& uv) {
+            return Vertex{ pos, glm::vec3(1.0f), normal, uv };
+        });
+
+    std::vector<unsigned char> out;
+    if (encoding == VertexEncoding::Compact) {
+        out.resize(sizeof(CompactVertexF) * verts.size());
+        encodeVertices(verts.data(), verts.size(), terrainBounds, reinterpret_cast<CompactVertexF*>(out.data()));
+    }
+    else if (encoding == VertexEncoding::Quantized) {
+        out.resize(sizeof(CompactVertexQ) * verts.size());
+        encodeVertices(verts.data(), verts.size(), terrainBounds, reinterpret_cast<CompactVertexQ*>(out.data()));
+    }
+    else {
+        out.resize(sizeof(Vertex) * verts.size());
+        memcpy(out.data(), verts.data(), out.size());
+    }
+    return out;
 }
 
 
 // --- UBO / descriptors / command buffers / sync ----------------------------
 void HelloTriangleApplication::createUniformBuffers() {
-    VkDeviceSize bs = sizeof(UniformBufferObject);
-    uniformBuffers.resize(MAX_FRAMES_IN_FLIGHT);
-    uniformBuffersMemory.resize(MAX_FRAMES_IN_FLIGHT);
-    uniformBuffersMapped.resize(MAX_FRAMES_IN_FLIGHT);
-    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-        createBuffer(bs, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-            uniformBuffers[i], uniformBuffersMemory[i]);
-        vkMapMemory(device, uniformBuffersMemory[i], 0, bs, 0, &uniformBuffersMapped[i]);
-    }
+    uniformRing.init(physicalDevice, device, allocator, framesInFlight,
+        sizeof(UniformBufferObject), UBO_SLICES_PER_FRAME);
+    STEP("uniform ring: " << UBO_SLICES_PER_FRAME << " x " << uniformRing.range() << " B slices per frame ("
+        << uniformRing.bytesPerFrame() / 1024 << " KiB, offset alignment " << uniformRing.alignment() << ")");
 }
 
 void HelloTriangleApplication::createDescriptorPool() {
-    std::array<VkDescriptorPoolSize, 2> poolSizes{};
+    std::array<VkDescriptorPoolSize, 4> poolSizes{};
 
-    // UBOs: one per frame for main + one per frame for textured cube (post)
-    poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-    poolSizes[0].descriptorCount = 2 * MAX_FRAMES_IN_FLIGHT;
+    // one dynamic UBO: the main set's view of uniformRing
+    poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    poolSizes[0].descriptorCount = 1;
 
-    // all combined image samplers (2 main textures + 1 offscreen) = 3 per frame
+    // combined image samplers: 2 in the main set; per frame in flight, 2 each
+    // in the post and blur sets and in each of the 2 * BLOOM_LEVELS - 1 bloom
+    // sets (same layout as post), plus 4 in the compute sets
     poolSizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    poolSizes[1].descriptorCount = 3 * MAX_FRAMES_IN_FLIGHT;
+    poolSizes[1].descriptorCount = 2 + framesInFlight * (4 + 2 * (2 * BLOOM_LEVELS - 1) + 4);
+
+    // compute post path: one storage target per set (blur H, blur V, glow)
+    poolSizes[2].type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    poolSizes[2].descriptorCount = 3 * framesInFlight;
+
+    // the main set's instance buffer
+    poolSizes[3].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    poolSizes[3].descriptorCount = 1;
 
     VkDescriptorPoolCreateInfo poolInfo{};
     poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
     poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
     poolInfo.pPoolSizes = poolSizes.data();
-    // main descriptor sets + post descriptor sets
-    poolInfo.maxSets = 2 * MAX_FRAMES_IN_FLIGHT;
+    // main set, plus post + blur, bloom and compute pass sets per frame in flight
+    poolInfo.maxSets = 1 + framesInFlight * (2 + (2 * BLOOM_LEVELS - 1) + 3);
 
     if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS) {
         throw std::runtime_error("failed to create descriptor pool!");
@@ -1520,51 +2167,48 @@ void HelloTriangleApplication::createDescriptorPool() {
 
 
 void HelloTriangleApplication::createDescriptorSets() {
-    std::vector<VkDescriptorSetLayout> layouts(MAX_FRAMES_IN_FLIGHT, descriptorSetLayout);
-
     VkDescriptorSetAllocateInfo allocInfo{};
     allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
     allocInfo.descriptorPool = descriptorPool;
-    allocInfo.descriptorSetCount = (uint32_t)MAX_FRAMES_IN_FLIGHT;
-    allocInfo.pSetLayouts = layouts.data();
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &descriptorSetLayout;
 
-    descriptorSets.resize(MAX_FRAMES_IN_FLIGHT);
-    if (vkAllocateDescriptorSets(device, &allocInfo, descriptorSets.data()) != VK_SUCCESS) {
+    if (vkAllocateDescriptorSets(device, &allocInfo, &descriptorSet) != VK_SUCCESS) {
         throw std::runtime_error("failed to allocate descriptor sets");
     }
 
-    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+    // One set for every frame and draw: the UBO slice is chosen at bind time
+    {
         VkDescriptorBufferInfo bufferInfo{};
-        bufferInfo.buffer = uniformBuffers[i];
+        bufferInfo.buffer = uniformRing.buffer();
         bufferInfo.offset = 0;
         bufferInfo.range = sizeof(UniformBufferObject);
 
         // --- first texture (coin.jpg) ---
-        VkDescriptorImageInfo imageInfo1{};
-        imageInfo1.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-        imageInfo1.imageView = textureImageView;
-        imageInfo1.sampler = textureSampler;
+        VkDescriptorImageInfo imageInfo1 = textures.descriptor(rockTexture);
 
         // --- second texture (tile.jpg) ---
-        VkDescriptorImageInfo imageInfo2{};
-        imageInfo2.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-        imageInfo2.imageView = textureImageView2;
-        imageInfo2.sampler = textureSampler2;
+        VkDescriptorImageInfo imageInfo2 = textures.descriptor(woodTexture);
 
-        std::array<VkWriteDescriptorSet, 3> descriptorWrites{};
+        VkDescriptorBufferInfo instanceInfo{};
+        instanceInfo.buffer = instanceBuffer;
+        instanceInfo.offset = 0;
+        instanceInfo.range = VK_WHOLE_SIZE;
+
+        std::array<VkWriteDescriptorSet, 4> descriptorWrites{};
 
         // binding 0 = UBO
         descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        descriptorWrites[0].dstSet = descriptorSets[i];
+        descriptorWrites[0].dstSet = descriptorSet;
         descriptorWrites[0].dstBinding = 0;
         descriptorWrites[0].dstArrayElement = 0;
-        descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
         descriptorWrites[0].descriptorCount = 1;
         descriptorWrites[0].pBufferInfo = &bufferInfo;
 
         // binding 1 = coin texture
         descriptorWrites[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        descriptorWrites[1].dstSet = descriptorSets[i];
+        descriptorWrites[1].dstSet = descriptorSet;
         descriptorWrites[1].dstBinding = 1;
         descriptorWrites[1].dstArrayElement = 0;
         descriptorWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
@@ -1573,13 +2217,22 @@ void HelloTriangleApplication::createDescriptorSets() {
 
         // binding 2 = tile texture (new)
         descriptorWrites[2].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        descriptorWrites[2].dstSet = descriptorSets[i];
+        descriptorWrites[2].dstSet = descriptorSet;
         descriptorWrites[2].dstBinding = 2;
         descriptorWrites[2].dstArrayElement = 0;
         descriptorWrites[2].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
         descriptorWrites[2].descriptorCount = 1;
         descriptorWrites[2].pImageInfo = &imageInfo2;
 
+        // binding 3 = instance SSBO
+        descriptorWrites[3].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrites[3].dstSet = descriptorSet;
+        descriptorWrites[3].dstBinding = 3;
+        descriptorWrites[3].dstArrayElement = 0;
+        descriptorWrites[3].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        descriptorWrites[3].descriptorCount = 1;
+        descriptorWrites[3].pBufferInfo = &instanceInfo;
+
         vkUpdateDescriptorSets(device,
             static_cast<uint32_t>(descriptorWrites.size()),
             descriptorWrites.data(),
@@ -1589,7 +2242,7 @@ void HelloTriangleApplication::createDescriptorSets() {
 
 
 void HelloTriangleApplication::createCommandBuffers() {
-    commandBuffers.resize(MAX_FRAMES_IN_FLIGHT);
+    commandBuffers.resize(framesInFlight);
     VkCommandBufferAllocateInfo ai{};
     ai.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
     ai.commandPool = commandPool;
@@ -1600,14 +2253,17 @@ void HelloTriangleApplication::createCommandBuffers() {
 }
 
 void HelloTriangleApplication::createSyncObjects() {
-    imageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-    renderFinishedSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-    inFlightFences.resize(MAX_FRAMES_IN_FLIGHT);
+    imageAvailableSemaphores.resize(framesInFlight);
+    renderFinishedSemaphores.resize(framesInFlight);
+    inFlightFences.resize(framesInFlight);
+    latency.init(framesInFlight, options.frameLog);
+    if (!options.frameLog.empty() && !latency.logging())
+        STEP("could not open frame log " << options.frameLog);
 
     VkSemaphoreCreateInfo si{ VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO };
     VkFenceCreateInfo fi{ VK_STRUCTURE_TYPE_FENCE_CREATE_INFO };
     fi.flags = VK_FENCE_CREATE_SIGNALED_BIT;
-    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+    for (size_t i = 0; i < framesInFlight; i++) {
         if (vkCreateSemaphore(device, &si, nullptr, &imageAvailableSemaphores[i]) != VK_SUCCESS ||
             vkCreateSemaphore(device, &si, nullptr, &renderFinishedSemaphores[i]) != VK_SUCCESS ||
             vkCreateFence(device, &fi, nullptr, &inFlightFences[i]) != VK_SUCCESS)
@@ -1618,6 +2274,9 @@ void HelloTriangleApplication::createSyncObjects() {
 // --- Per-frame -------------------------------------------------------------
 
 void HelloTriangleApplication::updateUniformBuffer(uint32_t frame) {
+    // this frame's fence has been waited on, so its slices are free again
+    uniformRing.beginFrame(frame);
+
     UniformBufferObject u{};
 
     // Rotate cube by a fixed 45 degrees around Y axis
@@ -1628,9 +2287,23 @@ void HelloTriangleApplication::updateUniformBuffer(uint32_t frame) {
     );
 
     glm::vec3 camPos = glm::vec3(0.0f, 1.5f, 3.0f);
+    glm::vec3 camTarget = glm::vec3(0.0f, 0.0f, 0.0f);
+    glm::vec3 lightPos = glm::vec3(0.0f, 3.0f, 3.0f);
+    float farPlane = 10.0f;
+    if (options.terrain) {
+        // fly over the terrain in a straight line, above its highest point,
+        // seeing out to the edge of the streamed tiles; the light comes along
+        const float t = std::chrono::duration<float>(std::chrono::steady_clock::now() - startTime).count();
+        const glm::vec3 heading = glm::normalize(glm::vec3(0.35f, 0.0f, -1.0f));
+        camPos = heading * (TERRAIN_FLY_SPEED * t) + glm::vec3(0.0f, terrainSettings.heightLimit() + 1.5f, 0.0f);
+        camTarget = camPos + heading + glm::vec3(0.0f, -0.3f, 0.0f);
+        lightPos = camPos + glm::vec3(20.0f, 40.0f, 0.0f);
+        farPlane = (terrainSettings.radius + 1) * terrainSettings.tileSize();
+    }
+    cameraPos = camPos;
     u.view = glm::lookAt(
         camPos,
-        glm::vec3(0.0f, 0.0f, 0.0f),
+        camTarget,
         glm::vec3(0.0f, 1.0f, 0.0f)
     );
 
@@ -1638,102 +2311,344 @@ void HelloTriangleApplication::updateUniformBuffer(uint32_t frame) {
         glm::radians(45.0f),
         swapChainExtent.width / (float)swapChainExtent.height,
         0.1f,
-        10.0f
+        farPlane
     );
     u.proj[1][1] *= -1;
 
-    u.lightPos = glm::vec3(0.0f, 3.0f, 3.0f);
+    u.lightPos = lightPos;
     u.eyePos = camPos;
+    u.normalMatrix = normalMatrix(u.model);
+    u.posBias = glm::vec4(cubeBounds.min, 0.0f);
+    u.posScale = glm::vec4(cubeBounds.extent, 0.0f);
+
+    sceneUboOffset = uniformRing.push(u);
+
+    // terrain tiles are placed by push constant; the UBO carries their bounds
+    if (options.terrain) {
+        u.model = glm::mat4(1.0f);
+        u.normalMatrix = normalMatrix(u.model);
+        u.posBias = glm::vec4(terrainBounds.min, 0.0f);
+        u.posScale = glm::vec4(terrainBounds.extent, 0.0f);
+        terrainUboOffset = uniformRing.push(u);
+    }
+}
+
 
-    memcpy(uniformBuffersMapped[frame], &u, sizeof(u));
+
+// Everything the scene draws rely on. Secondaries inherit none of it from
+// the primary, so each one calls this before its first draw.
+void HelloTriangleApplication::bindSceneState(VkCommandBuffer cb, VkPipeline pipeline) {
+    vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+    vkCmdBindDescriptorSets(
+        cb, VK_PIPELINE_BIND_POINT_GRAPHICS,
+        pipelineLayout, 0, 1,
+        &descriptorSet, 1, &sceneUboOffset);
+
+    VkDeviceSize offs = 0;
+    vkCmdBindVertexBuffers(cb, 0, 1, &cubeVertexBuffer, &offs);
+    vkCmdBindIndexBuffer(cb, indexBuffer, cubeIndices.offset, cubeIndices.type);
+
+    VkViewport vp{ 0.0f, 0.0f, (float)swapChainExtent.width, (float)swapChainExtent.height, 0.0f, 1.0f };
+    VkRect2D sc{ {0, 0}, swapChainExtent };
+    vkCmdSetViewport(cb, 0, 1, &vp);
+    vkCmdSetScissor(cb, 0, 1, &sc);
+
+    // shader.vert always reads the push block; zeroed means "use the UBO model,
+    // lit". Per-object draws overwrite it.
+    PushConstants pc{};
+    vkCmdPushConstants(cb, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+        0, sizeof(PushConstants), &pc);
+}
+
+// The path instancing replaces: one push + draw per object in [first, first + count)
+void HelloTriangleApplication::recordSceneDraws(VkCommandBuffer cb, size_t first, size_t count) {
+    PushConstants pc{};
+    pc.useOverride = 1;
+    for (size_t i = first; i < first + count; i++) {
+        const InstanceData& inst = instances[i];
+        pc.modelOverride = inst.model;
+        pc.normalOverride = inst.normalMatrix;
+        pc.unlit = inst.flags & 1u;
+        vkCmdPushConstants(cb, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+            0, sizeof(PushConstants), &pc);
+        vkCmdDrawIndexed(cb, cubeIndices.count, 1, 0, 0, 0);
+    }
 }
 
+// Splits the per-cube draws into contiguous ranges, records each into a
+// secondary on its own worker (with its own command pool), then executes them
+// in order from the primary. Must be called inside a vkCmdBeginRendering
+// started with VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT.
+void HelloTriangleApplication::recordSceneParallel(VkCommandBuffer cb) {
+    PROFILE_SCOPE("record scene (parallel)");
+    const uint32_t threads = recordThreads;
+    const size_t n = instances.size();
+
+    VkCommandBufferInheritanceRenderingInfo rendering{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO };
+    rendering.colorAttachmentCount = 1;
+    rendering.pColorAttachmentFormats = &swapChainImageFormat;   // "scene" format
+    rendering.depthAttachmentFormat = depthFormat;
+    rendering.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+    std::vector<VkCommandBuffer> secondaries(threads);
+    std::vector<std::future<void>> jobs;
+    jobs.reserve(threads);
+    for (uint32_t t = 0; t < threads; t++) {
+        size_t first = n * t / threads, last = n * (t + 1) / threads;
+        jobs.push_back(workers.submit([this, t, first, last, &rendering, &secondaries] {
+            PROFILE_SCOPE("record scene range");
+            VkCommandBuffer sc = recorder.begin(t, rendering, gpuTimer.statisticFlags());
+            bindSceneState(sc, graphicsPipeline);
+            recordSceneDraws(sc, first, last - first);
+            if (vkEndCommandBuffer(sc) != VK_SUCCESS)
+                throw std::runtime_error("Failed to record secondary command buffer");
+            secondaries[t] = sc;
+        }));
+    }
+    // every job references locals here: let all of them finish before rethrowing
+    for (auto& j : jobs) j.wait();
+    for (auto& j : jobs) j.get();
 
+    vkCmdExecuteCommands(cb, threads, secondaries.data());
+    sceneDrawCalls = (uint32_t)n;
+}
+
+// Resident terrain tiles, front to back: one push + draw per tile, all from
+// the streamer's vertex buffer and the shared grid indices. Relies on the
+// viewport and scissor set by bindSceneState.
+void HelloTriangleApplication::recordTerrain(VkCommandBuffer cb) {
+    vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
+    vkCmdBindDescriptorSets(
+        cb, VK_PIPELINE_BIND_POINT_GRAPHICS,
+        pipelineLayout, 0, 1,
+        &descriptorSet, 1, &terrainUboOffset);
+
+    VkBuffer vb = terrain.vertexBuffer();
+    VkDeviceSize offs = 0;
+    vkCmdBindVertexBuffers(cb, 0, 1, &vb, &offs);
+    vkCmdBindIndexBuffer(cb, indexBuffer, terrainIndices.offset, terrainIndices.type);
+
+    PushConstants pc{};
+    pc.useOverride = 1;
+    pc.normalOverride = normalMatrix(glm::mat4(1.0f));
+    for (const TerrainStreamer::Tile& t : terrain.tiles()) {
+        pc.modelOverride = glm::translate(glm::mat4(1.0f), tileOrigin(terrainSettings, t.x, t.z));
+        vkCmdPushConstants(cb, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+            0, sizeof(PushConstants), &pc);
+        vkCmdDrawIndexed(cb, terrainIndices.count, 1, 0, (int32_t)t.firstVertex, 0);
+    }
+    sceneDrawCalls += (uint32_t)terrain.tiles().size();
+}
 
 void HelloTriangleApplication::recordCommandBuffer(VkCommandBuffer cb, uint32_t imageIndex)
 {
+    buildFrameGraph(imageIndex);
+    if (frameGraph.compile()) {
+        graphGeneration++;
+        const RenderGraph::Stats& st = frameGraph.stats();
+        STEP("render graph: " << st.passes - st.culled << "/" << st.passes << " passes live, " << st.transients
+            << " transient(s) in " << st.allocations << " allocation(s), " << st.bytes / 1024 << " KiB ("
+            << st.unaliasedBytes / 1024 << " KiB without aliasing)");
+    }
+    // this frame's fence has signalled, so nothing is reading its sets
+    if (graphSets[currentFrame].generation != graphGeneration) {
+        updatePostDescriptorSets(currentFrame);
+        updateComputeDescriptorSets(currentFrame);
+        graphSets[currentFrame].generation = graphGeneration;
+    }
+
     VkCommandBufferBeginInfo bi{};
     bi.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
     vkBeginCommandBuffer(cb, &bi);
+    gpuTimer.beginFrame(cb, currentFrame);
+    recorder.beginFrame(currentFrame);
+
+    // tiles finished since last frame are copied in ahead of every pass
+    if (options.terrain) {
+        PROFILE_SCOPE("terrain stream");
+        terrain.update(cb, currentFrame, cameraPos);
+    }
 
-    // ---------------------------------------------------------
-    // PASS 1: Render scene to offscreenImage (sharp)
-    // ---------------------------------------------------------
-
-    VkImageMemoryBarrier2 offToColor{};
-    offToColor.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
-    offToColor.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    offToColor.newLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-    offToColor.srcStageMask = VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT;
-    offToColor.dstStageMask = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT;
-    offToColor.srcAccessMask = 0;
-    offToColor.dstAccessMask = VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT;
-    offToColor.image = offscreenImage;
-    offToColor.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
-
-    VkDependencyInfo dep1{};
-    dep1.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
-    dep1.imageMemoryBarrierCount = 1;
-    dep1.pImageMemoryBarriers = &offToColor;
-    vkCmdPipelineBarrier2(cb, &dep1);
+    frameGraph.execute(cb,
+        [&](const char* pass) { gpuTimer.begin(cb, pass); },
+        [&](const char*) { gpuTimer.end(cb); });
 
+    vkEndCommandBuffer(cb);
+}
+
+// Every post path is declared each frame; compile() culls the passes the
+// final one doesn't depend on, so e.g. the bloom pyramid only exists while
+// glow is selected. Transients with disjoint lifetimes share memory.
+void HelloTriangleApplication::buildFrameGraph(uint32_t imageIndex) {
+    using Use = RenderGraph::Use;
+    RenderGraph& g = frameGraph;
+    const GraphSets& sets = graphSets[currentFrame];
+    g.reset();
+
+    const VkExtent2D extent = swapChainExtent;
+    // Bloom pyramid starts at half resolution; each level halves again
+    const VkExtent2D bloomBase{ std::max(1u, extent.width / 2), std::max(1u, extent.height / 2) };
+    for (uint32_t i = 0; i < BLOOM_LEVELS; i++)
+        bloomExtents[i] = { std::max(1u, bloomBase.width >> i), std::max(1u, bloomBase.height >> i) };
+
+    // the acquire semaphore is waited on at these stages (see drawFrame)
+    const RenderGraph::ImageId swap = g.importImage("swapchain", swapChainImages[imageIndex],
+        swapChainImageViews[imageIndex], VK_IMAGE_LAYOUT_UNDEFINED,
+        VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_2_BLIT_BIT, presentLayout);
+    // the swapchain's format (exercise requirement)
+    const RenderGraph::ImageId scene = g.createImage("scene", { extent, swapChainImageFormat });
+    const RenderGraph::ImageId depth = g.createImage("depth", { extent, depthFormat, 1, VK_IMAGE_ASPECT_DEPTH_BIT });
+    // written by the horizontal Gaussian pass, sampled by the vertical one
+    const RenderGraph::ImageId blur = g.createImage("blur", { extent, swapChainImageFormat });
+    const RenderGraph::ImageId bloom = g.createImage("bloom", { bloomBase, swapChainImageFormat, BLOOM_LEVELS });
+
+    g.addPass("scene", [this](VkCommandBuffer cb) { recordScene(cb); })
+        .write(scene, Use::ColorAttachment)
+        .write(depth, Use::DepthAttachment);
+
+    g.addPass("gaussian H", [this, extent, set = sets.post](VkCommandBuffer cb) {
+        BlurPush blurPc{};
+        blurPc.texelStepX = 1.0f / (float)extent.width;
+        recordFullscreenPass(cb, frameGraph.view("blur"), extent, gaussianPipeline,
+            set, &blurPc, sizeof(BlurPush));
+    })
+        .read(scene, Use::SampledFragment)
+        .write(blur, Use::ColorAttachment);
+
+    g.addPass("bloom", [this](VkCommandBuffer cb) { recordBloom(cb); })
+        .read(scene, Use::SampledFragment)
+        .write(bloom, Use::ColorAttachment)
+        .leaves(bloom, Use::SampledFragment);
+
+    if (renderMode == RenderMode::SceneCompute) {
+        // Box blur and Gaussian both run the tiled Gaussian here; glow adds
+        // the composite. Intermediates stay in GENERAL and the result is
+        // blitted, since the swapchain can't be a storage image.
+        const bool glow = postEffect == PostEffect::Glow;
+        const RenderGraph::ImageId temp = g.createImage("compute temp", { extent, COMPUTE_POST_FORMAT });
+        const RenderGraph::ImageId cblur = g.createImage("compute blur", { extent, COMPUTE_POST_FORMAT });
+        const RenderGraph::ImageId out = g.createImage("compute out", { extent, COMPUTE_POST_FORMAT });
+        const VkPipeline blurPipeline = glow ? glowBlurComputePipeline : blurComputePipeline;
+        const uint32_t w = extent.width, h = extent.height;
+
+        // rows: one workgroup per BLUR_TILE-texel run of a row
+        g.addPass(glow ? "compute glow blur H" : "compute blur H", [this, blurPipeline, w, h, set = sets.computeBlurH](VkCommandBuffer cb) {
+            recordComputePass(cb, blurPipeline, set, (w + BLUR_TILE - 1) / BLUR_TILE, h, 1, 0);
+        })
+            .read(scene, Use::SampledCompute)
+            .write(temp, Use::StorageWrite);
+
+        // columns
+        g.addPass(glow ? "compute glow blur V" : "compute blur V", [this, blurPipeline, w, h, set = sets.computeBlurV](VkCommandBuffer cb) {
+            recordComputePass(cb, blurPipeline, set, (h + BLUR_TILE - 1) / BLUR_TILE, w, 0, 1);
+        })
+            .read(temp, Use::GeneralRead)
+            .write(cblur, Use::StorageWrite);
+
+        g.addPass("compute glow", [this, w, h, set = sets.computeGlow](VkCommandBuffer cb) {
+            recordComputePass(cb, glowComputePipeline, set, (w + 15) / 16, (h + 15) / 16, 0, 0);
+        })
+            .read(cblur, Use::GeneralRead)
+            .read(scene, Use::SampledCompute)
+            .write(out, Use::StorageWrite);
+
+        const RenderGraph::ImageId result = glow ? out : cblur;
+        g.addPass("compute blit", [this, result, swap, w, h](VkCommandBuffer cb) {
+            VkImageBlit region{};
+            region.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+            region.srcOffsets[1] = { (int32_t)w, (int32_t)h, 1 };
+            region.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+            region.dstOffsets[1] = { (int32_t)w, (int32_t)h, 1 };
+            vkCmdBlitImage(cb, frameGraph.image(result), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                frameGraph.image(swap), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region, VK_FILTER_NEAREST);
+        })
+            .read(result, Use::TransferSrc)
+            .write(swap, Use::TransferDst);
+        return;
+    }
+
+    // glow, box blur, or the vertical Gaussian pass into the swapchain image
+    RenderGraph::PassBuilder post = g.addPass(postEffect == PostEffect::Glow ? "post glow"
+        : postEffect == PostEffect::BoxBlur ? "post box blur" : "gaussian V",
+        [this, imageIndex](VkCommandBuffer cb) { recordPost(cb, imageIndex); });
+    if (postEffect == PostEffect::Gaussian) post.read(blur, Use::SampledFragment);
+    else post.read(scene, Use::SampledFragment);
+    if (postEffect == PostEffect::Glow) post.read(bloom, Use::SampledFragment);
+    post.write(swap, Use::ColorAttachment);
+}
+
+// PASS 1: the sharp scene into "scene", depth-tested against "depth"
+void HelloTriangleApplication::recordScene(VkCommandBuffer cb) {
     VkRenderingAttachmentInfo colorAtt1{};
     colorAtt1.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
-    colorAtt1.imageView = offscreenImageView;
+    colorAtt1.imageView = frameGraph.view("scene");
     colorAtt1.imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
     colorAtt1.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
     colorAtt1.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
     colorAtt1.clearValue = { {{0.0f, 0.0f, 0.0f, 1.0f}} };
 
+    VkRenderingAttachmentInfo depthAtt{};
+    depthAtt.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+    depthAtt.imageView = frameGraph.view("depth");
+    depthAtt.imageLayout = VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL;
+    depthAtt.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    depthAtt.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;   // nothing reads depth after the scene
+    depthAtt.clearValue.depthStencil = { 1.0f, 0 };
+
+    // one draw per cube is split across the workers; everything else is
+    // recorded here. Terrain tiles are drawn inline, so with --terrain the
+    // cubes are too.
+    const bool stress = options.stressCubes > 0;
+    const bool parallel = stress && !instancedDraw && recordThreads > 0 && !options.terrain;
+
     VkRenderingInfo render1{};
     render1.sType = VK_STRUCTURE_TYPE_RENDERING_INFO;
+    render1.flags = parallel ? VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT : 0;
     render1.colorAttachmentCount = 1;
     render1.pColorAttachments = &colorAtt1;
+    render1.pDepthAttachment = &depthAtt;
     render1.renderArea = { {0, 0}, swapChainExtent };
     render1.layerCount = 1;
 
     vkCmdBeginRendering(cb, &render1);
 
-    vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
-    vkCmdBindDescriptorSets(
-        cb, VK_PIPELINE_BIND_POINT_GRAPHICS,
-        pipelineLayout, 0, 1,
-        &descriptorSets[currentFrame], 0, nullptr);
-
-    VkDeviceSize offs = 0;
-    vkCmdBindVertexBuffers(cb, 0, 1, &cubeVertexBuffer, &offs);
-    vkCmdBindIndexBuffer(cb, indexBuffer, 0, VK_INDEX_TYPE_UINT32);
-
-    vkCmdDrawIndexed(cb, indexCount, 1, 0, 0, 0);
+    if (parallel) {
+        recordSceneParallel(cb);
+    }
+    else if (!stress) {
+        bindSceneState(cb, graphicsPipeline);
+        vkCmdDrawIndexed(cb, cubeIndices.count, 1, 0, 0, 0);
+        sceneDrawCalls = 1;
+    }
+    else if (instancedDraw) {
+        bindSceneState(cb, instancedPipeline);
+        vkCmdDrawIndexed(cb, cubeIndices.count, (uint32_t)instances.size(), 0, 0, 0);
+        sceneDrawCalls = 1;
+    }
+    else {
+        bindSceneState(cb, graphicsPipeline);
+        recordSceneDraws(cb, 0, instances.size());
+        sceneDrawCalls = (uint32_t)instances.size();
+    }
+    if (options.terrain) recordTerrain(cb);
 
     vkCmdEndRendering(cb);
+}
 
+// PASS 2: apply the post effect to the swapchain image
+// (glow, box blur, or the vertical Gaussian pass)
+void HelloTriangleApplication::recordPost(VkCommandBuffer cb, uint32_t imageIndex) {
+    VkViewport vp{};
+    vp.x = 0;
+    vp.y = 0;
+    vp.width = (float)swapChainExtent.width;
+    vp.height = (float)swapChainExtent.height;
+    vp.minDepth = 0.0f;
+    vp.maxDepth = 1.0f;
 
-    // ---------------------------------------------------------
-    // BARRIER: Prepare offscreenImage for sampling
-    // ---------------------------------------------------------
-
-    VkImageMemoryBarrier2 colorToRead{};
-    colorToRead.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
-    colorToRead.oldLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-    colorToRead.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-    colorToRead.srcStageMask = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT;
-    colorToRead.dstStageMask = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT;
-    colorToRead.srcAccessMask = VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT;
-    colorToRead.dstAccessMask = VK_ACCESS_2_SHADER_READ_BIT;
-    colorToRead.image = offscreenImage;
-    colorToRead.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
-
-    VkDependencyInfo dep2{};
-    dep2.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
-    dep2.imageMemoryBarrierCount = 1;
-    dep2.pImageMemoryBarriers = &colorToRead;
-    vkCmdPipelineBarrier2(cb, &dep2);
-
-
-    // ---------------------------------------------------------
-    // PASS 2: Apply blur + glow shader to the swapchain image
-    // ---------------------------------------------------------
+    VkRect2D sc{};
+    sc.offset = { 0, 0 };
+    sc.extent = swapChainExtent;
 
     VkRenderingAttachmentInfo swapAtt{};
     swapAtt.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
@@ -1752,78 +2667,213 @@ void HelloTriangleApplication::recordCommandBuffer(VkCommandBuffer cb, uint32_t
 
     vkCmdBeginRendering(cb, &render2);
 
-    VkViewport vp{};
-    vp.x = 0;
-    vp.y = 0;
-    vp.width = (float)swapChainExtent.width;
-    vp.height = (float)swapChainExtent.height;
-    vp.minDepth = 0.0f;
-    vp.maxDepth = 1.0f;
     vkCmdSetViewport(cb, 0, 1, &vp);
-
-    VkRect2D sc{};
-    sc.offset = { 0, 0 };
-    sc.extent = swapChainExtent;
     vkCmdSetScissor(cb, 0, 1, &sc);
 
-    vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_GRAPHICS, postPipeline);
+    if (postEffect == PostEffect::Gaussian) {
+        vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_GRAPHICS, gaussianPipeline);
+        vkCmdBindDescriptorSets(
+            cb, VK_PIPELINE_BIND_POINT_GRAPHICS,
+            postPipelineLayout,
+            0, 1,
+            &graphSets[currentFrame].blur,
+            0, nullptr);
 
-    vkCmdBindDescriptorSets(
-        cb, VK_PIPELINE_BIND_POINT_GRAPHICS,
-        postPipelineLayout,
-        0, 1,
-        &postDescriptorSets[currentFrame],
-        0, nullptr);
-    auto now = std::chrono::steady_clock::now();
-    float t = std::chrono::duration<float>(now - startTime).count();
-
-    FirePush firePc{};
-    firePc.time = t;
-    firePc.intensity = 2.0f; // tweak strength of fire aura
-
-    vkCmdPushConstants(
-        cb,
-        postPipelineLayout,
-        VK_SHADER_STAGE_FRAGMENT_BIT,
-        0,
-        sizeof(FirePush),
-        &firePc
-    );
+        BlurPush blurPc{};
+        blurPc.texelStepY = 1.0f / (float)swapChainExtent.height;
+        vkCmdPushConstants(cb, postPipelineLayout, VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(BlurPush), &blurPc);
+    }
+    else {
+        vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_GRAPHICS,
+            postEffect == PostEffect::BoxBlur ? boxBlurPipeline : postPipeline);
+
+        vkCmdBindDescriptorSets(
+            cb, VK_PIPELINE_BIND_POINT_GRAPHICS,
+            postPipelineLayout,
+            0, 1,
+            &graphSets[currentFrame].post,
+            0, nullptr);
+        auto now = std::chrono::steady_clock::now();
+        float t = std::chrono::duration<float>(now - startTime).count();
+
+        FirePush firePc{};
+        firePc.time = t;
+        firePc.intensity = 2.0f; // tweak strength of fire aura
+
+        vkCmdPushConstants(
+            cb,
+            postPipelineLayout,
+            VK_SHADER_STAGE_FRAGMENT_BIT,
+            0,
+            sizeof(FirePush),
+            &firePc
+        );
+    }
 
-    // Fullscreen triangle for glow
+    // Fullscreen triangle
     vkCmdDraw(cb, 3, 1, 0, 0);
 
     vkCmdEndRendering(cb);
+}
 
-    vkEndCommandBuffer(cb);
+// One compute post dispatch; the graph has already put its images in GENERAL.
+void HelloTriangleApplication::recordComputePass(VkCommandBuffer cb, VkPipeline pipeline, VkDescriptorSet set,
+    uint32_t groupsX, uint32_t groupsY, int32_t dirX, int32_t dirY)
+{
+    ComputePush pc{};
+    pc.dirX = dirX;
+    pc.dirY = dirY;
+    pc.time = std::chrono::duration<float>(std::chrono::steady_clock::now() - startTime).count();
+    pc.intensity = 2.0f;
+
+    vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+    vkCmdBindDescriptorSets(cb, VK_PIPELINE_BIND_POINT_COMPUTE, computePipelineLayout, 0, 1, &set, 0, nullptr);
+    vkCmdPushConstants(cb, computePipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(ComputePush), &pc);
+    vkCmdDispatch(cb, groupsX, groupsY, 1);
+}
+
+// Down the pyramid with a 5-tap filter, then back up with an 8-tap tent.
+// Each level is a quarter of the one above, so the whole chain costs about
+// 1.3 half-res passes however wide the resulting blur is. The graph hands
+// every level over in COLOR_ATTACHMENT_OPTIMAL; the per-level transitions are
+// recorded here and leave the whole chain in SHADER_READ_ONLY_OPTIMAL.
+void HelloTriangleApplication::recordBloom(VkCommandBuffer cb) {
+    const VkImage bloomImage = frameGraph.image("bloom");
+    const GraphSets& sets = graphSets[currentFrame];
+    for (uint32_t i = 0; i < BLOOM_LEVELS; i++) {
+        VkExtent2D src = i == 0 ? swapChainExtent : bloomExtents[i - 1];
+        BlurPush pc{};
+        pc.texelStepX = 1.0f / (float)src.width;
+        pc.texelStepY = 1.0f / (float)src.height;
+        recordFullscreenPass(cb, frameGraph.view("bloom", i), bloomExtents[i], bloomDownPipeline, sets.bloomDown[i],
+            &pc, sizeof(BlurPush));
+
+        recordImageBarrier(cb, bloomImage, i, 1,
+            VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
+            VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT, VK_ACCESS_2_SHADER_READ_BIT);
+    }
+
+    for (uint32_t i = BLOOM_LEVELS - 1; i-- > 0; ) {
+        // level i was just read by the downsample into i + 1; now overwrite it
+        recordImageBarrier(cb, bloomImage, i, 1,
+            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+            VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT, VK_ACCESS_2_SHADER_READ_BIT,
+            VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT);
+
+        BlurPush pc{};
+        pc.texelStepX = 1.0f / (float)bloomExtents[i + 1].width;
+        pc.texelStepY = 1.0f / (float)bloomExtents[i + 1].height;
+        recordFullscreenPass(cb, frameGraph.view("bloom", i), bloomExtents[i], bloomUpPipeline, sets.bloomUp[i],
+            &pc, sizeof(BlurPush));
+
+        recordImageBarrier(cb, bloomImage, i, 1,
+            VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
+            VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT, VK_ACCESS_2_SHADER_READ_BIT);
+    }
 }
 
+// One fullscreen triangle into `target`, which must already be in COLOR_ATTACHMENT_OPTIMAL.
+void HelloTriangleApplication::recordFullscreenPass(VkCommandBuffer cb, VkImageView target, VkExtent2D extent,
+    VkPipeline pipeline, VkDescriptorSet set, const void* push, uint32_t pushSize)
+{
+    VkRenderingAttachmentInfo att{};
+    att.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+    att.imageView = target;
+    att.imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    att.loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;   // every pixel is overwritten
+    att.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+
+    VkRenderingInfo ri{};
+    ri.sType = VK_STRUCTURE_TYPE_RENDERING_INFO;
+    ri.colorAttachmentCount = 1;
+    ri.pColorAttachments = &att;
+    ri.renderArea = { {0, 0}, extent };
+    ri.layerCount = 1;
+
+    vkCmdBeginRendering(cb, &ri);
+
+    VkViewport vp{ 0.0f, 0.0f, (float)extent.width, (float)extent.height, 0.0f, 1.0f };
+    VkRect2D sc{ {0, 0}, extent };
+    vkCmdSetViewport(cb, 0, 1, &vp);
+    vkCmdSetScissor(cb, 0, 1, &sc);
+
+    vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+    vkCmdBindDescriptorSets(cb, VK_PIPELINE_BIND_POINT_GRAPHICS, postPipelineLayout, 0, 1, &set, 0, nullptr);
+    vkCmdPushConstants(cb, postPipelineLayout, VK_SHADER_STAGE_FRAGMENT_BIT, 0, pushSize, push);
+    vkCmdDraw(cb, 3, 1, 0, 0);
 
+    vkCmdEndRendering(cb);
+}
 
+void HelloTriangleApplication::recordImageBarrier(VkCommandBuffer cb, VkImage image, uint32_t baseMip,
+    uint32_t mipCount, VkImageLayout oldLayout, VkImageLayout newLayout,
+    VkPipelineStageFlags2 srcStage, VkAccessFlags2 srcAccess,
+    VkPipelineStageFlags2 dstStage, VkAccessFlags2 dstAccess)
+{
+    VkImageMemoryBarrier2 b{ VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2 };
+    b.oldLayout = oldLayout;
+    b.newLayout = newLayout;
+    b.srcStageMask = srcStage;
+    b.srcAccessMask = srcAccess;
+    b.dstStageMask = dstStage;
+    b.dstAccessMask = dstAccess;
+    b.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    b.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    b.image = image;
+    b.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, baseMip, mipCount, 0, 1 };
 
+    VkDependencyInfo dep{ VK_STRUCTURE_TYPE_DEPENDENCY_INFO };
+    dep.imageMemoryBarrierCount = 1;
+    dep.pImageMemoryBarriers = &b;
+    vkCmdPipelineBarrier2(cb, &dep);
+}
 
 void HelloTriangleApplication::drawFrame() {
-    vkWaitForFences(device, 1, &inFlightFences[currentFrame], VK_TRUE, UINT64_MAX);
+    if (options.headless) { drawHeadlessFrame(); return; }
+    PROFILE_SCOPE("drawFrame");
+    const auto input = std::chrono::steady_clock::now();   // keys were polled just before drawFrame
+    pollFrameLatency();
+
+    {
+        PROFILE_SCOPE("fence wait");
+        vkWaitForFences(device, 1, &inFlightFences[currentFrame], VK_TRUE, UINT64_MAX);
+        retireQueue.retired(currentFrame);
+        latency.completed(currentFrame, std::chrono::steady_clock::now());
+        latency.begin(currentFrame, input);
+    }
 
     uint32_t imageIndex;
-    VkResult acq = vkAcquireNextImageKHR(device, swapChain, UINT64_MAX,
-        imageAvailableSemaphores[currentFrame], VK_NULL_HANDLE, &imageIndex);
+    VkResult acq;
+    {
+        PROFILE_SCOPE("acquire");
+        acq = vkAcquireNextImageKHR(device, swapChain, UINT64_MAX,
+            imageAvailableSemaphores[currentFrame], VK_NULL_HANDLE, &imageIndex);
+    }
     if (acq == VK_ERROR_OUT_OF_DATE_KHR) { recreateSwapChain(); return; }
     else if (acq != VK_SUCCESS && acq != VK_SUBOPTIMAL_KHR)
         throw std::runtime_error("Failed to acquire swap chain image");
 
-    updateUniformBuffer(currentFrame);
+    {
+        PROFILE_SCOPE("update UBO");
+        updateUniformBuffer(currentFrame);
+    }
 
-    vkResetFences(device, 1, &inFlightFences[currentFrame]);
-    vkResetCommandBuffer(commandBuffers[currentFrame], 0);
-    recordCommandBuffer(commandBuffers[currentFrame], imageIndex);
+    {
+        PROFILE_SCOPE("record");
+        vkResetFences(device, 1, &inFlightFences[currentFrame]);
+        vkResetCommandBuffer(commandBuffers[currentFrame], 0);
+        recordCommandBuffer(commandBuffers[currentFrame], imageIndex);
+    }
 
     VkCommandBufferSubmitInfo cbsi{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO };
     cbsi.commandBuffer = commandBuffers[currentFrame];
 
     VkSemaphoreSubmitInfo waitSem{ VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO };
     waitSem.semaphore = imageAvailableSemaphores[currentFrame];
-    waitSem.stageMask = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT;
+    // the compute path writes the swapchain image with a blit, not as an attachment
+    waitSem.stageMask = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_2_BLIT_BIT;
 
     VkSemaphoreSubmitInfo signalSem{ VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO };
     signalSem.semaphore = renderFinishedSemaphores[currentFrame];
@@ -1834,8 +2884,13 @@ void HelloTriangleApplication::drawFrame() {
     si.commandBufferInfoCount = 1; si.pCommandBufferInfos = &cbsi;
     si.signalSemaphoreInfoCount = 1; si.pSignalSemaphoreInfos = &signalSem;
 
-    if (vkQueueSubmit2(graphicsQueue, 1, &si, inFlightFences[currentFrame]) != VK_SUCCESS)
-        throw std::runtime_error("QueueSubmit2 failed");
+    {
+        PROFILE_SCOPE("submit");
+        if (vkQueueSubmit2(graphicsQueue, 1, &si, inFlightFences[currentFrame]) != VK_SUCCESS)
+            throw std::runtime_error("QueueSubmit2 failed");
+        retireQueue.submitted(currentFrame);
+        latency.submitted(currentFrame, std::chrono::steady_clock::now());
+    }
 
     VkPresentInfoKHR pi{ VK_STRUCTURE_TYPE_PRESENT_INFO_KHR };
     pi.waitSemaphoreCount = 1; pi.pWaitSemaphores = &renderFinishedSemaphores[currentFrame];
@@ -1843,7 +2898,11 @@ void HelloTriangleApplication::drawFrame() {
     pi.swapchainCount = 1; pi.pSwapchains = scs;
     pi.pImageIndices = &imageIndex;
 
-    VkResult pres = vkQueuePresentKHR(presentQueue, &pi);
+    VkResult pres;
+    {
+        PROFILE_SCOPE("present");
+        pres = vkQueuePresentKHR(presentQueue, &pi);
+    }
     if (pres == VK_ERROR_OUT_OF_DATE_KHR || pres == VK_SUBOPTIMAL_KHR || framebufferResized) {
         framebufferResized = false;
         recreateSwapChain();
@@ -1852,7 +2911,65 @@ void HelloTriangleApplication::drawFrame() {
         throw std::runtime_error("QueuePresent failed");
     }
 
-    currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+    currentFrame = (currentFrame + 1) % framesInFlight;
+}
+
+// Same passes as drawFrame, without acquire/present: the next ring image is
+// rendered and left in TRANSFER_SRC. Each CPU phase is timed into frameCpu.
+void HelloTriangleApplication::drawHeadlessFrame() {
+    using clock = std::chrono::steady_clock;
+    auto ms = [](clock::time_point a, clock::time_point b) {
+        return std::chrono::duration<double, std::milli>(b - a).count();
+    };
+
+    PROFILE_SCOPE("drawFrame");
+
+    auto t0 = clock::now();
+    pollFrameLatency();
+    {
+        PROFILE_SCOPE("fence wait");
+        vkWaitForFences(device, 1, &inFlightFences[currentFrame], VK_TRUE, UINT64_MAX);
+        retireQueue.retired(currentFrame);
+        latency.completed(currentFrame, clock::now());
+        latency.begin(currentFrame, t0);
+    }
+    uint32_t imageIndex = headlessFrame++ % HEADLESS_RING_SIZE;
+
+    auto t1 = clock::now();
+    {
+        PROFILE_SCOPE("update UBO");
+        updateUniformBuffer(currentFrame);
+    }
+
+    auto t2 = clock::now();
+    {
+        PROFILE_SCOPE("record");
+        vkResetFences(device, 1, &inFlightFences[currentFrame]);
+        vkResetCommandBuffer(commandBuffers[currentFrame], 0);
+        recordCommandBuffer(commandBuffers[currentFrame], imageIndex);
+    }
+
+    auto t3 = clock::now();
+    {
+        PROFILE_SCOPE("submit");
+        VkCommandBufferSubmitInfo cbsi{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO };
+        cbsi.commandBuffer = commandBuffers[currentFrame];
+        VkSubmitInfo2 si{ VK_STRUCTURE_TYPE_SUBMIT_INFO_2 };
+        si.commandBufferInfoCount = 1; si.pCommandBufferInfos = &cbsi;
+        if (vkQueueSubmit2(graphicsQueue, 1, &si, inFlightFences[currentFrame]) != VK_SUCCESS)
+            throw std::runtime_error("QueueSubmit2 failed");
+        retireQueue.submitted(currentFrame);
+        latency.submitted(currentFrame, std::chrono::steady_clock::now());
+    }
+    auto t4 = clock::now();
+
+    frameCpu.waitMs += ms(t0, t1);
+    frameCpu.updateMs += ms(t1, t2);
+    frameCpu.recordMs += ms(t2, t3);
+    frameCpu.submitMs += ms(t3, t4);
+    frameCpu.frames++;
+
+    currentFrame = (currentFrame + 1) % framesInFlight;
 }
 
 void HelloTriangleApplication::recreateSwapChain() {
@@ -1862,35 +2979,494 @@ void HelloTriangleApplication::recreateSwapChain() {
         glfwWaitEvents();
     }
 
-    vkDeviceWaitIdle(device);
-
-    cleanupSwapChain();
+    // No drain: the retired swapchain and its views are destroyed once every
+    // frame that may have rendered to them has signalled its fence. The graph
+    // reallocates for the new extent on the next frame and retires the old
+    // images the same way.
+    VkSwapchainKHR oldSwapChain = swapChain;
+    std::vector<VkImageView> oldViews = std::move(swapChainImageViews);
+    swapChainImageViews.clear();
 
     createSwapChain();
     createImageViews();
-    createDepthResources();
-    createOffscreenResources();
-    createPostDescriptorSets();
+    retireQueue.defer([this, oldSwapChain, oldViews] {
+        for (VkImageView v : oldViews) vkDestroyImageView(device, v, nullptr);
+        vkDestroySwapchainKHR(device, oldSwapChain, nullptr);
+    });
 }
 
 
 void HelloTriangleApplication::cleanupSwapChain() {
-    vkDestroyImageView(device, depthImageView, nullptr);
-    vkDestroyImage(device, depthImage, nullptr);
-    vkFreeMemory(device, depthImageMemory, nullptr);
-
-    vkDestroyImageView(device, offscreenImageView, nullptr);
-    vkDestroyImage(device, offscreenImage, nullptr);
-    vkFreeMemory(device, offscreenImageMemory, nullptr);
-
     for (auto v : swapChainImageViews)
         vkDestroyImageView(device, v, nullptr);
 
+    if (options.headless) {
+        for (size_t i = 0; i < swapChainImages.size(); i++) {
+            vkDestroyImage(device, swapChainImages[i], nullptr);
+            allocator.free(headlessImageMemory[i]);
+        }
+        return;
+    }
     vkDestroySwapchainKHR(device, swapChain, nullptr);
 }
 
 
 
+// --- Diagnostics -----------------------------------------------------------
+
+void HelloTriangleApplication::logMemoryStats(const char* label) {
+    GpuAllocator::Stats st = allocator.stats();
+    STEP("GPU memory (" << label << "): live " << st.liveBytes / 1024 << " KiB, wasted "
+        << st.wastedBytes / 1024 << " KiB, reserved " << st.reservedBytes / 1024 << " KiB, blocks "
+        << st.blockCount << ", allocations " << st.allocationCount);
+}
+
+void HelloTriangleApplication::dumpTrace() {
+    if (CpuProfiler::dump(options.trace)) STEP("CPU trace written to " << options.trace);
+    else STEP("could not write CPU trace " << options.trace);
+}
+
+// Stamp every frame whose fence has signalled since the last look, so a
+// frame isn't charged for the time until its slot comes round again.
+void HelloTriangleApplication::pollFrameLatency() {
+    for (uint32_t f = 0; f < framesInFlight; f++)
+        if (latency.pending(f) && vkGetFenceStatus(device, inFlightFences[f]) == VK_SUCCESS)
+            latency.completed(f, std::chrono::steady_clock::now());
+}
+
+void HelloTriangleApplication::logFrameLatency() {
+    FrameLatency::Summary l = latency.summary();
+    if (!l.samples) return;
+    STEP("latency (" << profileName(options.latency) << ", " << framesInFlight << " in flight, "
+        << (options.headless ? "headless" : presentModeName(presentMode)) << "): input to GPU done min/avg/p99 "
+        << l.minMs << " / " << l.avgMs << " / " << l.p99Ms << " ms, input to submit " << l.submitMs
+        << " ms, over the last " << std::min<uint64_t>(l.samples, FrameLatency::WINDOW) << " of " << l.samples
+        << " frame(s)");
+}
+
+void HelloTriangleApplication::logTerrainStats() {
+    if (!options.terrain) return;
+    const TerrainStreamer::Stats& s = terrain.getStats();
+    STEP("terrain: " << terrain.tiles().size() << "/" << terrain.capacity() << " slots drawn, " << s.built
+        << " tile(s) built (" << (s.built ? s.buildMs / s.built : 0.0) << " ms each on a worker), " << s.uploaded
+        << " uploaded, " << s.evicted << " evicted, " << s.abandoned << " abandoned; stream update "
+        << s.updateMs << " ms last frame, " << s.updatePeakMs << " ms peak");
+}
+
+void HelloTriangleApplication::logGpuTimes() {
+    if (!gpuTimer.isSupported())
+        STEP("GPU timings: timestamps not supported on the graphics queue");
+    for (const GpuTimer::Result& r : gpuTimer.results()) {
+        STEP("pass " << r.name << ": GPU min/avg/p99 " << r.minMs << " / " << r.gpuMs << " / " << r.p99Ms
+            << " ms over the last " << std::min<uint64_t>(r.samples, GpuTimer::WINDOW) << " of " << r.samples
+            << " frame(s), CPU record " << r.cpuMs << " ms");
+        if (r.stats)
+            STEP("pass " << r.name << ": " << r.stats->inputVertices << " vertices, " << r.stats->vertexInvocations
+                << " VS / " << r.stats->fragmentInvocations << " FS / " << r.stats->computeInvocations
+                << " CS invocations, " << r.stats->clippingPrimitives << " primitives per frame");
+    }
+}
+
+// Render a fixed number of frames on each post path and report the GPU time
+// of everything after the scene pass.
+void HelloTriangleApplication::runPostBenchmark() {
+    struct Path { const char* name; RenderMode mode; PostEffect effect; };
+    const Path paths[] = {
+        { "fragment glow",     RenderMode::SceneRTT,     PostEffect::Glow },
+        { "fragment box blur", RenderMode::SceneRTT,     PostEffect::BoxBlur },
+        { "fragment gaussian", RenderMode::SceneRTT,     PostEffect::Gaussian },
+        { "compute glow",      RenderMode::SceneCompute, PostEffect::Glow },
+        { "compute gaussian",  RenderMode::SceneCompute, PostEffect::Gaussian },
+    };
+    const int FRAMES = 300;
+
+    if (!gpuTimer.isSupported()) {
+        STEP("bench-post: timestamps not supported on the graphics queue");
+        return;
+    }
+
+    for (const Path& p : paths) {
+        if (p.mode == RenderMode::SceneCompute && !computePostSupported) {
+            STEP("bench-post " << p.name << ": skipped (compute post path unavailable)");
+            continue;
+        }
+        vkDeviceWaitIdle(device);
+        gpuTimer.reset();
+        renderMode = p.mode;
+        postEffect = p.effect;
+
+        for (int i = 0; i < FRAMES && !(window && glfwWindowShouldClose(window)); i++) {
+            if (window) glfwPollEvents();
+            drawFrame();
+        }
+        vkDeviceWaitIdle(device);
+        gpuTimer.resolve();
+
+        double postMs = 0.0, sceneMs = 0.0;
+        std::ostringstream passes;
+        for (const GpuTimer::Result& r : gpuTimer.results()) {
+            if (r.name == "scene") { sceneMs = r.gpuMs; continue; }
+            postMs += r.gpuMs;
+            passes << " " << r.name << "=" << r.gpuMs;
+        }
+        STEP("bench-post " << p.name << ": " << postMs << " ms post (" << passes.str() << " ), "
+            << sceneMs << " ms scene, " << swapChainExtent.width << "x" << swapChainExtent.height);
+    }
+}
+
+// Fixed-length offscreen run for CI: no window, no vsync, so the numbers are the
+// cost of the frame itself. Prints FPS, per-phase CPU time and per-pass GPU time.
+void HelloTriangleApplication::runHeadless() {
+    VkPhysicalDeviceProperties props{};
+    vkGetPhysicalDeviceProperties(physicalDevice, &props);
+    STEP("headless: " << options.frames << " frame(s) at " << swapChainExtent.width << "x" << swapChainExtent.height
+        << " on " << props.deviceName);
+
+    gpuTimer.reset();
+    latency.reset();
+    frameCpu = {};
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < options.frames; i++)
+        drawFrame();
+    vkDeviceWaitIdle(device);
+    double totalMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    gpuTimer.resolve();
+
+    double n = frameCpu.frames ? (double)frameCpu.frames : 1.0;
+    STEP("headless: " << frameCpu.frames << " frame(s) in " << totalMs << " ms, "
+        << (totalMs > 0.0 ? frameCpu.frames * 1000.0 / totalMs : 0.0) << " FPS");
+    STEP("headless CPU per frame: wait " << frameCpu.waitMs / n << " ms, update " << frameCpu.updateMs / n
+        << " ms, record " << frameCpu.recordMs / n << " ms, submit " << frameCpu.submitMs / n << " ms");
+    logGpuTimes();
+    logFrameLatency();
+    logTerrainStats();
+
+    if (!options.output.empty() && headlessFrame > 0)
+        writeFramePng(swapChainImages[(headlessFrame - 1) % HEADLESS_RING_SIZE], options.output);
+}
+
+// Copy a finished ring image (TRANSFER_SRC_OPTIMAL, RGBA8) to host memory and write it out.
+void HelloTriangleApplication::writeFramePng(VkImage image, const std::string& path) {
+    const uint32_t w = swapChainExtent.width, h = swapChainExtent.height;
+    const VkDeviceSize size = (VkDeviceSize)w * h * 4;
+
+    VkBuffer readback = VK_NULL_HANDLE;
+    GpuAllocation readbackMemory;
+    createBuffer(size, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, readback, readbackMemory);
+
+    VkCommandBuffer cb = uploads.recording();
+    VkBufferImageCopy region{};
+    region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+    region.imageExtent = { w, h, 1 };
+    vkCmdCopyImageToBuffer(cb, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, readback, 1, &region);
+
+    VkMemoryBarrier2 toHost{ VK_STRUCTURE_TYPE_MEMORY_BARRIER_2 };
+    toHost.srcStageMask = VK_PIPELINE_STAGE_2_COPY_BIT;
+    toHost.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+    toHost.dstStageMask = VK_PIPELINE_STAGE_2_HOST_BIT;
+    toHost.dstAccessMask = VK_ACCESS_2_HOST_READ_BIT;
+    VkDependencyInfo dep{ VK_STRUCTURE_TYPE_DEPENDENCY_INFO };
+    dep.memoryBarrierCount = 1;
+    dep.pMemoryBarriers = &toHost;
+    vkCmdPipelineBarrier2(cb, &dep);
+    uploads.flush();
+
+    if (stbi_write_png(path.c_str(), (int)w, (int)h, 4, readbackMemory.mapped, (int)w * 4))
+        STEP("headless: wrote " << path);
+    else
+        STEP("headless: could not write " << path);
+
+    vkDestroyBuffer(device, readback, nullptr);
+    allocator.free(readbackMemory);
+}
+
+// Same stress grid drawn both ways: one instanced draw reading the SSBO, and
+// one vkCmdPushConstants + vkCmdDrawIndexed per cube.
+void HelloTriangleApplication::runInstancingBenchmark() {
+    const int FRAMES = 120;
+
+    for (bool instanced : { false, true }) {
+        vkDeviceWaitIdle(device);
+        gpuTimer.reset();
+        instancedDraw = instanced;
+
+        auto start = std::chrono::steady_clock::now();
+        int frames = 0;
+        for (; frames < FRAMES && !(window && glfwWindowShouldClose(window)); frames++) {
+            if (window) glfwPollEvents();
+            drawFrame();
+        }
+        vkDeviceWaitIdle(device);
+        double totalMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        gpuTimer.resolve();
+
+        std::optional<GpuTimer::Result> scene = gpuTimer.result("scene");
+        STEP("bench-instancing " << (instanced ? "instanced" : "push constants") << ": " << instances.size()
+            << " cubes, " << sceneDrawCalls << " draw call(s)/frame, " << (frames ? totalMs / frames : 0.0)
+            << " ms/frame, scene record " << (scene ? scene->cpuMs : 0.0) << " ms CPU / "
+            << (scene ? scene->gpuMs : 0.0) << " ms GPU");
+    }
+}
+
+// The --stress grid drawn with one push + draw per cube, recorded straight
+// into the primary and then split over 1, 2, 4 .. N workers into secondaries.
+// "scene record" is the CPU time of the scene scope, including the wait for
+// the workers.
+void HelloTriangleApplication::runRecordingBenchmark() {
+    const int FRAMES = 120;
+    instancedDraw = false;
+
+    std::vector<uint32_t> threadCounts{ 0 };
+    for (uint32_t t = 1; t < recorder.threadCount(); t *= 2) threadCounts.push_back(t);
+    threadCounts.push_back(recorder.threadCount());
+
+    double inlineMs = 0.0;
+    for (uint32_t threads : threadCounts) {
+        vkDeviceWaitIdle(device);
+        gpuTimer.reset();
+        recordThreads = threads;
+
+        auto start = std::chrono::steady_clock::now();
+        int frames = 0;
+        for (; frames < FRAMES && !(window && glfwWindowShouldClose(window)); frames++) {
+            if (window) glfwPollEvents();
+            drawFrame();
+        }
+        vkDeviceWaitIdle(device);
+        double totalMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        gpuTimer.resolve();
+
+        std::optional<GpuTimer::Result> scene = gpuTimer.result("scene");
+        double recordMs = scene ? scene->cpuMs : 0.0;
+        if (threads == 0) inlineMs = recordMs;
+        STEP("bench-recording " << (threads ? std::to_string(threads) + " worker(s)" : std::string("inline"))
+            << ": " << sceneDrawCalls << " draws, scene record " << recordMs << " ms CPU ("
+            << (recordMs > 0.0 ? inlineMs / recordMs : 0.0) << "x inline), "
+            << (frames ? totalMs / frames : 0.0) << " ms/frame");
+    }
+}
+
+// CPU cost of encoding the compact layouts (SIMD against scalar), then the
+// --stress grid drawn instanced in each layout. Bytes fetched per frame is
+// vertex shader invocations (pipeline statistics when the timer has them,
+// else vertices x instances) times the vertex stride.
+void HelloTriangleApplication::runVertexFormatBenchmark() {
+    const int FRAMES = 120;
+    const size_t ENCODE_VERTICES = size_t(1) << 20;
+
+    std::vector<Vertex> src(ENCODE_VERTICES);
+    for (size_t i = 0; i < src.size(); i++) src[i] = cubeMesh[i % cubeMesh.size()];
+    PositionBounds bounds = positionBounds(src.data(), src.size());
+    std::vector<CompactVertexQ> encoded(src.size());
+#if defined(VERTEX_FORMATS_F16C)
+    const char* simdName = "SSE2+F16C";
+#elif defined(VERTEX_FORMATS_SSE)
+    const char* simdName = "SSE2";
+#else
+    const char* simdName = "scalar (no SSE2 on this target)";
+#endif
+    double scalarNs = 0.0;
+    for (bool simd : { false, true }) {
+        auto t0 = std::chrono::steady_clock::now();
+        encodeVertices(src.data(), src.size(), bounds, encoded.data(), simd);
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() / src.size();
+        if (!simd) scalarNs = ns;
+        STEP("bench-vertex-formats encode " << (simd ? simdName : "scalar") << ": " << ns << " ns/vertex"
+            << (simd && ns > 0.0 ? " (" + std::to_string(scalarNs / ns) + "x scalar)" : std::string()));
+    }
+
+    instancedDraw = true;
+    for (VertexEncoding e : { VertexEncoding::Float32, VertexEncoding::Compact, VertexEncoding::Quantized }) {
+        setVertexEncoding(e);
+        gpuTimer.reset();
+        for (int i = 0; i < FRAMES && !(window && glfwWindowShouldClose(window)); i++) {
+            if (window) glfwPollEvents();
+            drawFrame();
+        }
+        vkDeviceWaitIdle(device);
+        gpuTimer.resolve();
+
+        const uint32_t stride = e == VertexEncoding::Compact ? (uint32_t)sizeof(CompactVertexF)
+            : e == VertexEncoding::Quantized ? (uint32_t)sizeof(CompactVertexQ) : (uint32_t)sizeof(Vertex);
+        std::optional<GpuTimer::Result> scene = gpuTimer.result("scene");
+        double invocations = scene && scene->stats ? scene->stats->vertexInvocations
+            : (double)cubeMesh.size() * instances.size();
+        double bytes = invocations * stride;
+        double gpuMs = scene ? scene->gpuMs : 0.0;
+        STEP("bench-vertex-formats " << vertexEncodingName(e) << ": " << stride << " B/vertex, "
+            << invocations << " VS invocations, " << bytes / 1e6 << " MB fetched/frame, scene "
+            << gpuMs << " ms GPU (" << (gpuMs > 0.0 ? bytes / (gpuMs * 1e6) : 0.0) << " GB/s)");
+    }
+}
+
+// Tile builds (noise, normals, encode) run one after another on this thread,
+// then spread over the pool; then a flight over the streamed terrain, with the
+// worst CPU frame and the streaming cost on the render thread.
+void HelloTriangleApplication::runTerrainBenchmark() {
+    const int32_t TILES = 64;
+    const int FRAMES = 600;
+    using clock = std::chrono::steady_clock;
+    auto ms = [](clock::time_point a, clock::time_point b) {
+        return std::chrono::duration<double, std::milli>(b - a).count();
+    };
+
+    // far from the flight path, so nothing here is streamed later
+    auto t0 = clock::now();
+    for (int32_t i = 0; i < TILES; i++) buildTerrainTile(1000 + i % 8, 1000 + i / 8, vertexEncoding);
+    const double inlineMs = ms(t0, clock::now());
+
+    t0 = clock::now();
+    std::vector<std::future<std::vector<unsigned char>>> jobs;
+    for (int32_t i = 0; i < TILES; i++)
+        jobs.push_back(workers.submit([this, i] { return buildTerrainTile(1000 + i % 8, 1000 + i / 8, vertexEncoding); }));
+    for (auto& j : jobs) j.get();
+    const double poolMs = ms(t0, clock::now());
+    STEP("bench-terrain build: " << TILES << " tiles of " << terrainSettings.tileVertices() << " vertices, inline "
+        << inlineMs << " ms, " << workers.size() << " worker(s) " << poolMs << " ms ("
+        << (poolMs > 0.0 ? inlineMs / poolMs : 0.0) << "x)");
+
+    vkDeviceWaitIdle(device);
+    startTime = clock::now();
+    double totalMs = 0.0, worstMs = 0.0;
+    int frames = 0;
+    for (; frames < FRAMES && !(window && glfwWindowShouldClose(window)); frames++) {
+        if (window) glfwPollEvents();
+        auto f0 = clock::now();
+        drawFrame();
+        double f = ms(f0, clock::now());
+        totalMs += f;
+        worstMs = std::max(worstMs, f);
+    }
+    vkDeviceWaitIdle(device);
+    STEP("bench-terrain flight: " << frames << " frames over "
+        << TERRAIN_FLY_SPEED * ms(startTime, clock::now()) / 1000.0 << " m, " << (frames ? totalMs / frames : 0.0)
+        << " ms/frame CPU, worst " << worstMs << " ms");
+    logTerrainStats();
+}
+
+// CPU-only: transpose(inverse(mat3(m))) through glm one matrix at a time versus
+// the batched normalMatrices() used for the instance buffer, over a grid-sized
+// array of affine transforms. No Vulkan objects are created.
+void HelloTriangleApplication::runNormalMatrixBenchmark() {
+    const size_t N = 100000;
+    const int REPS = 50;
+
+    std::vector<glm::mat4> models(N);
+    uint32_t seed = 12345;
+    auto rnd = [&seed]() { seed = seed * 1664525u + 1013904223u; return (float)(seed >> 8) / 16777216.0f; };
+    for (auto& m : models) {
+        m = glm::translate(glm::mat4(1.0f), glm::vec3(rnd(), rnd(), rnd()) * 10.0f);
+        m = glm::rotate(m, rnd() * 6.28f, glm::normalize(glm::vec3(rnd(), rnd(), rnd()) + 0.1f));
+        m = glm::scale(m, glm::vec3(0.5f) + glm::vec3(rnd(), rnd(), rnd()));
+    }
+    std::vector<glm::mat3> reference(N);
+    std::vector<glm::mat3x4> batched(N);
+
+    using clock = std::chrono::steady_clock;
+    auto nsPerMatrix = [&](auto&& body) {
+        auto t0 = clock::now();
+        for (int r = 0; r < REPS; r++) body();
+        return std::chrono::duration<double, std::nano>(clock::now() - t0).count() / ((double)N * REPS);
+    };
+
+    double scalarNs = nsPerMatrix([&] {
+        for (size_t i = 0; i < N; i++) reference[i] = glm::transpose(glm::inverse(glm::mat3(models[i])));
+    });
+    double batchedNs = nsPerMatrix([&] {
+        normalMatrices(models.data(), sizeof(glm::mat4), batched.data(), sizeof(glm::mat3x4), N);
+    });
+
+    float maxErr = 0.0f;
+    for (size_t i = 0; i < N; i++)
+        for (int c = 0; c < 3; c++)
+            for (int r = 0; r < 3; r++)
+                maxErr = std::max(maxErr, std::fabs(reference[i][c][r] - batched[i][c][r]));
+
+#ifdef NORMAL_MATRIX_SSE
+    const char* path = "SSE";
+#else
+    const char* path = "scalar fallback";
+#endif
+    std::cout << "[BENCH] normal matrices: " << N << " x " << REPS << ", glm inverse " << scalarNs
+        << " ns/matrix, batched (" << path << ") " << batchedNs << " ns/matrix ("
+        << scalarNs / batchedNs << "x), max abs error " << maxErr << std::endl;
+}
+
+void HelloTriangleApplication::runAllocatorBenchmark() {
+    // Requirements of a representative device-local buffer; only the size varies per allocation.
+    VkBufferCreateInfo bi{ VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
+    bi.size = 4096;
+    bi.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    bi.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    VkBuffer probe;
+    if (vkCreateBuffer(device, &bi, nullptr, &probe) != VK_SUCCESS)
+        throw std::runtime_error("failed to create probe buffer");
+    VkMemoryRequirements req{}; vkGetBufferMemoryRequirements(device, probe, &req);
+    vkDestroyBuffer(device, probe, nullptr);
+
+    // deterministic sizes between 256 B and 16 KiB
+    const int N = 10000;
+    std::vector<VkDeviceSize> sizes(N);
+    uint32_t seed = 12345;
+    for (auto& sz : sizes) {
+        seed = seed * 1664525u + 1013904223u;
+        sz = 256 + (seed >> 8) % (16 * 1024 - 256);
+    }
+
+    using clock = std::chrono::steady_clock;
+    auto usSince = [](clock::time_point t0) {
+        return std::chrono::duration<double, std::micro>(clock::now() - t0).count();
+    };
+
+    const std::pair<AllocStrategy, const char*> strategies[] = {
+        { AllocStrategy::Linear, "linear" }, { AllocStrategy::Buddy, "buddy" }
+    };
+    for (auto& [strategy, name] : strategies) {
+        std::vector<GpuAllocation> allocs;
+        allocs.reserve(N);
+
+        auto t0 = clock::now();
+        for (int i = 0; i < N; i++) {
+            VkMemoryRequirements r = req;
+            r.size = sizes[i];
+            allocs.push_back(allocator.allocate(r, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, false, strategy));
+        }
+        double allocUs = usSince(t0);
+        GpuAllocator::Stats peak = allocator.stats();
+
+        t0 = clock::now();
+        for (auto& a : allocs) allocator.free(a);
+        double freeUs = usSince(t0);
+
+        std::cout << "[BENCH] " << name << ": " << N << " allocs in " << allocUs / 1000.0 << " ms ("
+            << N / (allocUs * 1e-6) << "/s), frees in " << freeUs / 1000.0 << " ms; peak live "
+            << peak.liveBytes / 1024 << " KiB, wasted " << peak.wastedBytes / 1024 << " KiB, blocks "
+            << peak.blockCount << std::endl;
+    }
+
+    // Baseline: one vkAllocateMemory per resource, capped well below maxMemoryAllocationCount
+    VkPhysicalDeviceProperties props{}; vkGetPhysicalDeviceProperties(physicalDevice, &props);
+    const int rawN = std::min<int>(N, (int)props.limits.maxMemoryAllocationCount / 4);
+    std::vector<VkDeviceMemory> raw(rawN);
+    auto t0 = clock::now();
+    for (int i = 0; i < rawN; i++) {
+        VkMemoryAllocateInfo ai{ VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
+        ai.allocationSize = sizes[i];
+        ai.memoryTypeIndex = allocator.findMemoryType(req.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        if (vkAllocateMemory(device, &ai, nullptr, &raw[i]) != VK_SUCCESS)
+            throw std::runtime_error("vkAllocateMemory failed during benchmark");
+    }
+    double allocUs = usSince(t0);
+    t0 = clock::now();
+    for (auto m : raw) vkFreeMemory(device, m, nullptr);
+    double freeUs = usSince(t0);
+    std::cout << "[BENCH] vkAllocateMemory: " << rawN << " allocs in " << allocUs / 1000.0 << " ms ("
+        << rawN / (allocUs * 1e-6) << "/s), frees in " << freeUs / 1000.0 << " ms" << std::endl;
+
+    logMemoryStats("after benchmark");
+}
+
 // --- Helpers ---------------------------------------------------------------
 
 std::vector<char> HelloTriangleApplication::readFile(const std::string& filename) {
@@ -1911,51 +3487,25 @@ VkShaderModule HelloTriangleApplication::createShaderModule(const std::vector<ch
     return m;
 }
 void HelloTriangleApplication::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags props,
-    VkBuffer& buf, VkDeviceMemory& mem) {
+    VkBuffer& buf, GpuAllocation& mem, AllocStrategy strategy) {
     VkBufferCreateInfo bi{ VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
     bi.size = size; bi.usage = usage; bi.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
     if (vkCreateBuffer(device, &bi, nullptr, &buf) != VK_SUCCESS)
         throw std::runtime_error("failed to create buffer");
     VkMemoryRequirements req{}; vkGetBufferMemoryRequirements(device, buf, &req);
-    VkMemoryAllocateInfo ai{ VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
-    ai.allocationSize = req.size;
-    ai.memoryTypeIndex = findMemoryType(req.memoryTypeBits, props);
-    if (vkAllocateMemory(device, &ai, nullptr, &mem) != VK_SUCCESS)
-        throw std::runtime_error("failed to allocate buffer memory");
-    vkBindBufferMemory(device, buf, mem, 0);
-}
-void HelloTriangleApplication::copyBuffer(VkBuffer src, VkBuffer dst, VkDeviceSize size) {
-    VkCommandBufferAllocateInfo ai{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO };
-    ai.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-    ai.commandPool = commandPool;
-    ai.commandBufferCount = 1;
-    VkCommandBuffer cb;
-    vkAllocateCommandBuffers(device, &ai, &cb);
-    VkCommandBufferBeginInfo bi{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
-    bi.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-    vkBeginCommandBuffer(cb, &bi);
-    VkBufferCopy region{}; region.size = size;
-    vkCmdCopyBuffer(cb, src, dst, 1, &region);
-    vkEndCommandBuffer(cb);
-    VkSubmitInfo si{ VK_STRUCTURE_TYPE_SUBMIT_INFO };
-    si.commandBufferCount = 1; si.pCommandBuffers = &cb;
-    vkQueueSubmit(graphicsQueue, 1, &si, VK_NULL_HANDLE);
-    vkQueueWaitIdle(graphicsQueue);
-    vkFreeCommandBuffers(device, commandPool, 1, &cb);
+    mem = allocator.allocate(req, props, false, strategy);
+    vkBindBufferMemory(device, buf, mem.memory, mem.offset);
 }
-uint32_t HelloTriangleApplication::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags props) {
-    VkPhysicalDeviceMemoryProperties mp{}; vkGetPhysicalDeviceMemoryProperties(physicalDevice, &mp);
-    for (uint32_t i = 0; i < mp.memoryTypeCount; i++) {
-        if ((typeFilter & (1 << i)) && (mp.memoryTypes[i].propertyFlags & props) == props) return i;
-    }
-    throw std::runtime_error("failed to find suitable memory type");
+void HelloTriangleApplication::copyBuffer(VkBuffer src, VkDeviceSize srcOffset, VkBuffer dst, VkDeviceSize size) {
+    uploads.copyBuffer(src, srcOffset, dst, 0, size);
 }
 void HelloTriangleApplication::createImage(uint32_t w, uint32_t h, VkFormat fmt, VkImageTiling tiling,
-    VkImageUsageFlags usage, VkMemoryPropertyFlags props, VkImage& image, VkDeviceMemory& memory) {
+    VkImageUsageFlags usage, VkMemoryPropertyFlags props, VkImage& image, GpuAllocation& memory,
+    uint32_t mipLevels) {
     VkImageCreateInfo ci{ VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO };
     ci.imageType = VK_IMAGE_TYPE_2D;
     ci.extent = { w,h,1 };
-    ci.mipLevels = 1; ci.arrayLayers = 1;
+    ci.mipLevels = mipLevels; ci.arrayLayers = 1;
     ci.format = fmt; ci.tiling = tiling;
     ci.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
     ci.usage = usage;
@@ -1963,52 +3513,29 @@ void HelloTriangleApplication::createImage(uint32_t w, uint32_t h, VkFormat fmt,
     ci.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
     if (vkCreateImage(device, &ci, nullptr, &image) != VK_SUCCESS) throw std::runtime_error("createImage failed");
     VkMemoryRequirements req{}; vkGetImageMemoryRequirements(device, image, &req);
-    VkMemoryAllocateInfo ai{ VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
-    ai.allocationSize = req.size;
-    ai.memoryTypeIndex = findMemoryType(req.memoryTypeBits, props);
-    if (vkAllocateMemory(device, &ai, nullptr, &memory) != VK_SUCCESS) throw std::runtime_error("alloc image mem fail");
-    vkBindImageMemory(device, image, memory, 0);
+    memory = allocator.allocate(req, props, tiling == VK_IMAGE_TILING_OPTIMAL);
+    vkBindImageMemory(device, image, memory.memory, memory.offset);
 }
-VkImageView HelloTriangleApplication::createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspect) {
+VkImageView HelloTriangleApplication::createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspect,
+    uint32_t mipLevels, uint32_t baseMipLevel) {
     VkImageViewCreateInfo vi{ VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO };
     vi.image = image; vi.viewType = VK_IMAGE_VIEW_TYPE_2D; vi.format = format;
     vi.subresourceRange.aspectMask = aspect;
-    vi.subresourceRange.baseMipLevel = 0; vi.subresourceRange.levelCount = 1;
+    vi.subresourceRange.baseMipLevel = baseMipLevel; vi.subresourceRange.levelCount = mipLevels;
     vi.subresourceRange.baseArrayLayer = 0; vi.subresourceRange.layerCount = 1;
     VkImageView view;
     if (vkCreateImageView(device, &vi, nullptr, &view) != VK_SUCCESS) throw std::runtime_error("createImageView fail");
     return view;
 }
-VkCommandBuffer HelloTriangleApplication::beginSingleTimeCommands() {
-    VkCommandBufferAllocateInfo ai{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO };
-    ai.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-    ai.commandPool = commandPool;
-    ai.commandBufferCount = 1;
-    VkCommandBuffer cb; vkAllocateCommandBuffers(device, &ai, &cb);
-    VkCommandBufferBeginInfo bi{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
-    bi.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-    vkBeginCommandBuffer(cb, &bi);
-    return cb;
-}
-void HelloTriangleApplication::endSingleTimeCommands(VkCommandBuffer cb) {
-    vkEndCommandBuffer(cb);
-    VkSubmitInfo si{ VK_STRUCTURE_TYPE_SUBMIT_INFO };
-    si.commandBufferCount = 1; si.pCommandBuffers = &cb;
-    vkQueueSubmit(graphicsQueue, 1, &si, VK_NULL_HANDLE);
-    vkQueueWaitIdle(graphicsQueue);
-    vkFreeCommandBuffers(device, commandPool, 1, &cb);
-}
-
 void HelloTriangleApplication::transitionImageLayout(
     VkImage image,
     VkFormat /*fmt*/,
     VkImageLayout oldL,
     VkImageLayout newL,
-    VkImageAspectFlags aspect)
+    VkImageAspectFlags aspect,
+    uint32_t mipLevels)
 {
-    VkCommandBuffer cmd = beginSingleTimeCommands();
-
-    VkImageMemoryBarrier b{ VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
+    VkImageMemoryBarrier2 b{ VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2 };
     b.oldLayout = oldL;
     b.newLayout = newL;
     b.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
@@ -2016,61 +3543,24 @@ void HelloTriangleApplication::transitionImageLayout(
     b.image = image;
     b.subresourceRange.aspectMask = aspect;
     b.subresourceRange.baseMipLevel = 0;
-    b.subresourceRange.levelCount = 1;
+    b.subresourceRange.levelCount = mipLevels;
     b.subresourceRange.baseArrayLayer = 0;
     b.subresourceRange.layerCount = 1;
 
-    VkPipelineStageFlags srcStage{};
-    VkPipelineStageFlags dstStage{};
-
-    if (oldL == VK_IMAGE_LAYOUT_UNDEFINED &&
-        newL == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
-        b.srcAccessMask = 0;
-        b.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-        srcStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-        dstStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-    }
-    else if (oldL == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL &&
-        newL == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) {
-        b.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-        b.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-        srcStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-        dstStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-    }
-    // NEW CASE: for depth images
-    else if (oldL == VK_IMAGE_LAYOUT_UNDEFINED &&
-        newL == VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL) {
-        b.srcAccessMask = 0;
-        b.dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT |
-            VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-        srcStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-        dstStage = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-    }
-    else {
-        throw std::invalid_argument("unsupported layout transition!");
-    }
+    // any pair of layouts the graph knows; throws std::invalid_argument otherwise
+    const RenderGraph::Access src = RenderGraph::accessForLayout(oldL);
+    const RenderGraph::Access dst = RenderGraph::accessForLayout(newL);
+    b.srcStageMask = src.stages;
+    b.srcAccessMask = src.write ? src.access : 0;   // only writes need flushing
+    b.dstStageMask = dst.stages;
+    b.dstAccessMask = dst.access;
 
-    vkCmdPipelineBarrier(
-        cmd,
-        srcStage, dstStage,
-        0,
-        0, nullptr,
-        0, nullptr,
-        1, &b
-    );
-
-    endSingleTimeCommands(cmd);
+    uploads.imageBarrier(b);
 }
 
 
-void HelloTriangleApplication::copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t w, uint32_t h) {
-    VkCommandBuffer cmd = beginSingleTimeCommands();
-    VkBufferImageCopy r{};
-    r.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    r.imageSubresource.layerCount = 1;
-    r.imageExtent = { w,h,1 };
-    vkCmdCopyBufferToImage(cmd, buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &r);
-    endSingleTimeCommands(cmd);
+void HelloTriangleApplication::copyBufferToImage(VkBuffer buffer, VkDeviceSize offset, VkImage image, uint32_t w, uint32_t h) {
+    uploads.copyBufferToImage(buffer, offset, image, w, h);
 }
 
 void HelloTriangleApplication::framebufferResizeCallback(GLFWwindow* window, int, int) {
@@ -2078,8 +3568,75 @@ void HelloTriangleApplication::framebufferResizeCallback(GLFWwindow* window, int
     app->framebufferResized = true;
 }
 
-int main() {
-    try { HelloTriangleApplication().run(); }
+int main(int argc, char** argv) {
+    CpuProfiler::setThreadName("main");
+    AppOptions opts;
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        if (a == "--bench-alloc") opts.benchAllocator = true;
+        else if (a == "--post" && i + 1 < argc) {
+            std::string v = argv[++i];
+            if (v == "glow") opts.post = PostEffect::Glow;
+            else if (v == "box") opts.post = PostEffect::BoxBlur;
+            else if (v == "gaussian") opts.post = PostEffect::Gaussian;
+            else { std::cerr << "Unknown post effect: " << v << std::endl; return EXIT_FAILURE; }
+        }
+        else if (a == "--blur-radius" && i + 1 < argc) opts.blurRadius = std::atoi(argv[++i]);
+        else if (a == "--blur-sigma" && i + 1 < argc) {
+            opts.blurSigma = (float)std::atof(argv[++i]);
+            // the Gaussian weights divide by sigma; zero or negative gives NaN
+            if (!(opts.blurSigma > 0.0f) || !std::isfinite(opts.blurSigma)) {
+                std::cerr << "Bad --blur-sigma, expected a positive number: " << argv[i] << std::endl; return EXIT_FAILURE;
+            }
+        }
+        else if (a == "--compute") opts.computePost = true;
+        else if (a == "--bench-post") opts.benchPost = true;
+        else if (a == "--headless") opts.headless = true;
+        else if (a == "--frames" && i + 1 < argc) opts.frames = (uint32_t)std::max(1, std::atoi(argv[++i]));
+        else if (a == "--size" && i + 1 < argc) {
+            unsigned w = 0, h = 0;
+            if (std::sscanf(argv[++i], "%ux%u", &w, &h) != 2 || !w || !h) {
+                std::cerr << "Bad --size, expected WxH: " << argv[i] << std::endl; return EXIT_FAILURE;
+            }
+            opts.width = w; opts.height = h;
+        }
+        else if (a == "--output" && i + 1 < argc) opts.output = argv[++i];
+        else if (a == "--trace" && i + 1 < argc) opts.trace = argv[++i];
+        else if (a == "--stress" && i + 1 < argc) opts.stressCubes = (uint32_t)std::max(0, std::atoi(argv[++i]));
+        else if (a == "--bench-instancing") opts.benchInstancing = true;
+        else if (a == "--bench-normals") opts.benchNormals = true;
+        else if (a == "--record-threads" && i + 1 < argc) opts.recordThreads = std::max(0, std::atoi(argv[++i]));
+        else if (a == "--bench-recording") opts.benchRecording = true;
+        else if (a == "--latency" && i + 1 < argc) {
+            std::string v = argv[++i];
+            if (v == "low") opts.latency = LatencyProfile::LowLatency;
+            else if (v == "balanced") opts.latency = LatencyProfile::Balanced;
+            else if (v == "throughput") opts.latency = LatencyProfile::Throughput;
+            else { std::cerr << "Unknown latency profile: " << v << std::endl; return EXIT_FAILURE; }
+        }
+        else if (a == "--frames-in-flight" && i + 1 < argc)
+            opts.framesInFlight = (uint32_t)std::clamp(std::atoi(argv[++i]), 1, (int)MAX_FRAMES_IN_FLIGHT);
+        else if (a == "--frame-log" && i + 1 < argc) opts.frameLog = argv[++i];
+        else if (a == "--vertex-format" && i + 1 < argc) {
+            std::string v = argv[++i];
+            if (v == "float") opts.vertexFormat = VertexEncoding::Float32;
+            else if (v == "compact") opts.vertexFormat = VertexEncoding::Compact;
+            else if (v == "quantized") opts.vertexFormat = VertexEncoding::Quantized;
+            else { std::cerr << "Unknown vertex format: " << v << std::endl; return EXIT_FAILURE; }
+        }
+        else if (a == "--bench-vertex-formats") opts.benchVertexFormats = true;
+        else if (a == "--terrain") opts.terrain = true;
+        else if (a == "--terrain-radius" && i + 1 < argc) opts.terrainRadius = std::clamp(std::atoi(argv[++i]), 1, 16);
+        else if (a == "--bench-terrain") opts.benchTerrain = true;
+        else { std::cerr << "Unknown option: " << a << std::endl; return EXIT_FAILURE; }
+    }
+
+    if (opts.benchInstancing && opts.stressCubes == 0) opts.stressCubes = 100000;
+    if (opts.benchRecording && opts.stressCubes == 0) opts.stressCubes = 10000;
+    if (opts.benchVertexFormats && opts.stressCubes == 0) opts.stressCubes = 100000;
+    if (opts.benchTerrain) opts.terrain = true;
+
+    try { HelloTriangleApplication(opts).run(); }
     catch (const std::exception& e) { std::cerr << e.what() << std::endl; return EXIT_FAILURE; }
     return EXIT_SUCCESS;
 }
\ No newline at end of file
@@ -0,0 +1,203 @@
+#pragma once
+#include <vector>
+#include <unordered_map>
+#include <type_traits>
+#include <cstring>
+#include <cstdint>
+#include <cstddef>
+
+// --- Mesh optimization -------------------------------------------------------
+// Offline clean-up for generated meshes before they are uploaded:
+//   1. weld: bitwise-identical vertices are merged through a hash table, so a
+//      flat triangle list (or a strip with duplicated seams) becomes a shared
+//      vertex set plus indices;
+//   2. vertex cache: triangles are reordered with Tipsify (Sander, Nehab &
+//      Barczak 2007) so recently transformed vertices are reused while they
+//      are still in the post-transform cache;
+//   3. vertex fetch: vertices are renumbered in first-use order, so the
+//      vertex shader walks the vertex buffer roughly linearly.
+// ACMR (transforms per triangle) and ATVR (transforms per vertex) come from a
+// FIFO cache simulation of `cacheSize` entries, before and after.
+//
+// Strip meshes (Week_3/GeometryUtil.hpp) are converted to lists first.
+//
+// Vertices are compared as raw bytes, so V must be trivially copyable with no
+// padding; +0.0 and -0.0 (or different NaNs) stay separate.
+
+struct MeshOptStats {
+    uint32_t verticesIn = 0, verticesOut = 0, triangles = 0;
+    float acmrBefore = 0.0f, acmrAfter = 0.0f;
+    float atvrBefore = 0.0f, atvrAfter = 0.0f;
+};
+
+template <class V>
+struct OptimizedMesh {
+    std::vector<V> vertices;
+    std::vector<uint32_t> indices;
+    MeshOptStats stats;
+};
+
+// Number of vertex shader invocations `indices` costs with a FIFO cache.
+inline uint32_t simulateVertexCache(const std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t cacheSize) {
+    // a FIFO entry is still resident while fewer than cacheSize misses followed it
+    std::vector<uint32_t> insertedAt(vertexCount, 0);   // 1-based miss count, 0 = never loaded
+    uint32_t misses = 0;
+    for (uint32_t v : indices) {
+        if (insertedAt[v] != 0 && misses - insertedAt[v] < cacheSize) continue;
+        insertedAt[v] = ++misses;
+    }
+    return misses;
+}
+
+// Merges identical vertices. Returns the index list into `unique`.
+template <class V>
+std::vector<uint32_t> weldVertices(const std::vector<V>& vertices, const std::vector<uint32_t>& indices, std::vector<V>& unique) {
+    static_assert(std::is_trivially_copyable_v<V>, "weldVertices compares vertices bytewise");
+
+    auto hash = [&](uint32_t i) {
+        const unsigned char* p = reinterpret_cast<const unsigned char*>(&vertices[i]);
+        uint64_t h = 14695981039346656037ull;   // FNV-1a
+        for (size_t b = 0; b < sizeof(V); ++b) h = (h ^ p[b]) * 1099511628211ull;
+        return (size_t)h;
+    };
+    auto equal = [&](uint32_t a, uint32_t b) { return std::memcmp(&vertices[a], &vertices[b], sizeof(V)) == 0; };
+    std::unordered_map<uint32_t, uint32_t, decltype(hash), decltype(equal)> seen(vertices.size(), hash, equal);
+
+    std::vector<uint32_t> remap(vertices.size());
+    unique.clear();
+    for (uint32_t i = 0; i < (uint32_t)vertices.size(); ++i) {
+        auto [it, inserted] = seen.try_emplace(i, (uint32_t)unique.size());
+        if (inserted) unique.push_back(vertices[i]);
+        remap[i] = it->second;
+    }
+
+    std::vector<uint32_t> out;
+    out.reserve(indices.empty() ? vertices.size() : indices.size());
+    if (indices.empty()) out = remap;
+    else for (uint32_t i : indices) out.push_back(remap[i]);
+    return out;
+}
+
+// Tipsify: reorders triangles for a post-transform cache of `cacheSize`.
+inline std::vector<uint32_t> optimizeVertexCache(const std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t cacheSize) {
+    const uint32_t triCount = (uint32_t)(indices.size() / 3);
+
+    // vertex -> triangles adjacency, CSR
+    std::vector<uint32_t> live(vertexCount, 0), offsets(vertexCount + 1, 0), adjacency(triCount * 3);
+    for (uint32_t v : indices) live[v]++;
+    for (uint32_t v = 0; v < vertexCount; ++v) offsets[v + 1] = offsets[v] + live[v];
+    std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+    for (uint32_t i = 0; i < triCount * 3; ++i) adjacency[fill[indices[i]]++] = i / 3;
+
+    std::vector<uint32_t> cacheTime(vertexCount, 0);
+    std::vector<bool> emitted(triCount, false);
+    std::vector<uint32_t> deadEnd, candidates, out;
+    out.reserve(triCount * 3);
+    uint32_t time = cacheSize + 1, cursor = 1;
+    int64_t fan = vertexCount ? 0 : -1;
+
+    while (fan >= 0) {
+        candidates.clear();
+        for (uint32_t a = offsets[fan]; a < offsets[fan + 1]; ++a) {
+            uint32_t t = adjacency[a];
+            if (emitted[t]) continue;
+            emitted[t] = true;
+            for (uint32_t k = 0; k < 3; ++k) {
+                uint32_t v = indices[t * 3 + k];
+                out.push_back(v);
+                deadEnd.push_back(v);
+                candidates.push_back(v);
+                live[v]--;
+                if (time - cacheTime[v] > cacheSize) cacheTime[v] = time++;
+            }
+        }
+
+        // next fan: the candidate still in cache that will stay there longest
+        // once its remaining triangles are emitted
+        fan = -1;
+        int64_t best = -1;
+        for (uint32_t v : candidates) {
+            if (live[v] == 0) continue;
+            int64_t p = 0;
+            if (time - cacheTime[v] + 2 * live[v] <= cacheSize) p = time - cacheTime[v];
+            if (p > best) { best = p; fan = v; }
+        }
+        if (fan >= 0) continue;
+
+        while (!deadEnd.empty()) {
+            uint32_t v = deadEnd.back();
+            deadEnd.pop_back();
+            if (live[v] > 0) { fan = v; break; }
+        }
+        while (fan < 0 && cursor < vertexCount) {
+            if (live[cursor] > 0) fan = cursor;
+            cursor++;
+        }
+    }
+    return out;
+}
+
+// Renumbers vertices in first-use order; drops unreferenced ones.
+template <class V>
+void optimizeVertexFetch(std::vector<V>& vertices, std::vector<uint32_t>& indices) {
+    std::vector<uint32_t> remap(vertices.size(), UINT32_MAX);
+    std::vector<V> ordered;
+    ordered.reserve(vertices.size());
+    for (uint32_t& i : indices) {
+        if (remap[i] == UINT32_MAX) {
+            remap[i] = (uint32_t)ordered.size();
+            ordered.push_back(vertices[i]);
+        }
+        i = remap[i];
+    }
+    vertices.swap(ordered);
+}
+
+// Triangle strips with `restart` between them (GeometryUtil's generators) to
+// a triangle list with the same winding and provoking vertices; degenerate
+// triangles are dropped.
+inline std::vector<uint32_t> stripToTriangleList(const std::vector<uint32_t>& strip, uint32_t restart = 0xFFFFFFFFu) {
+    std::vector<uint32_t> out;
+    out.reserve(strip.size() * 3);
+    size_t start = 0;
+    for (size_t i = 0; i < strip.size(); ++i) {
+        if (strip[i] == restart) { start = i + 1; continue; }
+        if (i - start < 2) continue;
+        uint32_t a = strip[i - 2], b = strip[i - 1], c = strip[i];
+        if (a == b || b == c || a == c) continue;
+        if ((i - start) & 1) out.insert(out.end(), { a, c, b });
+        else out.insert(out.end(), { a, b, c });
+    }
+    return out;
+}
+
+// Full pipeline. An empty `indices` means `vertices` is a plain triangle list;
+// strips go through stripToTriangleList first.
+template <class V>
+OptimizedMesh<V> optimizeMesh(const std::vector<V>& vertices, const std::vector<uint32_t>& indices = {}, uint32_t cacheSize = 16) {
+    OptimizedMesh<V> m;
+    std::vector<uint32_t> original = indices;
+    if (original.empty()) {
+        original.resize(vertices.size());
+        for (uint32_t i = 0; i < (uint32_t)original.size(); ++i) original[i] = i;
+    }
+
+    MeshOptStats& s = m.stats;
+    s.verticesIn = (uint32_t)vertices.size();
+    s.triangles = (uint32_t)(original.size() / 3);
+    uint32_t before = simulateVertexCache(original, s.verticesIn, cacheSize);
+
+    std::vector<uint32_t> welded = weldVertices(vertices, original, m.vertices);
+    m.indices = optimizeVertexCache(welded, (uint32_t)m.vertices.size(), cacheSize);
+    optimizeVertexFetch(m.vertices, m.indices);
+
+    s.verticesOut = (uint32_t)m.vertices.size();
+    uint32_t after = simulateVertexCache(m.indices, s.verticesOut, cacheSize);
+    if (s.triangles) {
+        s.acmrBefore = (float)before / s.triangles;
+        s.acmrAfter = (float)after / s.triangles;
+    }
+    if (s.verticesIn) s.atvrBefore = (float)before / s.verticesIn;
+    if (s.verticesOut) s.atvrAfter = (float)after / s.verticesOut;
+    return m;
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <cstddef>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define NORMAL_MATRIX_SSE 1
+#endif
+
+// --- Normal matrices ---------------------------------------------------------
+// transpose(inverse(mat3(model))) for many transforms at once, so shaders can
+// read a precomputed normal matrix instead of inverting per vertex/fragment.
+//
+// Output is glm::mat3x4: three vec4 columns, the std140/std430 layout of a
+// GLSL mat3. Uses the cofactor form N = [c1 x c2, c2 x c0, c0 x c1] / det,
+// where c0..c2 are the columns of the upper 3x3. With SSE, four matrices are
+// transposed into SoA registers and solved together; the remainder (and
+// non-SSE targets) take the scalar path. Singular input yields inf/nan.
+
+inline glm::mat3x4 normalMatrix(const glm::mat4& m) {
+    glm::vec3 c0(m[0]), c1(m[1]), c2(m[2]);
+    glm::vec3 n0 = glm::cross(c1, c2), n1 = glm::cross(c2, c0), n2 = glm::cross(c0, c1);
+    float invDet = 1.0f / glm::dot(c0, n0);
+    return glm::mat3x4(glm::vec4(n0 * invDet, 0.0f), glm::vec4(n1 * invDet, 0.0f), glm::vec4(n2 * invDet, 0.0f));
+}
+
+// `models` and `out` are read/written with the given byte strides so the
+// routine can fill a field of an interleaved array (e.g. per-instance data).
+inline void normalMatrices(const glm::mat4* models, size_t modelStride, glm::mat3x4* out, size_t outStride, size_t count) {
+    auto model = [&](size_t i) -> const glm::mat4& {
+        return *reinterpret_cast<const glm::mat4*>(reinterpret_cast<const char*>(models) + i * modelStride);
+    };
+    auto result = [&](size_t i) -> glm::mat3x4& {
+        return *reinterpret_cast<glm::mat3x4*>(reinterpret_cast<char*>(out) + i * outStride);
+    };
+
+    size_t i = 0;
+#ifdef NORMAL_MATRIX_SSE
+    for (; i + 4 <= count; i += 4) {
+        // c[k][r]: row r of column k, one lane per matrix
+        __m128 c[3][4];
+        for (int k = 0; k < 3; ++k) {
+            c[k][0] = _mm_loadu_ps(&model(i + 0)[k][0]);
+            c[k][1] = _mm_loadu_ps(&model(i + 1)[k][0]);
+            c[k][2] = _mm_loadu_ps(&model(i + 2)[k][0]);
+            c[k][3] = _mm_loadu_ps(&model(i + 3)[k][0]);
+            _MM_TRANSPOSE4_PS(c[k][0], c[k][1], c[k][2], c[k][3]);
+        }
+
+        auto cross = [](const __m128* a, const __m128* b, __m128* r) {
+            r[0] = _mm_sub_ps(_mm_mul_ps(a[1], b[2]), _mm_mul_ps(a[2], b[1]));
+            r[1] = _mm_sub_ps(_mm_mul_ps(a[2], b[0]), _mm_mul_ps(a[0], b[2]));
+            r[2] = _mm_sub_ps(_mm_mul_ps(a[0], b[1]), _mm_mul_ps(a[1], b[0]));
+            r[3] = _mm_setzero_ps();
+        };
+        __m128 n[3][4];
+        cross(c[1], c[2], n[0]);
+        cross(c[2], c[0], n[1]);
+        cross(c[0], c[1], n[2]);
+
+        __m128 det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(c[0][0], n[0][0]), _mm_mul_ps(c[0][1], n[0][1])),
+            _mm_mul_ps(c[0][2], n[0][2]));
+        __m128 invDet = _mm_div_ps(_mm_set1_ps(1.0f), det);
+
+        for (int k = 0; k < 3; ++k) {
+            n[k][0] = _mm_mul_ps(n[k][0], invDet);
+            n[k][1] = _mm_mul_ps(n[k][1], invDet);
+            n[k][2] = _mm_mul_ps(n[k][2], invDet);
+            _MM_TRANSPOSE4_PS(n[k][0], n[k][1], n[k][2], n[k][3]);
+            _mm_storeu_ps(&result(i + 0)[k][0], n[k][0]);
+            _mm_storeu_ps(&result(i + 1)[k][0], n[k][1]);
+            _mm_storeu_ps(&result(i + 2)[k][0], n[k][2]);
+            _mm_storeu_ps(&result(i + 3)[k][0], n[k][3]);
+        }
+    }
+#endif
+    for (; i < count; ++i) result(i) = normalMatrix(model(i));
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <stdexcept>
+#include <cstdint>
+
+// --- Parallel command recording ---------------------------------------------
+// Secondary command buffers for recording one dynamic-rendering instance from
+// several threads. Every (frame in flight, thread slot) pair has its own
+// transient command pool, so a slot is only ever touched by the one job
+// recording into it and no pool is shared between threads. beginFrame()
+// resets the frame's pools wholesale once its fence has signalled; buffers
+// are kept and handed out again rather than freed.
+
+class ParallelRecorder {
+public:
+    void init(VkDevice dev, uint32_t queueFamily, uint32_t framesInFlight, uint32_t threadSlots) {
+        device = dev;
+        threads = threadSlots ? threadSlots : 1;
+        pools.resize((size_t)framesInFlight * threads);
+        for (Pool& p : pools) {
+            VkCommandPoolCreateInfo ci{ VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO };
+            ci.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+            ci.queueFamilyIndex = queueFamily;
+            if (vkCreateCommandPool(device, &ci, nullptr, &p.pool) != VK_SUCCESS)
+                throw std::runtime_error("ParallelRecorder: failed to create command pool");
+        }
+    }
+
+    void destroy() {
+        for (Pool& p : pools) vkDestroyCommandPool(device, p.pool, nullptr);
+        pools.clear();
+    }
+
+    uint32_t threadCount() const { return threads; }
+
+    // Call after waiting on `frame`'s fence, before any begin() for it.
+    void beginFrame(uint32_t frame) {
+        current = frame;
+        for (uint32_t t = 0; t < threads; ++t) {
+            Pool& p = pools[(size_t)frame * threads + t];
+            vkResetCommandPool(device, p.pool, 0);
+            p.used = 0;
+        }
+    }
+
+    // Begin a secondary that continues the primary's vkCmdBeginRendering
+    // (started with VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT).
+    // `statistics` must equal the flags of any pipeline-statistics query
+    // active in the primary. The caller ends the buffer.
+    VkCommandBuffer begin(uint32_t thread, const VkCommandBufferInheritanceRenderingInfo& rendering,
+        VkQueryPipelineStatisticFlags statistics = 0)
+    {
+        Pool& p = pools[(size_t)current * threads + thread];
+        if (p.used == p.buffers.size()) {
+            VkCommandBufferAllocateInfo ai{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO };
+            ai.commandPool = p.pool;
+            ai.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+            ai.commandBufferCount = 1;
+            VkCommandBuffer cb;
+            if (vkAllocateCommandBuffers(device, &ai, &cb) != VK_SUCCESS)
+                throw std::runtime_error("ParallelRecorder: failed to allocate secondary command buffer");
+            p.buffers.push_back(cb);
+        }
+        VkCommandBuffer cb = p.buffers[p.used++];
+
+        VkCommandBufferInheritanceInfo inh{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO };
+        inh.pNext = &rendering;
+        inh.pipelineStatistics = statistics;
+
+        VkCommandBufferBeginInfo bi{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+        bi.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+        bi.pInheritanceInfo = &inh;
+        if (vkBeginCommandBuffer(cb, &bi) != VK_SUCCESS)
+            throw std::runtime_error("ParallelRecorder: failed to begin secondary command buffer");
+        return cb;
+    }
+
+private:
+    struct Pool {
+        VkCommandPool pool = VK_NULL_HANDLE;
+        std::vector<VkCommandBuffer> buffers;
+        size_t used = 0;
+    };
+
+    VkDevice device = VK_NULL_HANDLE;
+    uint32_t threads = 1, current = 0;
+    std::vector<Pool> pools;   // [frame * threads + thread]
+};
@@ -0,0 +1,116 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <stdexcept>
+
+// --- Persistent pipeline cache --------------------------------------------
+// Wraps a VkPipelineCache that is seeded from a file on disk and written back
+// after pipelines are built. The blob's header is checked against the current
+// device before use; anything stale or corrupt is dropped and we start empty.
+
+class PipelineCache {
+public:
+    static constexpr const char* DEFAULT_PATH = "pipeline_cache.bin";
+
+    void init(VkPhysicalDevice gpu, VkDevice dev, const std::string& filePath = DEFAULT_PATH) {
+        device = dev;
+        path = filePath;
+
+        VkPhysicalDeviceProperties props{};
+        vkGetPhysicalDeviceProperties(gpu, &props);
+
+        std::vector<char> blob = readFile(path);
+        warm = !blob.empty() && validate(blob, props, rejectReason);
+        if (!warm) blob.clear();
+
+        VkPipelineCacheCreateInfo ci{ VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO };
+        ci.initialDataSize = blob.size();
+        ci.pInitialData = blob.empty() ? nullptr : blob.data();
+        if (vkCreatePipelineCache(device, &ci, nullptr, &cache) != VK_SUCCESS) {
+            // the driver has the final say on the blob; retry without it
+            warm = false;
+            rejectReason = "driver rejected cache data";
+            ci.initialDataSize = 0;
+            ci.pInitialData = nullptr;
+            if (vkCreatePipelineCache(device, &ci, nullptr, &cache) != VK_SUCCESS)
+                throw std::runtime_error("failed to create pipeline cache");
+        }
+    }
+
+    // Write the cache back to disk. Goes through a temp file so a crash
+    // mid-write can never leave a truncated blob behind.
+    bool save() const {
+        if (cache == VK_NULL_HANDLE) return false;
+        size_t size = 0;
+        if (vkGetPipelineCacheData(device, cache, &size, nullptr) != VK_SUCCESS || size == 0)
+            return false;
+        std::vector<char> data(size);
+        if (vkGetPipelineCacheData(device, cache, &size, data.data()) != VK_SUCCESS)
+            return false;
+
+        std::string tmp = path + ".tmp";
+        {
+            std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+            if (!out) return false;
+            out.write(data.data(), (std::streamsize)size);
+            if (!out) return false;
+        }
+        std::remove(path.c_str());
+        return std::rename(tmp.c_str(), path.c_str()) == 0;
+    }
+
+    void destroy() {
+        if (cache != VK_NULL_HANDLE) vkDestroyPipelineCache(device, cache, nullptr);
+        cache = VK_NULL_HANDLE;
+    }
+
+    VkPipelineCache handle() const { return cache; }
+    bool isWarm() const { return warm; }                        // seeded from a valid file
+    const std::string& whyCold() const { return rejectReason; } // empty if there was no file
+
+private:
+    VkDevice device = VK_NULL_HANDLE;
+    VkPipelineCache cache = VK_NULL_HANDLE;
+    std::string path;
+    std::string rejectReason;
+    bool warm = false;
+
+    static std::vector<char> readFile(const std::string& p) {
+        std::ifstream f(p, std::ios::ate | std::ios::binary);
+        if (!f.is_open()) return {};
+        std::streamoff len = f.tellg();
+        if (len <= 0) return {};
+        std::vector<char> buf((size_t)len);
+        f.seekg(0);
+        f.read(buf.data(), len);
+        if (!f) return {};
+        return buf;
+    }
+
+    static bool validate(const std::vector<char>& blob, const VkPhysicalDeviceProperties& props,
+        std::string& reason)
+    {
+        VkPipelineCacheHeaderVersionOne hdr{};
+        if (blob.size() < sizeof(hdr)) { reason = "file shorter than header"; return false; }
+        memcpy(&hdr, blob.data(), sizeof(hdr));
+
+        if (hdr.headerSize < sizeof(hdr) || hdr.headerSize > blob.size()) {
+            reason = "bad header size"; return false;
+        }
+        if (hdr.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE) {
+            reason = "unknown header version"; return false;
+        }
+        if (hdr.vendorID != props.vendorID || hdr.deviceID != props.deviceID) {
+            reason = "different GPU"; return false;
+        }
+        if (memcmp(hdr.pipelineCacheUUID, props.pipelineCacheUUID, VK_UUID_SIZE) != 0) {
+            reason = "driver version changed"; return false;
+        }
+        return true;
+    }
+};
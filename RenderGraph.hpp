@@ -0,0 +1,606 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <string>
+#include <functional>
+#include <stdexcept>
+#include <algorithm>
+#include <cstdint>
+
+#include "GpuAllocator.hpp"
+
+// --- Render graph ------------------------------------------------------------
+// Each frame the app declares its passes in submission order: the images each
+// one reads and writes, how (RenderGraph::Use), and a callback that records
+// it. compile() then
+//  - culls passes whose results never reach an imported image,
+//  - allocates the transient images the surviving passes touch; transients
+//    whose lifetimes (first to last live pass) don't overlap share memory,
+// and execute() records the live passes, deriving the barriers between them
+// from the declared uses and merging each pass's into one vkCmdPipelineBarrier2.
+//
+// Transients keep their VkImage across frames while the set of live
+// transients and their lifetimes stay the same. When that changes (first
+// frame, resize, another post path) compile() reallocates and returns true so
+// descriptors can be rewritten. The replaced images go to the retire callback
+// if one is set (see setRetire), otherwise compile() waits for the device to
+// go idle and destroys them on the spot.
+// A transient's contents never survive into the next frame: its first use in
+// a frame must be a write.
+
+class RenderGraph {
+public:
+    using ImageId = uint32_t;
+    static constexpr uint32_t ALL_MIPS = ~0u;
+
+    enum class Use {
+        ColorAttachment,    // written by vkCmdBeginRendering / draws
+        DepthAttachment,
+        SampledFragment,    // combined image sampler, SHADER_READ_ONLY_OPTIMAL
+        SampledCompute,
+        GeneralRead,        // read by compute in GENERAL (sampled or loaded)
+        StorageWrite,       // storage image written by compute, GENERAL
+        TransferSrc,
+        TransferDst,
+    };
+
+    struct Access {
+        VkPipelineStageFlags2 stages = VK_PIPELINE_STAGE_2_NONE;
+        VkAccessFlags2        access = 0;
+        VkImageLayout         layout = VK_IMAGE_LAYOUT_UNDEFINED;
+        bool                  write = false;
+        VkImageUsageFlags     usage = 0;
+    };
+
+    static Access access(Use use) {
+        switch (use) {
+        case Use::ColorAttachment:
+            return { VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
+                VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, true, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT };
+        case Use::DepthAttachment:
+            return { VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+                VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+                VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL, true, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT };
+        case Use::SampledFragment:
+            return { VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT,
+                VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, false, VK_IMAGE_USAGE_SAMPLED_BIT };
+        case Use::SampledCompute:
+            return { VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT,
+                VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, false, VK_IMAGE_USAGE_SAMPLED_BIT };
+        case Use::GeneralRead:
+            return { VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                VK_ACCESS_2_SHADER_SAMPLED_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_READ_BIT,
+                VK_IMAGE_LAYOUT_GENERAL, false, VK_IMAGE_USAGE_SAMPLED_BIT };
+        case Use::StorageWrite:
+            return { VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+                VK_IMAGE_LAYOUT_GENERAL, true, VK_IMAGE_USAGE_STORAGE_BIT };
+        case Use::TransferSrc:
+            return { VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_READ_BIT,
+                VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, false, VK_IMAGE_USAGE_TRANSFER_SRC_BIT };
+        case Use::TransferDst:
+            return { VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT,
+                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, true, VK_IMAGE_USAGE_TRANSFER_DST_BIT };
+        }
+        throw std::runtime_error("RenderGraph: unknown use");
+    }
+
+    // The stages/accesses that typically touch an image in `layout`, for
+    // one-off transitions recorded outside a graph.
+    static Access accessForLayout(VkImageLayout layout) {
+        switch (layout) {
+        case VK_IMAGE_LAYOUT_UNDEFINED:
+        case VK_IMAGE_LAYOUT_PRESENT_SRC_KHR:
+            return { VK_PIPELINE_STAGE_2_NONE, 0, layout };
+        case VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL:   return access(Use::TransferDst);
+        case VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL:   return access(Use::TransferSrc);
+        case VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL: return access(Use::ColorAttachment);
+        case VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL:
+        case VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL: {
+            Access a = access(Use::DepthAttachment);
+            a.layout = layout;
+            return a;
+        }
+        case VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL:
+            return { VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                VK_ACCESS_2_SHADER_SAMPLED_READ_BIT, layout };
+        case VK_IMAGE_LAYOUT_GENERAL:
+            return { VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, VK_ACCESS_2_MEMORY_READ_BIT | VK_ACCESS_2_MEMORY_WRITE_BIT,
+                layout, true };
+        default:
+            throw std::invalid_argument("RenderGraph: no access mapping for this image layout");
+        }
+    }
+
+    struct ImageDesc {
+        VkExtent2D         extent{};
+        VkFormat           format = VK_FORMAT_UNDEFINED;
+        uint32_t           mipLevels = 1;
+        VkImageAspectFlags aspect = VK_IMAGE_ASPECT_COLOR_BIT;
+    };
+
+    struct Stats {
+        uint32_t     passes = 0;          // declared last compile
+        uint32_t     culled = 0;
+        uint32_t     transients = 0;      // allocated (live) transients
+        uint32_t     allocations = 0;     // memory ranges backing them
+        VkDeviceSize bytes = 0;           // with aliasing
+        VkDeviceSize unaliasedBytes = 0;  // one range per transient
+    };
+
+    class PassBuilder {
+    public:
+        PassBuilder& read(ImageId id, Use use) { return add(id, use, false); }
+        PassBuilder& write(ImageId id, Use use) { return add(id, use, false); }
+        // The pass records its own transitions on `id` and ends with it ready
+        // for `use` (e.g. a mip chain left readable level by level).
+        PassBuilder& leaves(ImageId id, Use use) { return add(id, use, true); }
+    private:
+        friend class RenderGraph;
+        PassBuilder(RenderGraph& g, uint32_t p) : graph(g), pass(p) {}
+        PassBuilder& add(ImageId id, Use use, bool exit) {
+            (exit ? graph.passes[pass].exits : graph.passes[pass].refs).push_back({ id, use });
+            return *this;
+        }
+        RenderGraph& graph;
+        uint32_t pass;
+    };
+
+    void init(VkDevice dev, GpuAllocator& alloc) {
+        device = dev;
+        allocator = &alloc;
+    }
+
+    void destroy() {
+        if (allocator) release(device, *allocator, physical, slots);
+        cachedKeys.clear();
+        device = VK_NULL_HANDLE;
+    }
+
+    // Receives the destruction of replaced transients, to run once no frame
+    // in flight can still be using them.
+    using Retire = std::function<void(std::function<void()>)>;
+    void setRetire(Retire r) { retire = std::move(r); }
+
+    // Start declaring a frame. Physical transients are kept.
+    void reset() {
+        images.clear();
+        passes.clear();
+    }
+
+    ImageId createImage(const char* name, const ImageDesc& desc) {
+        Image img;
+        img.name = name;
+        img.desc = desc;
+        images.push_back(img);
+        return (ImageId)images.size() - 1;
+    }
+
+    // An image owned elsewhere (e.g. the swapchain image). `readyStages` is
+    // what its first use must wait behind (the acquire semaphore's wait
+    // stages); after the last pass it is transitioned to `finalLayout`.
+    ImageId importImage(const char* name, VkImage image, VkImageView view, VkImageLayout initialLayout,
+        VkPipelineStageFlags2 readyStages, VkImageLayout finalLayout, VkImageAspectFlags aspect = VK_IMAGE_ASPECT_COLOR_BIT)
+    {
+        Image img;
+        img.name = name;
+        img.imported = true;
+        img.desc.aspect = aspect;
+        img.image = image;
+        img.view = view;
+        img.initialLayout = initialLayout;
+        img.readyStages = readyStages;
+        img.finalLayout = finalLayout;
+        images.push_back(img);
+        return (ImageId)images.size() - 1;
+    }
+
+    PassBuilder addPass(const char* name, std::function<void(VkCommandBuffer)> record) {
+        Pass p;
+        p.name = name;
+        p.record = std::move(record);
+        passes.push_back(std::move(p));
+        return PassBuilder(*this, (uint32_t)passes.size() - 1);
+    }
+
+    // Returns true when transients were (re)allocated: every VkImage/VkImageView
+    // handed out before is gone.
+    bool compile() {
+        cull();
+
+        // lifetimes and usage of the transients the live passes touch
+        for (Image& img : images) { img.first = img.last = -1; img.usage = 0; }
+        for (int p = 0; p < (int)passes.size(); ++p) {
+            if (!passes[p].live) continue;
+            for (const Ref& r : passes[p].refs) {
+                Image& img = images[r.id];
+                if (img.first < 0) img.first = p;
+                img.last = p;
+                img.usage |= access(r.use).usage;
+            }
+        }
+
+        std::vector<Key> keys;
+        for (const Image& img : images)
+            if (!img.imported && img.first >= 0)
+                keys.push_back({ img.name, img.desc, img.usage, img.first, img.last });
+
+        bool rebuilt = false;
+        if (keys != cachedKeys) {
+            if (retire) {
+                retire([dev = device, alloc = allocator, old = std::move(physical), oldSlots = std::move(slots)]() mutable {
+                    release(dev, *alloc, old, oldSlots);
+                });
+                physical.clear();
+                slots.clear();
+            }
+            else {
+                if (device) vkDeviceWaitIdle(device);
+                release(device, *allocator, physical, slots);
+            }
+            allocatePhysical(keys);
+            cachedKeys = keys;
+            rebuilt = true;
+        }
+
+        for (Image& img : images) {
+            img.physical = -1;
+            if (img.imported || img.first < 0) continue;
+            for (size_t i = 0; i < physical.size(); ++i)
+                if (physical[i].name == img.name) img.physical = (int)i;
+        }
+
+        lastStats.passes = (uint32_t)passes.size();
+        lastStats.culled = 0;
+        for (const Pass& p : passes) if (!p.live) lastStats.culled++;
+        return rebuilt;
+    }
+
+    // Record every live pass. beginPass/endPass bracket each one (barriers
+    // included), e.g. for GPU timer scopes.
+    void execute(VkCommandBuffer cb, const std::function<void(const char*)>& beginPass = {},
+        const std::function<void(const char*)>& endPass = {})
+    {
+        std::vector<State> states(images.size());
+        for (size_t i = 0; i < images.size(); ++i) {
+            if (!images[i].imported) continue;
+            states[i].layout = images[i].initialLayout;
+            states[i].writeStages = images[i].readyStages;
+        }
+
+        std::vector<VkImageMemoryBarrier2> barriers;
+        for (int p = 0; p < (int)passes.size(); ++p) {
+            Pass& pass = passes[p];
+            if (!pass.live) continue;
+            if (beginPass) beginPass(pass.name);
+
+            barriers.clear();
+            for (const Ref& r : pass.refs) {
+                Image& img = images[r.id];
+                State& s = states[r.id];
+                if (!img.imported && img.first == p) {
+                    // first use this frame: contents are discarded, but wait for
+                    // whatever last used the memory (an alias or last frame)
+                    if (!access(r.use).write)
+                        throw std::runtime_error("RenderGraph: transient '" + img.name + "' read before it is written");
+                    const Slot& slot = slots[physical[img.physical].slot];
+                    s = State{};
+                    s.writeStages = slot.lastStages;
+                    s.writeAccess = slot.lastAccess;
+                }
+                VkImageMemoryBarrier2 b{ VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2 };
+                if (transition(s, access(r.use), b)) {
+                    b.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                    b.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                    b.image = image(r.id);
+                    b.subresourceRange = { img.desc.aspect, 0, VK_REMAINING_MIP_LEVELS, 0, 1 };
+                    barriers.push_back(b);
+                }
+            }
+            emit(cb, barriers);
+
+            pass.record(cb);
+
+            for (const Ref& r : pass.exits) {
+                Access a = access(r.use);
+                State& s = states[r.id];
+                s.layout = a.layout;
+                s.readStages = a.stages;
+                s.visibleStages = a.stages;
+                s.visibleAccess = a.access;
+            }
+            for (const Ref& r : pass.refs) {
+                Image& img = images[r.id];
+                if (img.imported || img.last != p) continue;
+                Slot& slot = slots[physical[img.physical].slot];
+                slot.lastStages = states[r.id].writeStages | states[r.id].readStages;
+                slot.lastAccess = states[r.id].writeAccess;
+            }
+            if (endPass) endPass(pass.name);
+        }
+
+        // hand imported images back in the layout their owner expects
+        barriers.clear();
+        for (size_t i = 0; i < images.size(); ++i) {
+            const Image& img = images[i];
+            const State& s = states[i];
+            if (!img.imported || img.finalLayout == s.layout || img.finalLayout == VK_IMAGE_LAYOUT_UNDEFINED) continue;
+            VkImageMemoryBarrier2 b{ VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2 };
+            b.srcStageMask = s.writeStages | s.readStages;
+            b.srcAccessMask = s.writeAccess;
+            b.dstStageMask = VK_PIPELINE_STAGE_2_NONE;
+            b.dstAccessMask = 0;
+            b.oldLayout = s.layout;
+            b.newLayout = img.finalLayout;
+            b.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            b.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            b.image = img.image;
+            b.subresourceRange = { img.desc.aspect, 0, VK_REMAINING_MIP_LEVELS, 0, 1 };
+            barriers.push_back(b);
+        }
+        emit(cb, barriers);
+    }
+
+    // Physical handles; VK_NULL_HANDLE for culled or unknown images.
+    VkImage image(ImageId id) const {
+        const Image& img = images[id];
+        if (img.imported) return img.image;
+        return img.physical < 0 ? VK_NULL_HANDLE : physical[img.physical].image;
+    }
+
+    VkImageView view(ImageId id, uint32_t mip = ALL_MIPS) const {
+        const Image& img = images[id];
+        if (img.imported) return img.view;
+        return img.physical < 0 ? VK_NULL_HANDLE : physical[img.physical].viewOf(mip);
+    }
+
+    // By name, for descriptor writes between frames
+    VkImage image(const std::string& name) const {
+        for (const Physical& p : physical) if (p.name == name) return p.image;
+        return VK_NULL_HANDLE;
+    }
+
+    VkImageView view(const std::string& name, uint32_t mip = ALL_MIPS) const {
+        for (const Physical& p : physical) if (p.name == name) return p.viewOf(mip);
+        return VK_NULL_HANDLE;
+    }
+
+    const Stats& stats() const { return lastStats; }
+
+private:
+    struct Ref { ImageId id; Use use; };
+
+    struct Pass {
+        const char* name = "";
+        std::function<void(VkCommandBuffer)> record;
+        std::vector<Ref> refs;    // reads and writes
+        std::vector<Ref> exits;   // leaves()
+        bool live = true;
+    };
+
+    struct Image {
+        std::string name;
+        ImageDesc desc;
+        bool imported = false;
+        VkImage image = VK_NULL_HANDLE;      // imported only
+        VkImageView view = VK_NULL_HANDLE;
+        VkImageLayout initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        VkImageLayout finalLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        VkPipelineStageFlags2 readyStages = VK_PIPELINE_STAGE_2_NONE;
+        VkImageUsageFlags usage = 0;
+        int first = -1, last = -1;           // live pass range
+        int physical = -1;
+    };
+
+    // What the physical transients were built from; any change reallocates.
+    struct Key {
+        std::string name;
+        ImageDesc desc;
+        VkImageUsageFlags usage;
+        int first, last;
+        bool operator==(const Key& o) const {
+            return name == o.name && desc.extent.width == o.desc.extent.width &&
+                desc.extent.height == o.desc.extent.height && desc.format == o.desc.format &&
+                desc.mipLevels == o.desc.mipLevels && desc.aspect == o.desc.aspect &&
+                usage == o.usage && first == o.first && last == o.last;
+        }
+        bool operator!=(const Key& o) const { return !(*this == o); }
+    };
+
+    struct Physical {
+        std::string name;
+        VkImage image = VK_NULL_HANDLE;
+        VkImageView view = VK_NULL_HANDLE;       // all mips
+        std::vector<VkImageView> mipViews;       // one per level when mipLevels > 1
+        uint32_t slot = 0;
+        VkImageView viewOf(uint32_t mip) const {
+            return mip == ALL_MIPS || mipViews.empty() ? view : mipViews[mip];
+        }
+    };
+
+    // A memory range shared by transients with disjoint lifetimes
+    struct Slot {
+        VkMemoryRequirements req{};
+        int lastPass = -1;
+        GpuAllocation memory;
+        VkPipelineStageFlags2 lastStages = VK_PIPELINE_STAGE_2_NONE;   // last use, carried across frames
+        VkAccessFlags2 lastAccess = 0;
+    };
+
+    struct State {
+        VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+        VkPipelineStageFlags2 writeStages = VK_PIPELINE_STAGE_2_NONE;   // last write (or transition)
+        VkAccessFlags2 writeAccess = 0;
+        VkPipelineStageFlags2 readStages = VK_PIPELINE_STAGE_2_NONE;    // readers since then
+        VkPipelineStageFlags2 visibleStages = VK_PIPELINE_STAGE_2_NONE; // already waited on the write
+        VkAccessFlags2 visibleAccess = 0;
+    };
+
+    VkDevice device = VK_NULL_HANDLE;
+    GpuAllocator* allocator = nullptr;
+    std::vector<Image> images;
+    std::vector<Pass> passes;
+    std::vector<Key> cachedKeys;
+    std::vector<Physical> physical;
+    std::vector<Slot> slots;
+    Stats lastStats;
+    Retire retire;
+
+    // Walk back from the imported images: a pass is live if something live
+    // (or an import) consumes what it writes.
+    void cull() {
+        std::vector<bool> needed(images.size(), false);
+        for (size_t i = 0; i < images.size(); ++i) needed[i] = images[i].imported;
+        for (int p = (int)passes.size() - 1; p >= 0; --p) {
+            Pass& pass = passes[p];
+            pass.live = false;
+            for (const Ref& r : pass.refs)
+                if (access(r.use).write && needed[r.id]) pass.live = true;
+            if (!pass.live) continue;
+            for (const Ref& r : pass.refs)
+                if (!access(r.use).write) needed[r.id] = true;
+        }
+    }
+
+    // Wait for every earlier access, or just for the last write when this is
+    // a read in the same layout that hasn't seen it yet. False: no barrier.
+    static bool transition(State& s, const Access& a, VkImageMemoryBarrier2& b) {
+        if (s.layout == a.layout && !a.write) {
+            s.readStages |= a.stages;
+            bool visible = (a.stages & ~s.visibleStages) == 0 && (a.access & ~s.visibleAccess) == 0;
+            if (visible || s.writeStages == VK_PIPELINE_STAGE_2_NONE) return false;
+            b.srcStageMask = s.writeStages;
+            b.srcAccessMask = s.writeAccess;
+            b.dstStageMask = a.stages;
+            b.dstAccessMask = a.access;
+            b.oldLayout = b.newLayout = a.layout;
+            s.visibleStages |= a.stages;
+            s.visibleAccess |= a.access;
+            return true;
+        }
+
+        b.srcStageMask = s.writeStages | s.readStages;
+        b.srcAccessMask = s.writeAccess;
+        b.dstStageMask = a.stages;
+        b.dstAccessMask = a.access;
+        b.oldLayout = s.layout;
+        b.newLayout = a.layout;
+
+        s.layout = a.layout;
+        s.writeStages = a.stages;
+        if (a.write) {
+            s.writeAccess = a.access;
+            s.readStages = VK_PIPELINE_STAGE_2_NONE;
+            s.visibleStages = VK_PIPELINE_STAGE_2_NONE;
+            s.visibleAccess = 0;
+        }
+        else {
+            // the transition is visible to this reader; nothing left to flush
+            s.writeAccess = 0;
+            s.readStages = a.stages;
+            s.visibleStages = a.stages;
+            s.visibleAccess = a.access;
+        }
+        return true;
+    }
+
+    static void emit(VkCommandBuffer cb, const std::vector<VkImageMemoryBarrier2>& barriers) {
+        if (barriers.empty()) return;
+        VkDependencyInfo dep{ VK_STRUCTURE_TYPE_DEPENDENCY_INFO };
+        dep.imageMemoryBarrierCount = (uint32_t)barriers.size();
+        dep.pImageMemoryBarriers = barriers.data();
+        vkCmdPipelineBarrier2(cb, &dep);
+    }
+
+    // Images in order of first use; each goes into the first slot whose
+    // occupants are all done before it starts and whose memory types overlap.
+    void allocatePhysical(const std::vector<Key>& keys) {
+        std::vector<const Key*> order;
+        for (const Key& k : keys) order.push_back(&k);
+        std::stable_sort(order.begin(), order.end(), [](const Key* a, const Key* b) { return a->first < b->first; });
+
+        lastStats.transients = (uint32_t)keys.size();
+        lastStats.unaliasedBytes = 0;
+        std::vector<VkMemoryRequirements> reqs;
+        for (const Key* k : order) {
+            Physical p;
+            p.name = k->name;
+
+            VkImageCreateInfo ci{ VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO };
+            ci.imageType = VK_IMAGE_TYPE_2D;
+            ci.extent = { k->desc.extent.width, k->desc.extent.height, 1 };
+            ci.mipLevels = k->desc.mipLevels;
+            ci.arrayLayers = 1;
+            ci.format = k->desc.format;
+            ci.tiling = VK_IMAGE_TILING_OPTIMAL;
+            ci.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            ci.usage = k->usage;
+            ci.samples = VK_SAMPLE_COUNT_1_BIT;
+            ci.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+            if (vkCreateImage(device, &ci, nullptr, &p.image) != VK_SUCCESS)
+                throw std::runtime_error("RenderGraph: failed to create transient '" + k->name + "'");
+
+            VkMemoryRequirements req{};
+            vkGetImageMemoryRequirements(device, p.image, &req);
+            lastStats.unaliasedBytes += req.size;
+
+            size_t s = 0;
+            for (; s < slots.size(); ++s)
+                if (slots[s].lastPass < k->first && (slots[s].req.memoryTypeBits & req.memoryTypeBits)) break;
+            if (s == slots.size()) {
+                slots.push_back({});
+                slots[s].req.memoryTypeBits = req.memoryTypeBits;
+            }
+            Slot& slot = slots[s];
+            slot.req.size = std::max(slot.req.size, req.size);
+            slot.req.alignment = std::max(slot.req.alignment, req.alignment);
+            slot.req.memoryTypeBits &= req.memoryTypeBits;
+            slot.lastPass = k->last;
+            p.slot = (uint32_t)s;
+
+            physical.push_back(std::move(p));
+            reqs.push_back(req);
+        }
+
+        lastStats.allocations = (uint32_t)slots.size();
+        lastStats.bytes = 0;
+        for (Slot& slot : slots) {
+            slot.memory = allocator->allocate(slot.req, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, true);
+            lastStats.bytes += slot.req.size;
+        }
+
+        for (size_t i = 0; i < physical.size(); ++i) {
+            Physical& p = physical[i];
+            const Key& k = *order[i];
+            const GpuAllocation& mem = slots[p.slot].memory;
+            vkBindImageMemory(device, p.image, mem.memory, mem.offset);
+
+            p.view = createView(p.image, k.desc, 0, k.desc.mipLevels);
+            if (k.desc.mipLevels > 1)
+                for (uint32_t m = 0; m < k.desc.mipLevels; ++m)
+                    p.mipViews.push_back(createView(p.image, k.desc, m, 1));
+        }
+    }
+
+    VkImageView createView(VkImage image, const ImageDesc& desc, uint32_t baseMip, uint32_t mipCount) {
+        VkImageViewCreateInfo vi{ VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO };
+        vi.image = image;
+        vi.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        vi.format = desc.format;
+        vi.subresourceRange = { desc.aspect, baseMip, mipCount, 0, 1 };
+        VkImageView view;
+        if (vkCreateImageView(device, &vi, nullptr, &view) != VK_SUCCESS)
+            throw std::runtime_error("RenderGraph: failed to create image view");
+        return view;
+    }
+
+    static void release(VkDevice device, GpuAllocator& allocator, std::vector<Physical>& images, std::vector<Slot>& memory) {
+        for (Physical& p : images) {
+            for (VkImageView v : p.mipViews) vkDestroyImageView(device, v, nullptr);
+            vkDestroyImageView(device, p.view, nullptr);
+            vkDestroyImage(device, p.image, nullptr);
+        }
+        for (Slot& s : memory) allocator.free(s.memory);
+        images.clear();
+        memory.clear();
+    }
+};
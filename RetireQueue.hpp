@@ -0,0 +1,62 @@
+#pragma once
+#include <vector>
+#include <functional>
+#include <utility>
+#include <cstdint>
+
+// --- Deferred destruction ----------------------------------------------------
+// Holds destroy callbacks until every frame that was in flight when they were
+// queued has retired, so replacing a resource (the swapchain on resize, render
+// graph transients) doesn't need vkDeviceWaitIdle. The app reports
+// submitted(frame) after each queue submit and retired(frame) once it has
+// waited on that frame's fence; frames submitted after defer() never hold it up.
+
+class RetireQueue {
+public:
+    void init(uint32_t framesInFlight) {
+        lastSubmitted.assign(framesInFlight, 0);
+        lastRetired.assign(framesInFlight, 0);
+    }
+
+    // Run `destroy` once the GPU can no longer be using what it frees.
+    void defer(std::function<void()> destroy) {
+        pending.push_back({ lastSubmitted, std::move(destroy) });
+    }
+
+    void submitted(uint32_t frame) { lastSubmitted[frame] = ++serial; }
+
+    // Call after waiting on `frame`'s fence; runs whatever that unblocks.
+    void retired(uint32_t frame) {
+        lastRetired[frame] = lastSubmitted[frame];
+        size_t kept = 0;
+        for (size_t i = 0; i < pending.size(); ++i) {
+            if (done(pending[i])) pending[i].destroy();
+            else if (kept++ != i) pending[kept - 1] = std::move(pending[i]);
+        }
+        pending.resize(kept);
+    }
+
+    // Destroy everything now. Only after vkDeviceWaitIdle.
+    void flush() {
+        for (Entry& e : pending) e.destroy();
+        pending.clear();
+    }
+
+    size_t size() const { return pending.size(); }
+
+private:
+    struct Entry {
+        std::vector<uint64_t> waitFor;   // per frame: the submission that has to retire first
+        std::function<void()> destroy;
+    };
+
+    bool done(const Entry& e) const {
+        for (size_t f = 0; f < e.waitFor.size(); ++f)
+            if (lastRetired[f] < e.waitFor[f]) return false;
+        return true;
+    }
+
+    std::vector<uint64_t> lastSubmitted, lastRetired;
+    std::vector<Entry> pending;
+    uint64_t serial = 0;
+};
@@ -0,0 +1,26 @@
+#version 450
+
+// Dual-filter downsample: one level of the bloom pyramid from the level above
+// it (or the scene for the first level). Five bilinear fetches cover a 4x4
+// texel footprint of the source.
+
+layout(location = 0) in vec2 uv;
+layout(set = 0, binding = 1) uniform sampler2D srcTexture;
+
+layout(push_constant) uniform BloomPush {
+    vec2 texelStep;   // 1 / source size
+} pc;
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+    vec2 h = pc.texelStep;   // half a destination texel = one source texel
+
+    vec3 sum = texture(srcTexture, uv).rgb * 4.0;
+    sum += texture(srcTexture, uv + vec2(-h.x, -h.y)).rgb;
+    sum += texture(srcTexture, uv + vec2( h.x, -h.y)).rgb;
+    sum += texture(srcTexture, uv + vec2(-h.x,  h.y)).rgb;
+    sum += texture(srcTexture, uv + vec2( h.x,  h.y)).rgb;
+
+    outColor = vec4(sum / 8.0, 1.0);
+}
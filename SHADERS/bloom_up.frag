@@ -0,0 +1,28 @@
+#version 450
+
+// Dual-filter upsample: rebuild one level of the bloom pyramid from the
+// smaller level below it with an 8-tap tent, widening the blur at each step.
+
+layout(location = 0) in vec2 uv;
+layout(set = 0, binding = 1) uniform sampler2D srcTexture;
+
+layout(push_constant) uniform BloomPush {
+    vec2 texelStep;   // 1 / source size
+} pc;
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+    vec2 h = pc.texelStep * 0.5;
+
+    vec3 sum = texture(srcTexture, uv + vec2(-h.x * 2.0, 0.0)).rgb;
+    sum += texture(srcTexture, uv + vec2( h.x * 2.0, 0.0)).rgb;
+    sum += texture(srcTexture, uv + vec2(0.0, -h.y * 2.0)).rgb;
+    sum += texture(srcTexture, uv + vec2(0.0,  h.y * 2.0)).rgb;
+    sum += texture(srcTexture, uv + vec2(-h.x,  h.y)).rgb * 2.0;
+    sum += texture(srcTexture, uv + vec2( h.x,  h.y)).rgb * 2.0;
+    sum += texture(srcTexture, uv + vec2(-h.x, -h.y)).rgb * 2.0;
+    sum += texture(srcTexture, uv + vec2( h.x, -h.y)).rgb * 2.0;
+
+    outColor = vec4(sum / 12.0, 1.0);
+}
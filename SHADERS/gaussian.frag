@@ -0,0 +1,42 @@
+#version 450
+
+// One direction of a separable Gaussian blur. Run twice: horizontally into an
+// intermediate target, then vertically. Neighbouring taps (i, i+1) are merged
+// into a single bilinear fetch placed between them, so a radius-R kernel costs
+// 1 + 2*ceil(R/2) fetches per pass instead of (2R+1)^2 for a 2D box.
+
+layout(constant_id = 0) const int RADIUS = 8;     // taps each side of the centre
+layout(constant_id = 1) const float SIGMA = 4.0;  // in texels
+
+layout(location = 0) in vec2 uv;
+layout(set = 0, binding = 1) uniform sampler2D sceneTexture;
+
+layout(push_constant) uniform BlurPush {
+    vec2 texelStep;   // (1/width, 0) or (0, 1/height)
+} pc;
+
+layout(location = 0) out vec4 outColor;
+
+float gauss(float x) {
+    return exp(-0.5 * x * x / (SIGMA * SIGMA));
+}
+
+void main() {
+    float total = gauss(0.0);
+    vec3 sum = texture(sceneTexture, uv).rgb * total;
+
+    // RADIUS and SIGMA are specialization constants, so the weights and
+    // offsets below fold to constants when the pipeline is built.
+    for (int i = 1; i <= RADIUS; i += 2) {
+        float wa = gauss(float(i));
+        float wb = (i + 1 <= RADIUS) ? gauss(float(i + 1)) : 0.0;
+        float w = wa + wb;
+        float offset = (float(i) * wa + float(i + 1) * wb) / w;
+
+        vec2 d = pc.texelStep * offset;
+        sum += (texture(sceneTexture, uv + d).rgb + texture(sceneTexture, uv - d).rgb) * w;
+        total += 2.0 * w;
+    }
+
+    outColor = vec4(sum / total, 1.0);
+}
@@ -4,6 +4,8 @@ layout(location = 0) in vec2 uv;
 layout(location = 0) out vec4 outColor;
 
 layout(set = 0, binding = 1) uniform sampler2D sceneTex;
+// wide blur of the scene, built by the bloom_down / bloom_up pyramid
+layout(set = 0, binding = 2) uniform sampler2D bloomTex;
 
 layout(push_constant) uniform FireParams {
     float time;
@@ -12,7 +14,7 @@ layout(push_constant) uniform FireParams {
     float pad1;
 } fire;
 
-// small hash for per-tap variation
+// small hash for per-pixel variation
 float hash(vec2 p) {
     return fract(sin(dot(p, vec2(127.1, 311.7))) * 43758.5453123);
 }
@@ -31,11 +33,6 @@ void main() {
                   cos(uv.x * 40.0 - fire.time * 7.0);
     vec2 wobble = texel * 8.0 * noise;
 
-    // base blur radius
-    int   radius    = 10;
-    vec3  blurSum   = vec3(0.0);
-    float weightSum = 0.0;
-
     // remap v so 0 is bottom, 1 is top
     float v = uv.y;
 
@@ -43,57 +40,30 @@ void main() {
     float centerX = 0.5;
     float distFromCenter = abs(uv.x - centerX);
 
-    for (int x = -radius; x <= radius; x++) {
-        for (int y = -radius; y <= radius; y++) {
-            vec2 o = vec2(x, y);
-
-            // [NARROW-X] elliptical distance: shrink horizontal reach
-            // 0.35 makes flames about 1/3 as wide vs tall
-            float dist = length(vec2(o.x * 0.35, o.y));
-
-            float w = max(0.0, 1.0 - dist / float(radius + 1));
-
-            float nTap = hash(o * 3.17 + uv * 25.0 + fire.time);
-
-            // upward base factor
-            float baseUp = float(radius + 1 - y) / float(radius + 1);
-            baseUp = max(baseUp, 0.0);
-
-            // columns vary in height
-            float uneven = 0.6 + 0.8 * nTap;
-
-            // fade flames as they rise
-            float heightMask = 1.0 - smoothstep(0.45, 0.85, v);
-
-            // [NARROW-X] fade flames away from cube centre horizontally
-            //  - 0 distance = full strength
-            //  - >0.25 away ~ almost gone
-            float sideMask = 1.0 - smoothstep(0.18, 0.25, distFromCenter);
+    float n = hash(uv * 25.0 + fire.time);
 
-            float upward = baseUp * uneven * heightMask * sideMask;
-            upward = pow(upward, 1.3);
+    // columns vary in height
+    float uneven = 0.6 + 0.8 * n;
 
-            // overall height
-            float stretch = 0.05;
+    // fade flames as they rise
+    float heightMask = 1.0 - smoothstep(0.45, 0.85, v);
 
-            vec2 sampleUV =
-                uv
-                + wobble
-                + o * texel
-                + vec2(0.0, upward * stretch);
+    // [NARROW-X] fade flames away from cube centre horizontally
+    //  - 0 distance = full strength
+    //  - >0.25 away ~ almost gone
+    float sideMask = 1.0 - smoothstep(0.18, 0.25, distFromCenter);
 
-            vec3 sampleCol = texture(sceneTex, sampleUV).rgb;
+    float upward = pow(uneven * heightMask * sideMask, 1.3);
 
-            // patchy halo
-            float weightJitter = 0.7 + 0.6 * (nTap - 0.5);
-            blurSum   += sampleCol * w * weightJitter;
-            weightSum += w * weightJitter;
-        }
-    }
+    // overall height
+    float stretch = 0.05;
 
-    vec3 blurred = blurSum / max(weightSum, 0.0001);
+    // the pyramid already did the wide blur; just displace the lookup
+    vec3 blurred = texture(bloomTex, uv + wobble + vec2(0.0, upward * stretch)).rgb;
 
-    vec3 aura = max(blurred - sharp.rgb, 0.0);
+    // patchy halo
+    float weightJitter = 0.7 + 0.6 * (n - 0.5);
+    vec3 aura = max(blurred - sharp.rgb, 0.0) * weightJitter;
 
     vec3 fireTint = vec3(1.0, 0.6, 0.1);
     float flicker = 0.7 + 0.3 * sin(fire.time * 8.0 + uv.y * 50.0);
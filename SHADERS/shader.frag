@@ -6,6 +6,9 @@ layout(set = 0, binding = 0) uniform UBO {
     mat4 proj;
     vec3 lightPos;
     vec3 eyePos;
+    mat3 normalMatrix;   // transpose(inverse(mat3(model))), computed on the CPU
+    vec4 posBias;        // VERTEX_FORMAT 2: pos = posBias + inPos * posScale
+    vec4 posScale;
 } ubo;
 
 // Two textures: rock (binding 1) and wood (binding 2)
@@ -16,6 +19,7 @@ layout(location = 0) in vec3 vWorldPos;
 layout(location = 1) in vec3 vWorldNormal;
 layout(location = 2) in vec3 vColor;
 layout(location = 3) in vec2 vUV;
+layout(location = 4) flat in uint vUnlit;
 
 layout(location = 0) out vec4 outColor;
 
@@ -38,7 +42,7 @@ void main() {
     vec3 color2 = texture(texSampler2, vUV).rgb;  // Wood texture
 
     // Transform the normal to view space
-    vec3 normalViewSpace = normalize(mat3(transpose(inverse(ubo.model))) * vWorldNormal);
+    vec3 normalViewSpace = normalize(ubo.normalMatrix * vWorldNormal);
 
     // Check if the fragment is a rear face based on normal direction
     bool isRearFace = isRearFaceByNormal(normalViewSpace);
@@ -53,6 +57,11 @@ void main() {
         finalColor = color1;
     }
 
+    if (vUnlit != 0u) {
+        outColor = vec4(finalColor, 1.0);
+        return;
+    }
+
     // Simple diffuse lighting
     vec3 N = normalize(vWorldNormal);
     vec3 L = normalize(ubo.lightPos - vWorldPos);
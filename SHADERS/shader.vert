@@ -6,8 +6,24 @@ layout(set = 0, binding = 0) uniform UBO {
     mat4 proj;
     vec3 lightPos;
     vec3 eyePos;
+    mat3 normalMatrix;   // transpose(inverse(mat3(model))), computed on the CPU
+    vec4 posBias;        // VERTEX_FORMAT 2: pos = posBias + inPos * posScale
+    vec4 posScale;
 } ubo;
 
+// Per-draw override (PushConstants in the app); the instanced path uses instanced.vert
+layout(push_constant) uniform Push {
+    mat4 modelOverride;
+    mat3 normalOverride;
+    uint useOverride;
+    uint unlit;
+} pc;
+
+// Vertex buffer layout, VertexEncoding in the app: 0 full floats, 1 compact
+// (RGBA8 color, octahedral snorm16 normal, half uv), 2 compact with unorm16
+// positions in the mesh bounds. Compact normals arrive as (x, y, 0).
+layout(constant_id = 0) const int VERTEX_FORMAT = 0;
+
 layout(location = 0) in vec3 inPos;
 layout(location = 1) in vec3 inColor;
 layout(location = 2) in vec3 inNormal;
@@ -17,16 +33,31 @@ layout(location = 0) out vec3 vWorldPos;
 layout(location = 1) out vec3 vWorldNormal;
 layout(location = 2) out vec3 vColor;
 layout(location = 3) out vec2 vUV;
+layout(location = 4) flat out uint vUnlit;
+
+vec3 decodePosition() {
+    return VERTEX_FORMAT == 2 ? ubo.posBias.xyz + inPos * ubo.posScale.xyz : inPos;
+}
+
+vec3 decodeNormal() {
+    if (VERTEX_FORMAT == 0) return inNormal;
+    vec3 n = vec3(inNormal.xy, 1.0 - abs(inNormal.x) - abs(inNormal.y));
+    float t = max(-n.z, 0.0);
+    n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+    return n;
+}
 
 void main() {
-    vec4 worldPos = ubo.model * vec4(inPos, 1.0);
+    mat4 model = pc.useOverride != 0u ? pc.modelOverride : ubo.model;
+    vec4 worldPos = model * vec4(decodePosition(), 1.0);
     vWorldPos = worldPos.xyz;
 
-    mat3 N = mat3(transpose(inverse(ubo.model)));
-    vWorldNormal = normalize(N * inNormal);
+    mat3 N = pc.useOverride != 0u ? pc.normalOverride : ubo.normalMatrix;
+    vWorldNormal = normalize(N * decodeNormal());
 
     vColor = inColor;
     vUV = inUV * vec2(2.0,2.0);  // pass to fragment shader
+    vUnlit = pc.useOverride != 0u ? pc.unlit : 0u;
 
     gl_Position = ubo.proj * ubo.view * worldPos;
 }
\ No newline at end of file
@@ -0,0 +1,367 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <stb_perlin.h>
+#include <glm/glm.hpp>
+#include <vector>
+#include <unordered_map>
+#include <functional>
+#include <future>
+#include <chrono>
+#include <algorithm>
+#include <stdexcept>
+#include <cstring>
+#include <cmath>
+#include <cstdint>
+
+#include "GpuAllocator.hpp"
+#include "ThreadPool.hpp"
+#include "MeshOptimizer.hpp"
+
+// --- Chunked terrain ---------------------------------------------------------
+// The Week 3 Perlin heightfield split into square tiles that are built on the
+// thread pool and streamed in around the camera. Heights are stb_perlin fBm
+// of the world position; normals are central differences over a one-cell
+// apron, so neighbouring tiles agree on their shared edge. Every tile has
+// the same grid topology: one cache-optimized index list serves all of them,
+// and tile vertices are written in its fetch order.
+//
+// Tile positions are relative to the tile's corner (tileOrigin), so all tiles
+// share one set of bounds and are placed by their model matrix.
+
+struct TerrainSettings {
+    uint32_t tileQuads = 64;       // quads along a tile edge
+    float    cellSize = 0.25f;     // world units per quad
+    float    amplitude = 3.0f;
+    float    frequency = 0.04f;    // noise cycles per world unit, first octave
+    float    lacunarity = 2.0f;
+    float    gain = 0.5f;
+    int      octaves = 5;
+    float    seed = 0.0f;          // z of the noise lattice, so seeds give unrelated terrain
+    float    uvRepeats = 4.0f;     // texture repeats per tile; whole numbers keep seams continuous
+    int      radius = 4;           // tiles kept on each side of the camera's tile
+    uint32_t uploadsPerFrame = 4;  // tile copies recorded into one frame at most
+
+    float tileSize() const { return tileQuads * cellSize; }
+    uint32_t tileVertices() const { return (tileQuads + 1) * (tileQuads + 1); }
+
+    // |height| never exceeds this: amplitude times the sum of the octave weights
+    float heightLimit() const {
+        float sum = 0.0f, w = 1.0f;
+        for (int o = 0; o < octaves; ++o, w *= std::fabs(gain)) sum += w;
+        return amplitude * sum;
+    }
+};
+
+inline float terrainHeight(const TerrainSettings& s, float x, float z) {
+    float h = s.amplitude * stb_perlin_fbm_noise3(x * s.frequency, z * s.frequency, s.seed,
+        s.lacunarity, s.gain, s.octaves);
+    return std::clamp(h, -s.heightLimit(), s.heightLimit());
+}
+
+inline glm::vec3 tileOrigin(const TerrainSettings& s, int32_t x, int32_t z) {
+    return glm::vec3((float)x * s.tileSize(), 0.0f, (float)z * s.tileSize());
+}
+
+// Index list and vertex order shared by every tile.
+struct TerrainGrid {
+    std::vector<uint32_t> order;     // tile vertex k is grid point order[k] = j * (quads + 1) + i
+    std::vector<uint32_t> indices;   // triangle list over tile vertices
+    MeshOptStats stats;
+};
+
+inline TerrainGrid buildTerrainGrid(uint32_t quads) {
+    const uint32_t row = quads + 1;
+    // grid point ids stand in for vertices: all distinct, so welding keeps every one
+    std::vector<uint32_t> ids(row * row);
+    for (uint32_t i = 0; i < (uint32_t)ids.size(); ++i) ids[i] = i;
+
+    std::vector<uint32_t> indices;
+    indices.reserve(quads * quads * 6);
+    for (uint32_t j = 0; j < quads; ++j) {
+        for (uint32_t i = 0; i < quads; ++i) {
+            uint32_t i0 = j * row + i, i1 = i0 + 1, i3 = i0 + row, i2 = i3 + 1;
+            // counter-clockwise seen from +Y
+            indices.insert(indices.end(), { i0, i3, i2, i0, i2, i1 });
+        }
+    }
+
+    OptimizedMesh<uint32_t> m = optimizeMesh(ids, indices);
+    return { std::move(m.vertices), std::move(m.indices), m.stats };
+}
+
+// Fills `out` (tileVertices() entries) with tile (x, z) in grid.order.
+// `make(pos, normal, uv)` builds a V.
+template <class V, class Make>
+void generateTerrainTile(const TerrainSettings& s, const TerrainGrid& grid, int32_t x, int32_t z, V* out, Make&& make) {
+    const int32_t n = (int32_t)s.tileQuads;
+    const int32_t apron = n + 3;   // one extra sample on every side for the normals
+
+    // Sample at integer world grid coordinates, so neighbours see the same
+    // floats along their shared edge.
+    std::vector<float> h((size_t)apron * apron);
+    const int64_t gx0 = (int64_t)x * n - 1, gz0 = (int64_t)z * n - 1;
+    for (int32_t j = 0; j < apron; ++j)
+        for (int32_t i = 0; i < apron; ++i)
+            h[(size_t)j * apron + i] = terrainHeight(s, (float)(gx0 + i) * s.cellSize, (float)(gz0 + j) * s.cellSize);
+
+    const float inv2c = 0.5f / s.cellSize;
+    const float uvStep = s.uvRepeats / (float)n;
+    for (size_t k = 0; k < grid.order.size(); ++k) {
+        const int32_t i = (int32_t)(grid.order[k] % (uint32_t)(n + 1));
+        const int32_t j = (int32_t)(grid.order[k] / (uint32_t)(n + 1));
+        const size_t c = (size_t)(j + 1) * apron + (i + 1);
+        const float dx = (h[c + 1] - h[c - 1]) * inv2c;
+        const float dz = (h[c + apron] - h[c - apron]) * inv2c;
+        out[k] = make(glm::vec3(i * s.cellSize, h[c], j * s.cellSize),
+            glm::normalize(glm::vec3(-dx, 1.0f, -dz)),
+            glm::vec2(i * uvStep, j * uvStep));
+    }
+}
+
+// --- Streaming ---------------------------------------------------------------
+// Keeps every tile within `radius` of the camera's tile resident, nearest
+// first. update() runs once per frame after that frame's fence:
+//   1. tiles more than radius + 1 away are dropped (the extra ring stops a
+//      camera on a tile edge from thrashing);
+//   2. missing tiles are queued on the pool, at most two per worker at once;
+//   3. finished tiles are copied into free slots of one device-local vertex
+//      buffer, from the frame's own command buffer.
+// Staging is a persistently mapped region per frame in flight, as in
+// UniformRing, so streaming never submits or waits on its own. A slot given
+// up by a dropped tile is reused only once the frames that may still draw
+// from it have retired (the retire callback, e.g. RetireQueue::defer).
+
+class TerrainStreamer {
+public:
+    // Runs on a worker: tile (x, z) as exactly bytesPerTile() of vertex data.
+    using BuildTile = std::function<std::vector<unsigned char>(int32_t x, int32_t z)>;
+    using Retire = std::function<void(std::function<void()>)>;
+
+    struct Tile {
+        int32_t  x = 0, z = 0;
+        uint32_t firstVertex = 0;   // vertexOffset for the draw
+    };
+
+    struct Stats {
+        uint64_t built = 0;         // tiles generated on the pool
+        uint64_t uploaded = 0;      // tiles copied into the vertex buffer
+        uint64_t evicted = 0;       // resident tiles dropped for distance
+        uint64_t abandoned = 0;     // builds that finished after their tile went out of range
+        double   buildMs = 0.0;     // worker time summed over built tiles
+        double   updateMs = 0.0;    // update() time, last frame
+        double   updatePeakMs = 0.0;
+    };
+
+    void init(VkDevice dev, GpuAllocator& alloc, ThreadPool& threads, const TerrainSettings& s,
+        VkDeviceSize vertexStride, uint32_t framesInFlight, BuildTile buildTile, Retire retireFn)
+    {
+        device = dev;
+        allocator = &alloc;
+        pool = &threads;
+        settings = s;
+        build = std::move(buildTile);
+        retire = std::move(retireFn);
+        tileBytes = vertexStride * s.tileVertices();
+
+        // everything within radius + 1, plus a ring's worth waiting to retire
+        const uint32_t side = 2 * (uint32_t)s.radius + 3;
+        slotCount = side * side + 2 * side;
+        freeSlots.clear();
+        for (uint32_t i = slotCount; i-- > 0; ) freeSlots.push_back(i);
+
+        vertices = createBuffer(tileBytes * slotCount,
+            VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, verticesMemory);
+        stagingFrameBytes = tileBytes * s.uploadsPerFrame;
+        staging = createBuffer(stagingFrameBytes * framesInFlight, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingMemory);
+    }
+
+    // Only after vkDeviceWaitIdle. Waits for builds still on the pool.
+    void destroy() {
+        if (!device) return;
+        for (auto& [k, e] : entries) if (e.job.valid()) e.job.wait();
+        for (auto& j : abandoned) j.wait();
+        entries.clear();
+        abandoned.clear();
+        resident.clear();
+        generation++;   // slots still waiting in the retire callback are stale now
+
+        vkDestroyBuffer(device, vertices, nullptr);
+        allocator->free(verticesMemory);
+        vkDestroyBuffer(device, staging, nullptr);
+        allocator->free(stagingMemory);
+        device = VK_NULL_HANDLE;
+    }
+
+    // Call after waiting on `frame`'s fence, before anything drawing tiles()
+    // is recorded into `cb`.
+    void update(VkCommandBuffer cb, uint32_t frame, const glm::vec3& camera) {
+        auto t0 = std::chrono::steady_clock::now();
+        const int32_t cx = (int32_t)std::floor(camera.x / settings.tileSize());
+        const int32_t cz = (int32_t)std::floor(camera.z / settings.tileSize());
+        auto reach = [&](int32_t x, int32_t z) { return std::max(std::abs(x - cx), std::abs(z - cz)); };
+
+        // 1. drop what is out of range
+        for (auto it = entries.begin(); it != entries.end(); ) {
+            Entry& e = it->second;
+            if (reach(e.x, e.z) <= settings.radius + 1) { ++it; continue; }
+            if (e.job.valid()) abandoned.push_back(std::move(e.job));
+            if (e.slot != NO_SLOT) {
+                retire([this, slot = e.slot, gen = generation] { if (gen == generation) freeSlots.push_back(slot); });
+                stats.evicted++;
+            }
+            it = entries.erase(it);
+        }
+        for (size_t i = 0; i < abandoned.size(); ) {
+            if (!ready(abandoned[i])) { ++i; continue; }
+            abandoned[i].get();   // rethrows a failed build
+            abandoned[i] = std::move(abandoned.back());
+            abandoned.pop_back();
+            stats.abandoned++;
+        }
+
+        // 2. queue the nearest missing tiles
+        auto distance = [&](int32_t x, int32_t z) {
+            glm::vec3 c = tileOrigin(settings, x, z) + 0.5f * settings.tileSize();
+            float dx = c.x - camera.x, dz = c.z - camera.z;
+            return dx * dx + dz * dz;
+        };
+        size_t building = abandoned.size();
+        for (auto& [k, e] : entries) if (e.job.valid()) building++;
+        const size_t maxBuilding = 2 * (size_t)pool->size();
+        if (building < maxBuilding) {
+            std::vector<std::pair<float, uint64_t>> missing;
+            for (int32_t z = cz - settings.radius; z <= cz + settings.radius; ++z)
+                for (int32_t x = cx - settings.radius; x <= cx + settings.radius; ++x)
+                    if (!entries.count(key(x, z))) missing.push_back({ distance(x, z), key(x, z) });
+            std::sort(missing.begin(), missing.end());
+            for (size_t i = 0; i < missing.size() && building < maxBuilding; ++i, ++building) {
+                Entry& e = entries[missing[i].second];
+                e.x = (int32_t)(missing[i].second >> 32);
+                e.z = (int32_t)(uint32_t)missing[i].second;
+                e.job = pool->submit([fn = build, x = e.x, z = e.z] {
+                    auto t = std::chrono::steady_clock::now();
+                    Built b{ fn(x, z), 0.0 };
+                    b.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t).count();
+                    return b;
+                });
+            }
+        }
+
+        // 3. copy finished tiles, nearest first, within the frame's budget
+        std::vector<std::pair<float, Entry*>> done;
+        for (auto& [k, e] : entries) {
+            if (e.job.valid() && ready(e.job)) {
+                Built b = e.job.get();
+                if (b.bytes.size() != tileBytes) throw std::runtime_error("TerrainStreamer: tile has the wrong size");
+                e.data = std::move(b.bytes);
+                stats.built++;
+                stats.buildMs += b.ms;
+            }
+            if (!e.data.empty()) done.push_back({ distance(e.x, e.z), &e });
+        }
+        std::sort(done.begin(), done.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+        const size_t uploads = std::min({ done.size(), freeSlots.size(), (size_t)settings.uploadsPerFrame });
+        const VkDeviceSize base = stagingFrameBytes * frame;
+        for (size_t i = 0; i < uploads; ++i) {
+            Entry& e = *done[i].second;
+            e.slot = freeSlots.back();
+            freeSlots.pop_back();
+
+            VkBufferCopy region{};
+            region.srcOffset = base + tileBytes * i;
+            region.dstOffset = tileBytes * e.slot;
+            region.size = tileBytes;
+            memcpy(static_cast<char*>(stagingMemory.mapped) + region.srcOffset, e.data.data(), (size_t)tileBytes);
+            vkCmdCopyBuffer(cb, staging, vertices, 1, &region);
+            std::vector<unsigned char>().swap(e.data);
+            stats.uploaded++;
+        }
+        if (uploads) {
+            VkMemoryBarrier2 mb{ VK_STRUCTURE_TYPE_MEMORY_BARRIER_2 };
+            mb.srcStageMask = VK_PIPELINE_STAGE_2_COPY_BIT;
+            mb.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+            mb.dstStageMask = VK_PIPELINE_STAGE_2_VERTEX_ATTRIBUTE_INPUT_BIT;
+            mb.dstAccessMask = VK_ACCESS_2_VERTEX_ATTRIBUTE_READ_BIT;
+            VkDependencyInfo dep{ VK_STRUCTURE_TYPE_DEPENDENCY_INFO };
+            dep.memoryBarrierCount = 1;
+            dep.pMemoryBarriers = &mb;
+            vkCmdPipelineBarrier2(cb, &dep);
+        }
+
+        // resident tiles, front to back
+        std::vector<std::pair<float, Tile>> sorted;
+        for (auto& [k, e] : entries)
+            if (e.slot != NO_SLOT) sorted.push_back({ distance(e.x, e.z), { e.x, e.z, e.slot * settings.tileVertices() } });
+        std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+        resident.clear();
+        for (auto& s : sorted) resident.push_back(s.second);
+
+        stats.updateMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+        stats.updatePeakMs = std::max(stats.updatePeakMs, stats.updateMs);
+    }
+
+    const std::vector<Tile>& tiles() const { return resident; }
+    VkBuffer vertexBuffer() const { return vertices; }
+    VkDeviceSize bytesPerTile() const { return tileBytes; }
+    uint32_t capacity() const { return slotCount; }
+    const TerrainSettings& config() const { return settings; }
+    const Stats& getStats() const { return stats; }
+
+private:
+    struct Built {
+        std::vector<unsigned char> bytes;
+        double ms = 0.0;
+    };
+    struct Entry {
+        int32_t x = 0, z = 0;
+        std::future<Built> job;            // valid while building
+        std::vector<unsigned char> data;   // built, waiting for a slot
+        uint32_t slot = NO_SLOT;           // resident
+    };
+    static constexpr uint32_t NO_SLOT = UINT32_MAX;
+
+    VkDevice device = VK_NULL_HANDLE;
+    GpuAllocator* allocator = nullptr;
+    ThreadPool* pool = nullptr;
+    TerrainSettings settings;
+    BuildTile build;
+    Retire retire;
+
+    VkBuffer vertices = VK_NULL_HANDLE;
+    GpuAllocation verticesMemory;
+    VkBuffer staging = VK_NULL_HANDLE;
+    GpuAllocation stagingMemory;
+    VkDeviceSize tileBytes = 0, stagingFrameBytes = 0;
+    uint32_t slotCount = 0;
+    std::vector<uint32_t> freeSlots;
+    uint64_t generation = 0;
+
+    std::unordered_map<uint64_t, Entry> entries;
+    std::vector<std::future<Built>> abandoned;
+    std::vector<Tile> resident;
+    Stats stats;
+
+    static uint64_t key(int32_t x, int32_t z) { return ((uint64_t)(uint32_t)x << 32) | (uint32_t)z; }
+
+    template <class T>
+    static bool ready(const std::future<T>& f) {
+        return f.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    }
+
+    VkBuffer createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags props, GpuAllocation& mem) {
+        VkBufferCreateInfo bi{ VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
+        bi.size = size;
+        bi.usage = usage;
+        bi.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        VkBuffer buf;
+        if (vkCreateBuffer(device, &bi, nullptr, &buf) != VK_SUCCESS)
+            throw std::runtime_error("TerrainStreamer: failed to create buffer");
+        VkMemoryRequirements req{}; vkGetBufferMemoryRequirements(device, buf, &req);
+        mem = allocator->allocate(req, props, false);
+        vkBindBufferMemory(device, buf, mem.memory, mem.offset);
+        return buf;
+    }
+};
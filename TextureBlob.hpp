@@ -0,0 +1,305 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <fstream>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// --- Cooked texture container (.rtex) ----------------------------------------
+// Written offline by Tools/TextureCooker, read at runtime by TextureCache.
+//
+//   TextureBlobHeader          records the source image's size and mtime
+//   TextureBlobMip[mipCount]   offsets are from the start of the file
+//   level data, largest first, each level 16-byte aligned
+//
+// Shared by the cooker and the app, so it must not depend on Vulkan.
+
+enum class TextureBlobFormat : uint32_t {
+    RGBA8 = 0,
+    BC1 = 1,   // 8 bytes per 4x4 block, opaque
+    BC3 = 2,   // 16 bytes per 4x4 block, BC1 colour + interpolated alpha
+};
+
+struct TextureBlobHeader {
+    uint32_t magic;
+    uint32_t version;
+    TextureBlobFormat format;
+    uint32_t width;
+    uint32_t height;
+    uint32_t mipCount;
+    uint64_t sourceSize;    // TextureBlobSource the blob was cooked from
+    uint64_t sourceTime;
+};
+
+struct TextureBlobMip {
+    uint64_t offset;
+    uint64_t size;
+    uint32_t width;
+    uint32_t height;
+};
+
+static constexpr uint32_t TEXTURE_BLOB_MAGIC = 0x58455452u; // "RTEX"
+static constexpr uint32_t TEXTURE_BLOB_VERSION = 2;
+
+// Identifies the source image a blob was cooked from. The time is in the
+// platform's native units, so a blob cooked on another OS reads as stale and
+// the source is decoded instead.
+struct TextureBlobSource {
+    uint64_t size = 0;
+    uint64_t time = 0;
+};
+
+// False if the file can't be stat'ed.
+inline bool textureBlobSourceStamp(const std::string& path, TextureBlobSource& out) {
+#ifdef _WIN32
+    WIN32_FILE_ATTRIBUTE_DATA fa{};
+    if (!GetFileAttributesExA(path.c_str(), GetFileExInfoStandard, &fa)) return false;
+    out.size = ((uint64_t)fa.nFileSizeHigh << 32) | fa.nFileSizeLow;
+    out.time = ((uint64_t)fa.ftLastWriteTime.dwHighDateTime << 32) | fa.ftLastWriteTime.dwLowDateTime;
+#else
+    struct stat st {};
+    if (stat(path.c_str(), &st) != 0) return false;
+    out.size = (uint64_t)st.st_size;
+    out.time = (uint64_t)st.st_mtime;
+#endif
+    return true;
+}
+
+inline uint32_t textureBlobBlockBytes(TextureBlobFormat f) {
+    return f == TextureBlobFormat::BC1 ? 8u : 16u;
+}
+
+inline uint64_t textureBlobLevelSize(TextureBlobFormat f, uint32_t w, uint32_t h) {
+    if (f == TextureBlobFormat::RGBA8) return (uint64_t)w * h * 4;
+    return (uint64_t)((w + 3) / 4) * ((h + 3) / 4) * textureBlobBlockBytes(f);
+}
+
+// Read-only view of a .rtex file. The file is memory-mapped, so level data is
+// paged in straight from disk as it is copied into staging.
+class TextureBlob {
+public:
+    TextureBlob() = default;
+    TextureBlob(const TextureBlob&) = delete;
+    TextureBlob& operator=(const TextureBlob&) = delete;
+    ~TextureBlob() { close(); }
+
+    // False if the file is missing, truncated or not a valid container.
+    bool open(const std::string& path) {
+        close();
+        if (!map(path)) return false;
+        if (!validate()) { close(); return false; }
+        return true;
+    }
+
+    void close() {
+#ifdef _WIN32
+        if (base) UnmapViewOfFile(base);
+        if (mapping) CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+        mapping = nullptr;
+        file = INVALID_HANDLE_VALUE;
+#else
+        if (base) munmap(const_cast<unsigned char*>(base), (size_t)length);
+#endif
+        base = nullptr;
+        length = 0;
+    }
+
+    const TextureBlobHeader& header() const { return *reinterpret_cast<const TextureBlobHeader*>(base); }
+    const TextureBlobMip& mip(uint32_t level) const {
+        return reinterpret_cast<const TextureBlobMip*>(base + sizeof(TextureBlobHeader))[level];
+    }
+    const unsigned char* levelData(uint32_t level) const { return base + mip(level).offset; }
+
+    // True while the source still has the size and mtime it was cooked from.
+    bool cookedFrom(const TextureBlobSource& src) const {
+        return header().sourceSize == src.size && header().sourceTime == src.time;
+    }
+
+    // Bytes from the first level to the end of the last, as laid out on disk.
+    uint64_t payloadSize() const {
+        const TextureBlobMip& last = mip(header().mipCount - 1);
+        return last.offset + last.size - mip(0).offset;
+    }
+    const unsigned char* payload() const { return levelData(0); }
+
+    // Expand one level to RGBA8, for devices without BC sampling support.
+    std::vector<unsigned char> decodeLevel(uint32_t level) const {
+        const TextureBlobMip& m = mip(level);
+        TextureBlobFormat fmt = header().format;
+        std::vector<unsigned char> out((size_t)m.width * m.height * 4);
+        if (fmt == TextureBlobFormat::RGBA8) {
+            memcpy(out.data(), levelData(level), out.size());
+            return out;
+        }
+
+        const unsigned char* src = levelData(level);
+        unsigned char block[16 * 4];
+        for (uint32_t by = 0; by < (m.height + 3) / 4; ++by) {
+            for (uint32_t bx = 0; bx < (m.width + 3) / 4; ++bx) {
+                if (fmt == TextureBlobFormat::BC3) {
+                    decodeColour(src + 8, block, true);
+                    decodeAlpha(src, block);
+                    src += 16;
+                }
+                else {
+                    decodeColour(src, block, false);
+                    src += 8;
+                }
+                for (uint32_t y = 0; y < 4 && by * 4 + y < m.height; ++y)
+                    for (uint32_t x = 0; x < 4 && bx * 4 + x < m.width; ++x)
+                        memcpy(&out[((size_t)(by * 4 + y) * m.width + bx * 4 + x) * 4], &block[(y * 4 + x) * 4], 4);
+            }
+        }
+        return out;
+    }
+
+    // Write a container; levels[i] holds the encoded bytes of mip i.
+    static bool write(const std::string& path, TextureBlobFormat format, uint32_t width, uint32_t height,
+        const std::vector<std::vector<unsigned char>>& levels, const TextureBlobSource& source)
+    {
+        TextureBlobHeader hdr{ TEXTURE_BLOB_MAGIC, TEXTURE_BLOB_VERSION, format, width, height,
+            (uint32_t)levels.size(), source.size, source.time };
+        std::vector<TextureBlobMip> mips(levels.size());
+        uint64_t offset = align16(sizeof(hdr) + sizeof(TextureBlobMip) * mips.size());
+        for (size_t i = 0; i < levels.size(); ++i) {
+            mips[i].offset = offset;
+            mips[i].size = levels[i].size();
+            mips[i].width = std::max(1u, width >> i);
+            mips[i].height = std::max(1u, height >> i);
+            offset = align16(offset + mips[i].size);
+        }
+
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        if (!out) return false;
+        out.write(reinterpret_cast<const char*>(&hdr), sizeof(hdr));
+        out.write(reinterpret_cast<const char*>(mips.data()), sizeof(TextureBlobMip) * mips.size());
+        for (size_t i = 0; i < levels.size(); ++i) {
+            pad(out, mips[i].offset);
+            out.write(reinterpret_cast<const char*>(levels[i].data()), (std::streamsize)levels[i].size());
+        }
+        pad(out, offset);
+        return (bool)out;
+    }
+
+private:
+    const unsigned char* base = nullptr;
+    uint64_t length = 0;
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#endif
+
+    static uint64_t align16(uint64_t v) { return (v + 15) & ~uint64_t(15); }
+
+    static void pad(std::ofstream& out, uint64_t to) {
+        static const char zeros[16] = {};
+        uint64_t at = (uint64_t)out.tellp();
+        if (to > at) out.write(zeros, (std::streamsize)(to - at));
+    }
+
+    bool map(const std::string& path) {
+#ifdef _WIN32
+        file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+            FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) return false;
+        LARGE_INTEGER size{};
+        if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) return false;
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!mapping) return false;
+        base = static_cast<const unsigned char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+        length = (uint64_t)size.QuadPart;
+        return base != nullptr;
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st {};
+        if (fstat(fd, &st) != 0 || st.st_size == 0) { ::close(fd); return false; }
+        void* p = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED) return false;
+        base = static_cast<const unsigned char*>(p);
+        length = (uint64_t)st.st_size;
+        return true;
+#endif
+    }
+
+    bool validate() const {
+        if (length < sizeof(TextureBlobHeader)) return false;
+        const TextureBlobHeader& h = header();
+        if (h.magic != TEXTURE_BLOB_MAGIC || h.version != TEXTURE_BLOB_VERSION) return false;
+        if (h.format != TextureBlobFormat::RGBA8 && h.format != TextureBlobFormat::BC1 &&
+            h.format != TextureBlobFormat::BC3) return false;
+        if (h.width == 0 || h.height == 0 || h.mipCount == 0 || h.mipCount > 32) return false;
+        if (length < sizeof(TextureBlobHeader) + sizeof(TextureBlobMip) * (uint64_t)h.mipCount) return false;
+        for (uint32_t i = 0; i < h.mipCount; ++i) {
+            const TextureBlobMip& m = mip(i);
+            if (m.width != std::max(1u, h.width >> i) || m.height != std::max(1u, h.height >> i)) return false;
+            if (m.size != textureBlobLevelSize(h.format, m.width, m.height)) return false;
+            if (m.offset % 16 != 0 || m.offset + m.size > length) return false;
+        }
+        return true;
+    }
+
+    static void unpack565(uint16_t c, int rgb[3]) {
+        rgb[0] = ((c >> 11) & 31) * 255 / 31;
+        rgb[1] = ((c >> 5) & 63) * 255 / 63;
+        rgb[2] = (c & 31) * 255 / 31;
+    }
+
+    // 4x4 colour block -> 16 RGBA texels. BC3 colour blocks are always 4-colour.
+    static void decodeColour(const unsigned char* b, unsigned char* out, bool forceFourColour) {
+        uint16_t c0 = (uint16_t)(b[0] | (b[1] << 8)), c1 = (uint16_t)(b[2] | (b[3] << 8));
+        int pal[4][4];
+        unpack565(c0, pal[0]); unpack565(c1, pal[1]);
+        pal[0][3] = pal[1][3] = pal[2][3] = pal[3][3] = 255;
+        for (int k = 0; k < 3; ++k) {
+            if (c0 > c1 || forceFourColour) {
+                pal[2][k] = (2 * pal[0][k] + pal[1][k]) / 3;
+                pal[3][k] = (pal[0][k] + 2 * pal[1][k]) / 3;
+            }
+            else {
+                pal[2][k] = (pal[0][k] + pal[1][k]) / 2;
+                pal[3][k] = 0;
+            }
+        }
+        if (!(c0 > c1 || forceFourColour)) pal[3][3] = 0;
+
+        uint32_t bits = (uint32_t)b[4] | ((uint32_t)b[5] << 8) | ((uint32_t)b[6] << 16) | ((uint32_t)b[7] << 24);
+        for (int i = 0; i < 16; ++i) {
+            const int* c = pal[(bits >> (2 * i)) & 3];
+            for (int k = 0; k < 4; ++k) out[i * 4 + k] = (unsigned char)c[k];
+        }
+    }
+
+    static void decodeAlpha(const unsigned char* b, unsigned char* out) {
+        int a[8];
+        a[0] = b[0]; a[1] = b[1];
+        if (a[0] > a[1]) {
+            for (int i = 1; i < 7; ++i) a[i + 1] = ((7 - i) * a[0] + i * a[1]) / 7;
+        }
+        else {
+            for (int i = 1; i < 5; ++i) a[i + 1] = ((5 - i) * a[0] + i * a[1]) / 5;
+            a[6] = 0; a[7] = 255;
+        }
+        uint64_t bits = 0;
+        for (int i = 0; i < 6; ++i) bits |= (uint64_t)b[2 + i] << (8 * i);
+        for (int i = 0; i < 16; ++i) out[i * 4 + 3] = (unsigned char)a[(bits >> (3 * i)) & 7];
+    }
+};
@@ -0,0 +1,688 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <stb_image.h>
+#include <stb_image_resize2.h>
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+
+#include "GpuAllocator.hpp"
+#include "UploadBatcher.hpp"
+#include "ThreadPool.hpp"
+#include "TextureBlob.hpp"
+
+// --- Texture cache ----------------------------------------------------------
+// Owns every sampled RGBA8 texture. Images are deduplicated by path and by
+// content: two independent 64-bit hashes of the source pixels (or cooked
+// blocks), plus format and size, must all match before an image is reused.
+// Samplers are deduplicated by create-info.
+// Uploads go through the shared UploadBatcher, so loading N textures still
+// costs a single submit once the caller flushes. Every image gets a full mip
+// chain: blitted on the GPU when the format allows linear blits, otherwise
+// downsampled on the CPU with stb_image_resize2 and uploaded level by level.
+// A cooked .rtex next to the source (see Tools/TextureCooker) takes priority:
+// its BC1/BC3 mips are uploaded as-is, or expanded to RGBA8 if the device
+// can't sample that format.
+
+using TextureHandle = uint32_t;
+static constexpr TextureHandle INVALID_TEXTURE = UINT32_MAX;
+
+class TextureCache {
+public:
+    struct Stats {
+        uint32_t requests = 0;     // load() calls
+        uint32_t pathHits = 0;     // path seen before, no decode
+        uint32_t contentHits = 0;  // decoded, but pixels matched an existing image
+        uint32_t fallbacks = 0;    // missing files that got the checkerboard
+        uint32_t cooked = 0;       // .rtex blobs uploaded block-compressed
+        uint32_t cookedExpanded = 0; // .rtex blobs expanded to RGBA8 (no BC support)
+        uint32_t cookedStale = 0;  // .rtex older than its edited source, source decoded instead
+        uint32_t images = 0;       // VkImages actually created
+        uint32_t samplers = 0;     // VkSamplers actually created
+        uint32_t mipLevels = 0;    // levels across all images, including level 0
+        double   decodeMs = 0.0;   // decode + copy time summed over worker threads
+    };
+
+    struct Request {
+        std::string         path;
+        VkSamplerCreateInfo sampler;
+    };
+
+    void init(VkPhysicalDevice gpu, VkDevice dev, GpuAllocator& alloc, UploadBatcher& up) {
+        physicalDevice = gpu;
+        device = dev;
+        allocator = &alloc;
+        uploads = &up;
+
+        VkFormatProperties fp{};
+        vkGetPhysicalDeviceFormatProperties(physicalDevice, FORMAT, &fp);
+        const VkFormatFeatureFlags blit = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT |
+            VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+        gpuMips = (fp.optimalTilingFeatures & blit) == blit;
+
+        const VkFormatFeatureFlags sampled = VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT |
+            VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT | VK_FORMAT_FEATURE_TRANSFER_DST_BIT;
+        vkGetPhysicalDeviceFormatProperties(physicalDevice, vkFormat(TextureBlobFormat::BC1), &fp);
+        bc1 = (fp.optimalTilingFeatures & sampled) == sampled;
+        vkGetPhysicalDeviceFormatProperties(physicalDevice, vkFormat(TextureBlobFormat::BC3), &fp);
+        bc3 = (fp.optimalTilingFeatures & sampled) == sampled;
+    }
+
+    bool usesGpuMips() const { return gpuMips; }
+
+    static uint32_t mipLevelCount(uint32_t w, uint32_t h) {
+        uint32_t levels = 1;
+        for (uint32_t d = std::max(w, h); d > 1; d >>= 1) levels++;
+        return levels;
+    }
+
+    // Default sampler used by the scene: trilinear, repeat, max anisotropy.
+    VkSamplerCreateInfo defaultSampler() const {
+        VkPhysicalDeviceProperties props{};
+        vkGetPhysicalDeviceProperties(physicalDevice, &props);
+        VkSamplerCreateInfo info{ VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO };
+        info.magFilter = VK_FILTER_LINEAR; info.minFilter = VK_FILTER_LINEAR;
+        info.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+        info.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+        info.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+        info.anisotropyEnable = VK_TRUE;
+        info.maxAnisotropy = props.limits.maxSamplerAnisotropy;
+        info.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+        info.unnormalizedCoordinates = VK_FALSE;
+        info.compareEnable = VK_FALSE;
+        info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+        info.minLod = 0.0f;
+        info.maxLod = VK_LOD_CLAMP_NONE;
+        return info;
+    }
+
+    // Load (or reuse) an sRGB texture. Missing/unreadable files get the
+    // shared checkerboard rather than failing.
+    TextureHandle load(const std::string& path, const VkSamplerCreateInfo& samplerInfo) {
+        return loadBatch({ { path, samplerInfo } }, nullptr)[0];
+    }
+
+    // Decode every request on the pool at once. Workers copy pixels straight
+    // into staging slices reserved up front, and each image's copy is recorded
+    // as soon as its decode finishes; the GPU work still goes out in the
+    // caller's next flush.
+    std::vector<TextureHandle> loadMany(const std::vector<Request>& requests, ThreadPool& pool) {
+        return loadBatch(requests, &pool);
+    }
+
+    VkImageView view(TextureHandle t) const { return images[textures[t].image].view; }
+    VkSampler sampler(TextureHandle t) const { return textures[t].sampler; }
+
+    VkDescriptorImageInfo descriptor(TextureHandle t) const {
+        VkDescriptorImageInfo info{};
+        info.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        info.imageView = view(t);
+        info.sampler = sampler(t);
+        return info;
+    }
+
+    const Stats& getStats() const { return stats; }
+
+    void destroy() {
+        for (auto& s : samplers) vkDestroySampler(device, s.second.sampler, nullptr);
+        for (auto& img : images) {
+            vkDestroyImageView(device, img.view, nullptr);
+            vkDestroyImage(device, img.image, nullptr);
+            allocator->free(img.memory);
+        }
+        samplers.clear();
+        images.clear();
+        textures.clear();
+        byPath.clear();
+        byContent.clear();
+        fallback = UINT32_MAX;
+    }
+
+private:
+    struct Image {
+        VkImage       image = VK_NULL_HANDLE;
+        GpuAllocation memory;
+        VkImageView   view = VK_NULL_HANDLE;
+    };
+    struct Texture {
+        uint32_t  image;
+        VkSampler sampler;
+    };
+    // What an image was created from, kept so a hash hit can be confirmed
+    struct Content {
+        uint32_t image;
+        VkFormat format;
+        uint32_t width, height;
+        uint64_t check;   // checkBytes() of the source, second half of the 128-bit key
+    };
+    struct Sampler {
+        VkSamplerCreateInfo info;   // pNext cleared; compared field by field on a hash hit
+        VkSampler sampler;
+    };
+
+    static constexpr VkFormat FORMAT = VK_FORMAT_R8G8B8A8_SRGB;
+
+    VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+    VkDevice device = VK_NULL_HANDLE;
+    GpuAllocator* allocator = nullptr;
+    UploadBatcher* uploads = nullptr;
+    bool gpuMips = true;
+    bool bc1 = false, bc3 = false;   // device can sample these block formats
+
+    std::vector<Image> images;
+    std::vector<Texture> textures;
+    std::unordered_map<std::string, uint32_t> byPath;     // path -> image
+    std::unordered_multimap<uint64_t, Content> byContent; // pixel hash -> candidate images
+    std::unordered_multimap<uint64_t, Sampler> samplers;  // create-info hash -> candidate samplers
+    uint32_t fallback = UINT32_MAX;
+    Stats stats;
+
+    static VkFormat vkFormat(TextureBlobFormat f) {
+        switch (f) {
+        case TextureBlobFormat::BC1: return VK_FORMAT_BC1_RGB_SRGB_BLOCK;
+        case TextureBlobFormat::BC3: return VK_FORMAT_BC3_SRGB_BLOCK;
+        default:                     return FORMAT;
+        }
+    }
+
+    bool canSample(TextureBlobFormat f) const {
+        return f == TextureBlobFormat::BC1 ? bc1 : f == TextureBlobFormat::BC3 ? bc3 : true;
+    }
+
+    // "textures/rock.jpg" -> "textures/rock.rtex"
+    static std::string cookedPath(const std::string& path) {
+        size_t dot = path.find_last_of('.');
+        size_t slash = path.find_last_of("/\\");
+        if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) return path + ".rtex";
+        return path.substr(0, dot) + ".rtex";
+    }
+
+    // Shared by load() and loadMany(); with no pool the jobs run inline.
+    std::vector<TextureHandle> loadBatch(const std::vector<Request>& requests, ThreadPool* pool) {
+        struct Job {
+            std::string path;
+            int w = 0, h = 0;
+            std::shared_ptr<TextureBlob> blob;  // cooked container, if one was found
+            bool direct = false;                // upload the blob's blocks untouched
+            UploadBatcher::StagingSlice slice;
+            uint64_t hash = 0, check = 0;
+            bool ok = false;
+            double ms = 0.0;
+        };
+        std::vector<Job> jobs;
+        std::unordered_map<std::string, size_t> jobOf;
+        std::vector<VkSampler> reqSamplers(requests.size());
+
+        for (size_t i = 0; i < requests.size(); ++i) {
+            stats.requests++;
+            reqSamplers[i] = getSampler(requests[i].sampler);
+            const std::string& path = requests[i].path;
+            if (byPath.count(path) || jobOf.count(path)) { stats.pathHits++; continue; }
+
+            Job job;
+            job.path = path;
+            auto blob = std::make_shared<TextureBlob>();
+            bool cooked = blob->open(cookedPath(path));
+            // A blob whose source changed since cooking is skipped. With no
+            // source on disk (a cooked-only build) the blob is all there is.
+            if (TextureBlobSource src; cooked && textureBlobSourceStamp(path, src) && !blob->cookedFrom(src)) {
+                stats.cookedStale++;
+                cooked = false;
+            }
+            if (cooked) {
+                job.w = (int)blob->header().width;
+                job.h = (int)blob->header().height;
+                job.direct = canSample(blob->header().format);
+                job.blob = std::move(blob);
+            }
+            // header-only parse so staging can be sized before decoding
+            else if (int comp = 0; !stbi_info(path.c_str(), &job.w, &job.h, &comp)) {
+                stats.fallbacks++;
+                byPath[path] = fallbackImage();
+                continue;
+            }
+            jobOf[path] = jobs.size();
+            jobs.push_back(job);
+        }
+
+        std::vector<VkDeviceSize> sizes;
+        for (const Job& j : jobs)
+            sizes.push_back(j.direct ? (VkDeviceSize)j.blob->payloadSize() : stagingSize((uint32_t)j.w, (uint32_t)j.h));
+        std::vector<UploadBatcher::StagingSlice> slices = uploads->stageBatch(sizes);
+        for (size_t i = 0; i < jobs.size(); ++i) jobs[i].slice = slices[i];
+
+        std::mutex doneMutex;
+        std::condition_variable doneCv;
+        std::deque<size_t> done;
+        // Every job reports to `done`, including one that throws, so the loop
+        // below always sees jobs.size() completions.
+        auto work = [&](size_t i) {
+            Job& job = jobs[i];
+            auto t0 = std::chrono::steady_clock::now();
+            const uint32_t w = (uint32_t)job.w, h = (uint32_t)job.h;
+            try {
+                if (job.direct) {
+                    // compressed blocks go from the mapping straight into staging
+                    size_t size = (size_t)job.blob->payloadSize();
+                    memcpy(job.slice.data, job.blob->payload(), size);
+                    job.hash = hashValue(job.blob->header().format,
+                        hashValue(w, hashValue(h, hashBytes(job.blob->payload(), size))));
+                    job.check = checkBytes(job.blob->payload(), size);
+                    job.ok = true;
+                }
+                else if (job.blob) {
+                    std::vector<unsigned char> rgba = job.blob->decodeLevel(0);
+                    writeLevels(rgba.data(), w, h, job.slice.data);
+                    job.hash = hashValue(w, hashValue(h, hashBytes(rgba.data(), rgba.size())));
+                    job.check = checkBytes(rgba.data(), rgba.size());
+                    job.ok = true;
+                }
+                else {
+                    int pw = 0, ph = 0, ch = 0;
+                    stbi_uc* pixels = stbi_load(job.path.c_str(), &pw, &ph, &ch, STBI_rgb_alpha);
+                    if (pixels && pw == job.w && ph == job.h) {
+                        size_t size = (size_t)w * h * 4;
+                        writeLevels(pixels, w, h, job.slice.data);
+                        job.hash = hashValue(w, hashValue(h, hashBytes(pixels, size)));
+                        job.check = checkBytes(pixels, size);
+                        job.ok = true;
+                    }
+                    if (pixels) stbi_image_free(pixels);
+                }
+            }
+            catch (...) {
+                job.ok = false;
+            }
+            job.ms = std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - t0).count();
+            {
+                std::lock_guard<std::mutex> lock(doneMutex);
+                done.push_back(i);
+            }
+            doneCv.notify_one();
+        };
+        // Workers reference jobs, done and the staging slices on this stack, so
+        // nothing may propagate out of here until every submitted job finished.
+        std::vector<std::future<void>> pending;
+        pending.reserve(jobs.size());
+        auto waitAll = [&] { for (auto& f : pending) f.wait(); };
+
+        // Record uploads in completion order. Failed decodes are resolved after
+        // the loop: the fallback stages its own pixels, which may flush and
+        // rewind the ring while workers are still writing into it.
+        std::vector<size_t> failed;
+        try {
+            for (size_t i = 0; i < jobs.size(); ++i) {
+                if (pool) pending.push_back(pool->submit([&work, i] { work(i); }));
+                else work(i);
+            }
+            for (size_t n = 0; n < jobs.size(); ++n) {
+                size_t i;
+                {
+                    std::unique_lock<std::mutex> lock(doneMutex);
+                    doneCv.wait(lock, [&] { return !done.empty(); });
+                    i = done.front();
+                    done.pop_front();
+                }
+                Job& job = jobs[i];
+                stats.decodeMs += job.ms;
+                if (!job.ok) { failed.push_back(i); continue; }
+                if (job.direct) {
+                    stats.cooked++;
+                    byPath[job.path] = findOrCreateCompressed(job.hash, job.check, job.slice, *job.blob);
+                }
+                else {
+                    if (job.blob) stats.cookedExpanded++;
+                    byPath[job.path] = findOrCreateStaged(job.hash, job.check, job.slice, (uint32_t)job.w, (uint32_t)job.h);
+                }
+            }
+        }
+        catch (...) {
+            waitAll();
+            throw;
+        }
+        waitAll();
+        for (size_t i : failed) {
+            stats.fallbacks++;
+            byPath[jobs[i].path] = fallbackImage();
+        }
+
+        std::vector<TextureHandle> handles(requests.size());
+        for (size_t i = 0; i < requests.size(); ++i)
+            handles[i] = addTexture(byPath[requests[i].path], reqSamplers[i]);
+        return handles;
+    }
+
+    // FNV-1a, 64-bit
+    static uint64_t hashBytes(const void* data, size_t size, uint64_t h = 14695981039346656037ull) {
+        const unsigned char* p = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; ++i) { h ^= p[i]; h *= 1099511628211ull; }
+        return h;
+    }
+    template <typename T>
+    static uint64_t hashValue(const T& v, uint64_t h) { return hashBytes(&v, sizeof(v), h); }
+
+    // Independent of hashBytes (8-byte words through the murmur3 finalizer), so
+    // the pair makes a 128-bit content key and one collision is not enough.
+    static uint64_t checkBytes(const void* data, size_t size) {
+        auto mix = [](uint64_t k) {
+            k ^= k >> 33; k *= 0xff51afd7ed558ccdull;
+            k ^= k >> 33; k *= 0xc4ceb9fe1a85ec53ull;
+            return k ^ (k >> 33);
+        };
+        const unsigned char* p = static_cast<const unsigned char*>(data);
+        uint64_t h = 0x9e3779b97f4a7c15ull ^ mix(size);
+        size_t i = 0;
+        for (; i + 8 <= size; i += 8) {
+            uint64_t k;
+            memcpy(&k, p + i, 8);
+            h = (h ^ mix(k)) * 0x9e3779b97f4a7c15ull;
+        }
+        uint64_t tail = 0;
+        if (i < size) memcpy(&tail, p + i, size - i);
+        return mix(h ^ mix(tail));
+    }
+
+    // Hashes fields one by one: the struct has padding, and pNext can't be compared.
+    static uint64_t hashSampler(const VkSamplerCreateInfo& s) {
+        uint64_t h = 14695981039346656037ull;
+        h = hashValue(s.flags, h);
+        h = hashValue(s.magFilter, h);        h = hashValue(s.minFilter, h);
+        h = hashValue(s.mipmapMode, h);
+        h = hashValue(s.addressModeU, h);     h = hashValue(s.addressModeV, h);
+        h = hashValue(s.addressModeW, h);
+        h = hashValue(s.mipLodBias, h);
+        h = hashValue(s.anisotropyEnable, h); h = hashValue(s.maxAnisotropy, h);
+        h = hashValue(s.compareEnable, h);    h = hashValue(s.compareOp, h);
+        h = hashValue(s.minLod, h);           h = hashValue(s.maxLod, h);
+        h = hashValue(s.borderColor, h);
+        h = hashValue(s.unnormalizedCoordinates, h);
+        return h;
+    }
+
+    // The same fields hashSampler() covers, so a hash collision can't share a sampler.
+    static bool sameSampler(const VkSamplerCreateInfo& a, const VkSamplerCreateInfo& b) {
+        return a.flags == b.flags &&
+            a.magFilter == b.magFilter && a.minFilter == b.minFilter &&
+            a.mipmapMode == b.mipmapMode &&
+            a.addressModeU == b.addressModeU && a.addressModeV == b.addressModeV &&
+            a.addressModeW == b.addressModeW &&
+            a.mipLodBias == b.mipLodBias &&
+            a.anisotropyEnable == b.anisotropyEnable && a.maxAnisotropy == b.maxAnisotropy &&
+            a.compareEnable == b.compareEnable && a.compareOp == b.compareOp &&
+            a.minLod == b.minLod && a.maxLod == b.maxLod &&
+            a.borderColor == b.borderColor &&
+            a.unnormalizedCoordinates == b.unnormalizedCoordinates;
+    }
+
+    VkSampler getSampler(const VkSamplerCreateInfo& info) {
+        uint64_t key = hashSampler(info);
+        auto [first, last] = samplers.equal_range(key);
+        for (auto it = first; it != last; ++it)
+            if (sameSampler(it->second.info, info)) return it->second.sampler;
+
+        VkSampler s;
+        if (vkCreateSampler(device, &info, nullptr, &s) != VK_SUCCESS)
+            throw std::runtime_error("Failed to create sampler");
+        Sampler entry{ info, s };
+        entry.info.pNext = nullptr;
+        samplers.emplace(key, entry);
+        stats.samplers++;
+        return s;
+    }
+
+    TextureHandle addTexture(uint32_t image, VkSampler sampler) {
+        for (size_t i = 0; i < textures.size(); ++i)
+            if (textures[i].image == image && textures[i].sampler == sampler)
+                return (TextureHandle)i;
+        textures.push_back({ image, sampler });
+        return (TextureHandle)(textures.size() - 1);
+    }
+
+    // An existing image with the same pair of hashes, format and size, or
+    // UINT32_MAX. Only hashes are kept: staging is write-combined and must not
+    // be read back, and a copy of every texture would double the cache.
+    uint32_t findContent(uint64_t key, uint64_t check, VkFormat format, uint32_t w, uint32_t h) {
+        auto [first, last] = byContent.equal_range(key);
+        for (auto it = first; it != last; ++it) {
+            const Content& c = it->second;
+            if (c.check == check && c.format == format && c.width == w && c.height == h) {
+                stats.contentHits++;
+                return c.image;
+            }
+        }
+        return UINT32_MAX;
+    }
+
+    uint32_t findOrCreateImage(const unsigned char* rgba, uint32_t w, uint32_t h) {
+        size_t size = (size_t)w * h * 4;
+        uint64_t key = hashValue(w, hashValue(h, hashBytes(rgba, size)));
+        uint64_t check = checkBytes(rgba, size);
+        uint32_t idx = findContent(key, check, FORMAT, w, h);
+        if (idx != UINT32_MAX) return idx;
+
+        // mips are only built on a miss
+        UploadBatcher::StagingSlice staging = uploads->stage(stagingSize(w, h));
+        writeLevels(rgba, w, h, staging.data);
+        idx = createImage(staging, w, h);
+        byContent.emplace(key, Content{ idx, FORMAT, w, h, check });
+        return idx;
+    }
+
+    // Same as above for pixels that are already sitting in staging memory;
+    // key and check were taken from the source before it was staged.
+    uint32_t findOrCreateStaged(uint64_t key, uint64_t check, const UploadBatcher::StagingSlice& staging,
+                                uint32_t w, uint32_t h) {
+        uint32_t idx = findContent(key, check, FORMAT, w, h);
+        if (idx != UINT32_MAX) return idx;
+        idx = createImage(staging, w, h);
+        byContent.emplace(key, Content{ idx, FORMAT, w, h, check });
+        return idx;
+    }
+
+    uint32_t findOrCreateCompressed(uint64_t key, uint64_t check, const UploadBatcher::StagingSlice& staging,
+                                    const TextureBlob& blob) {
+        const TextureBlobHeader& hdr = blob.header();
+        const VkFormat format = vkFormat(hdr.format);
+        uint32_t idx = findContent(key, check, format, hdr.width, hdr.height);
+        if (idx != UINT32_MAX) return idx;
+        idx = createCompressedImage(staging, blob);
+        byContent.emplace(key, Content{ idx, format, hdr.width, hdr.height, check });
+        return idx;
+    }
+
+    uint32_t fallbackImage() {
+        if (fallback == UINT32_MAX) {
+            // 2x2 checker, created once and shared by every missing texture
+            const unsigned char checker[16] = {
+                200,200,200,255,  50, 50, 50,255,
+                 50, 50, 50,255, 200,200,200,255 };
+            fallback = findOrCreateImage(checker, 2, 2);
+        }
+        return fallback;
+    }
+
+    // Bytes of staging an image needs: level 0 only when the GPU builds the
+    // chain, every level back to back when the CPU does.
+    VkDeviceSize stagingSize(uint32_t w, uint32_t h) const {
+        if (gpuMips) return (VkDeviceSize)w * h * 4;
+        VkDeviceSize total = 0;
+        for (uint32_t l = 0, n = mipLevelCount(w, h); l < n; ++l)
+            total += (VkDeviceSize)std::max(1u, w >> l) * std::max(1u, h >> l) * 4;
+        return total;
+    }
+
+    // Fill a staging slice sized by stagingSize(). Safe to call from workers.
+    void writeLevels(const unsigned char* rgba, uint32_t w, uint32_t h, void* dst) const {
+        unsigned char* out = static_cast<unsigned char*>(dst);
+        memcpy(out, rgba, (size_t)w * h * 4);
+        if (gpuMips) return;
+
+        // Each level is filtered from the previous one, kept in ordinary memory
+        // so we never read back from write-combined staging.
+        std::vector<unsigned char> prev(rgba, rgba + (size_t)w * h * 4), next;
+        uint32_t pw = w, ph = h;
+        out += (size_t)w * h * 4;
+        for (uint32_t l = 1, n = mipLevelCount(w, h); l < n; ++l) {
+            uint32_t lw = std::max(1u, pw >> 1), lh = std::max(1u, ph >> 1);
+            next.resize((size_t)lw * lh * 4);
+            stbir_resize_uint8_srgb(prev.data(), (int)pw, (int)ph, 0,
+                next.data(), (int)lw, (int)lh, 0, STBIR_RGBA);
+            memcpy(out, next.data(), next.size());
+            out += next.size();
+            prev.swap(next);
+            pw = lw; ph = lh;
+        }
+    }
+
+    // Image + memory in UNDEFINED layout; the caller records the upload and
+    // then hands it to addImage().
+    Image allocImage(VkFormat format, uint32_t w, uint32_t h, uint32_t levels, VkImageUsageFlags usage) {
+        Image img{};
+        VkImageCreateInfo ii{ VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO };
+        ii.imageType = VK_IMAGE_TYPE_2D;
+        ii.extent = { w, h, 1 };
+        ii.mipLevels = levels; ii.arrayLayers = 1;
+        ii.format = format;
+        ii.tiling = VK_IMAGE_TILING_OPTIMAL;
+        ii.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        ii.usage = usage;
+        ii.samples = VK_SAMPLE_COUNT_1_BIT;
+        ii.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        if (vkCreateImage(device, &ii, nullptr, &img.image) != VK_SUCCESS)
+            throw std::runtime_error("createImage fail");
+        VkMemoryRequirements req{}; vkGetImageMemoryRequirements(device, img.image, &req);
+        img.memory = allocator->allocate(req, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, true);
+        vkBindImageMemory(device, img.image, img.memory.memory, img.memory.offset);
+        return img;
+    }
+
+    uint32_t addImage(Image img, VkFormat format, uint32_t levels) {
+        VkImageViewCreateInfo vi{ VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO };
+        vi.image = img.image; vi.viewType = VK_IMAGE_VIEW_TYPE_2D; vi.format = format;
+        vi.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        vi.subresourceRange.levelCount = levels;
+        vi.subresourceRange.layerCount = 1;
+        if (vkCreateImageView(device, &vi, nullptr, &img.view) != VK_SUCCESS)
+            throw std::runtime_error("createImageView fail");
+
+        images.push_back(img);
+        stats.images++;
+        stats.mipLevels += levels;
+        return (uint32_t)(images.size() - 1);
+    }
+
+    uint32_t createImage(const UploadBatcher::StagingSlice& staging, uint32_t w, uint32_t h) {
+        const uint32_t levels = mipLevelCount(w, h);
+        VkImageUsageFlags usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+        if (gpuMips) usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+        Image img = allocImage(FORMAT, w, h, levels, usage);
+
+        uploads->imageBarrier(layoutBarrier(img.image, 0, levels,
+            VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT, 0,
+            VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT));
+
+        if (gpuMips) {
+            uploads->copyBufferToImage(staging.buffer, staging.offset, img.image, w, h);
+            recordBlitChain(img.image, w, h, levels);
+        }
+        else {
+            VkDeviceSize offset = staging.offset;
+            for (uint32_t l = 0; l < levels; ++l) {
+                uint32_t lw = std::max(1u, w >> l), lh = std::max(1u, h >> l);
+                uploads->copyBufferToImage(staging.buffer, offset, img.image, lw, lh, l);
+                offset += (VkDeviceSize)lw * lh * 4;
+            }
+            uploads->imageBarrier(layoutBarrier(img.image, 0, levels,
+                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT,
+                VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT, VK_ACCESS_2_SHADER_READ_BIT));
+        }
+        return addImage(img, FORMAT, levels);
+    }
+
+    // The blob payload was copied verbatim, so each level sits at the same
+    // relative offset in staging as it does in the file.
+    uint32_t createCompressedImage(const UploadBatcher::StagingSlice& staging, const TextureBlob& blob) {
+        const TextureBlobHeader& hdr = blob.header();
+        const VkFormat format = vkFormat(hdr.format);
+        Image img = allocImage(format, hdr.width, hdr.height, hdr.mipCount,
+            VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT);
+
+        uploads->imageBarrier(layoutBarrier(img.image, 0, hdr.mipCount,
+            VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT, 0,
+            VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT));
+        for (uint32_t l = 0; l < hdr.mipCount; ++l) {
+            const TextureBlobMip& m = blob.mip(l);
+            uploads->copyBufferToImage(staging.buffer, staging.offset + (m.offset - blob.mip(0).offset),
+                img.image, m.width, m.height, l);
+        }
+        uploads->imageBarrier(layoutBarrier(img.image, 0, hdr.mipCount,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT,
+            VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT, VK_ACCESS_2_SHADER_READ_BIT));
+        return addImage(img, format, hdr.mipCount);
+    }
+
+    // Level 0 is in TRANSFER_DST. Walk down the chain blitting level i-1 into
+    // level i, then hand every level to the fragment shader.
+    void recordBlitChain(VkImage image, uint32_t w, uint32_t h, uint32_t levels) {
+        int32_t mw = (int32_t)w, mh = (int32_t)h;
+        for (uint32_t l = 1; l < levels; ++l) {
+            uploads->imageBarrier(layoutBarrier(image, l - 1, 1,
+                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT,
+                VK_PIPELINE_STAGE_2_BLIT_BIT, VK_ACCESS_2_TRANSFER_READ_BIT));
+
+            int32_t nw = mw > 1 ? mw / 2 : 1, nh = mh > 1 ? mh / 2 : 1;
+            VkImageBlit blit{};
+            blit.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, l - 1, 0, 1 };
+            blit.srcOffsets[1] = { mw, mh, 1 };
+            blit.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, l, 0, 1 };
+            blit.dstOffsets[1] = { nw, nh, 1 };
+            vkCmdBlitImage(uploads->recording(),
+                image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                1, &blit, VK_FILTER_LINEAR);
+            mw = nw; mh = nh;
+        }
+
+        if (levels > 1)
+            uploads->imageBarrier(layoutBarrier(image, 0, levels - 1,
+                VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                VK_PIPELINE_STAGE_2_BLIT_BIT, VK_ACCESS_2_TRANSFER_READ_BIT,
+                VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT, VK_ACCESS_2_SHADER_READ_BIT));
+        uploads->imageBarrier(layoutBarrier(image, levels - 1, 1,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            VK_PIPELINE_STAGE_2_TRANSFER_BIT | VK_PIPELINE_STAGE_2_BLIT_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT,
+            VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT, VK_ACCESS_2_SHADER_READ_BIT));
+    }
+
+    static VkImageMemoryBarrier2 layoutBarrier(VkImage image, uint32_t baseLevel, uint32_t levelCount,
+        VkImageLayout oldL, VkImageLayout newL,
+        VkPipelineStageFlags2 srcStage, VkAccessFlags2 srcAccess,
+        VkPipelineStageFlags2 dstStage, VkAccessFlags2 dstAccess)
+    {
+        VkImageMemoryBarrier2 b{ VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2 };
+        b.srcStageMask = srcStage; b.srcAccessMask = srcAccess;
+        b.dstStageMask = dstStage; b.dstAccessMask = dstAccess;
+        b.oldLayout = oldL; b.newLayout = newL;
+        b.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        b.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        b.image = image;
+        b.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, baseLevel, levelCount, 0, 1 };
+        return b;
+    }
+};
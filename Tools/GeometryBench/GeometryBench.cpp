@@ -0,0 +1,94 @@
+//==================================================
+// GeometryBench — push_back vs batched mesh generators (Week_3/GeometryUtil.hpp)
+//==================================================
+//
+//   GeometryBench [--vertices N] [--reps R]
+//
+// Builds a grid, a cylinder and a sphere of about N vertices (default 1M)
+// with the createXxxStrip generators and with the createXxxStreams ones, and
+// reports the best of R runs of each. The stream versions also write normals
+// and UVs, which the strip versions don't have. Before timing, the stream
+// positions and indices are checked against the strip output.
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+#include "../../Week_3/GeometryUtil.hpp"
+
+static volatile float sink;
+
+template <class Build>
+static double bestMs(int reps, Build&& build) {
+    double best = 1e30;
+    for (int r = 0; r < reps; r++) {
+        auto t0 = std::chrono::steady_clock::now();
+        auto mesh = build();
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+        best = std::min(best, ms);
+        sink = (float)mesh.indices.size();
+    }
+    return best;
+}
+
+// Largest position difference, or -1 if the topology differs.
+static double compare(const MeshData& a, const MeshStreams& b) {
+    if (a.vertices.size() != b.vertexCount() || a.indices != b.indices) return -1.0;
+    double worst = 0.0;
+    for (size_t i = 0; i < a.vertices.size(); i++) {
+        glm::vec3 d = a.vertices[i].pos - glm::vec3(b.px[i], b.py[i], b.pz[i]);
+        worst = std::max(worst, (double)std::max({ std::fabs(d.x), std::fabs(d.y), std::fabs(d.z) }));
+    }
+    return worst;
+}
+
+template <class Scalar, class Batched>
+static bool run(const char* name, int reps, Scalar&& scalar, Batched&& batched) {
+    MeshData reference = scalar();
+    MeshStreams streams = batched();
+    double diff = compare(reference, streams);
+    if (diff < 0.0 || diff > 1e-5) {
+        std::cerr << name << ": batched output differs from scalar ("
+            << (diff < 0.0 ? std::string("topology") : "position error " + std::to_string(diff)) << ")" << std::endl;
+        return false;
+    }
+
+    const double n = (double)reference.vertices.size();
+    double scalarMs = bestMs(reps, scalar);
+    double batchedMs = bestMs(reps, batched);
+    std::cout << name << ": " << (size_t)n << " vertices, strip " << scalarMs << " ms ("
+        << n / (scalarMs * 1e3) << " Mvert/s), streams " << batchedMs << " ms ("
+        << n / (batchedMs * 1e3) << " Mvert/s, " << scalarMs / batchedMs << "x)" << std::endl;
+    return true;
+}
+
+int main(int argc, char** argv) {
+    size_t vertices = size_t(1) << 20;
+    int reps = 5;
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        if (a == "--vertices" && i + 1 < argc) vertices = (size_t)std::max(16L, std::atol(argv[++i]));
+        else if (a == "--reps" && i + 1 < argc) reps = std::max(1, std::atoi(argv[++i]));
+        else { std::cerr << "usage: GeometryBench [--vertices N] [--reps R]" << std::endl; return EXIT_FAILURE; }
+    }
+
+    const uint32_t side = (uint32_t)std::ceil(std::sqrt((double)vertices));
+    const glm::vec3 color(0.25f, 0.70f, 0.25f);
+    std::cout << "GeoSimd: " << GeoSimd::NAME << " (" << GeoSimd::WIDTH << " lanes), best of " << reps << std::endl;
+
+    bool ok = true;
+    ok &= run("grid", reps,
+        [&] { return createGridStrip(30.0f, 30.0f, side, side, color); },
+        [&] { return createGridStreams(30.0f, 30.0f, side, side); });
+    ok &= run("cylinder", reps,
+        [&] { return createCylinderStrip(1.0f, 0.5f, 2.0f, side - 1, side - 1, color); },
+        [&] { return createCylinderStreams(1.0f, 0.5f, 2.0f, side - 1, side - 1); });
+    ok &= run("sphere", reps,
+        [&] { return createSphereStrip(1.0f, side - 1, side + 1, color); },
+        [&] { return createSphereStreams(1.0f, side - 1, side + 1); });
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,161 @@
+//==================================================
+// TextureCooker — source images -> BC1/BC3 mip chains (.rtex)
+//==================================================
+//
+//   TextureCooker [--bc1 | --bc3 | --auto] [--fast] <image> [<image> ...]
+//
+// Each input is written next to itself with the extension replaced by .rtex.
+// The input's size and mtime go into the header; the app ignores a .rtex whose
+// source has changed since, so re-run this after editing an image.
+// --auto (the default) picks BC3 when any texel has alpha < 255, BC1 otherwise.
+// Mips are filtered in sRGB space with stb_image_resize2; 4x4 blocks are
+// compressed with stb_dxt, spread across all cores.
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+#define STB_IMAGE_RESIZE_IMPLEMENTATION
+#include <stb_image_resize2.h>
+#define STB_DXT_IMPLEMENTATION
+#include <stb_dxt.h>
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <future>
+#include <chrono>
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+
+#include "../../ThreadPool.hpp"
+#include "../../TextureBlob.hpp"
+
+enum class CookFormat { Auto, BC1, BC3 };
+
+static std::string outputPath(const std::string& in) {
+    size_t dot = in.find_last_of('.');
+    size_t slash = in.find_last_of("/\\");
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) return in + ".rtex";
+    return in.substr(0, dot) + ".rtex";
+}
+
+static bool hasAlpha(const unsigned char* rgba, size_t texels) {
+    for (size_t i = 0; i < texels; ++i)
+        if (rgba[i * 4 + 3] != 255) return true;
+    return false;
+}
+
+// Compress one level. Work is split into bands of block rows; edge blocks
+// replicate the last row/column so partial blocks don't bleed black.
+static std::vector<unsigned char> compressLevel(ThreadPool& pool, const unsigned char* rgba,
+    uint32_t w, uint32_t h, TextureBlobFormat fmt, int mode)
+{
+    const uint32_t bw = (w + 3) / 4, bh = (h + 3) / 4;
+    const uint32_t blockBytes = textureBlobBlockBytes(fmt);
+    const int alpha = fmt == TextureBlobFormat::BC3 ? 1 : 0;
+    std::vector<unsigned char> out((size_t)bw * bh * blockBytes);
+
+    const uint32_t rowsPerJob = std::max(1u, bh / (pool.size() * 4));
+    std::vector<std::future<void>> jobs;
+    for (uint32_t y0 = 0; y0 < bh; y0 += rowsPerJob) {
+        uint32_t y1 = std::min(bh, y0 + rowsPerJob);
+        jobs.push_back(pool.submit([=, &out] {
+            unsigned char block[16 * 4];
+            for (uint32_t by = y0; by < y1; ++by) {
+                for (uint32_t bx = 0; bx < bw; ++bx) {
+                    for (uint32_t y = 0; y < 4; ++y) {
+                        uint32_t sy = std::min(by * 4 + y, h - 1);
+                        for (uint32_t x = 0; x < 4; ++x) {
+                            uint32_t sx = std::min(bx * 4 + x, w - 1);
+                            memcpy(&block[(y * 4 + x) * 4], &rgba[((size_t)sy * w + sx) * 4], 4);
+                        }
+                    }
+                    stb_compress_dxt_block(&out[((size_t)by * bw + bx) * blockBytes], block, alpha, mode);
+                }
+            }
+        }));
+    }
+    for (auto& j : jobs) j.get();
+    return out;
+}
+
+static bool cook(ThreadPool& pool, const std::string& in, CookFormat want, int mode) {
+    // stamped before reading, so an edit made while cooking leaves the blob stale
+    TextureBlobSource source;
+    if (!textureBlobSourceStamp(in, source)) {
+        std::cerr << "  " << in << ": cannot stat\n";
+        return false;
+    }
+    int w = 0, h = 0, ch = 0;
+    stbi_uc* pixels = stbi_load(in.c_str(), &w, &h, &ch, STBI_rgb_alpha);
+    if (!pixels) {
+        std::cerr << "  " << in << ": " << stbi_failure_reason() << "\n";
+        return false;
+    }
+
+    TextureBlobFormat fmt = want == CookFormat::BC1 ? TextureBlobFormat::BC1
+        : want == CookFormat::BC3 ? TextureBlobFormat::BC3
+        : hasAlpha(pixels, (size_t)w * h) ? TextureBlobFormat::BC3 : TextureBlobFormat::BC1;
+
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<std::vector<unsigned char>> levels;
+    std::vector<unsigned char> cur(pixels, pixels + (size_t)w * h * 4), next;
+    stbi_image_free(pixels);
+
+    uint32_t lw = (uint32_t)w, lh = (uint32_t)h;
+    for (;;) {
+        levels.push_back(compressLevel(pool, cur.data(), lw, lh, fmt, mode));
+        if (lw == 1 && lh == 1) break;
+        uint32_t nw = std::max(1u, lw >> 1), nh = std::max(1u, lh >> 1);
+        next.resize((size_t)nw * nh * 4);
+        stbir_resize_uint8_srgb(cur.data(), (int)lw, (int)lh, 0, next.data(), (int)nw, (int)nh, 0, STBIR_RGBA);
+        cur.swap(next);
+        lw = nw; lh = nh;
+    }
+
+    std::string out = outputPath(in);
+    if (!TextureBlob::write(out, fmt, (uint32_t)w, (uint32_t)h, levels, source)) {
+        std::cerr << "  " << out << ": write failed\n";
+        return false;
+    }
+
+    size_t packed = 0;
+    for (auto& l : levels) packed += l.size();
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    std::cout << "  " << in << " -> " << out << "  " << w << "x" << h << " "
+        << (fmt == TextureBlobFormat::BC1 ? "BC1" : "BC3") << ", " << levels.size() << " mips, "
+        << packed / 1024 << " KiB (RGBA8 would be " << (size_t)w * h * 4 * 4 / 3 / 1024 << " KiB), "
+        << ms << " ms\n";
+    return true;
+}
+
+int main(int argc, char** argv) {
+    CookFormat fmt = CookFormat::Auto;
+    int mode = STB_DXT_HIGHQUAL;
+    std::vector<std::string> inputs;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--bc1") fmt = CookFormat::BC1;
+        else if (arg == "--bc3") fmt = CookFormat::BC3;
+        else if (arg == "--auto") fmt = CookFormat::Auto;
+        else if (arg == "--fast") mode = STB_DXT_NORMAL;
+        else if (arg.rfind("--", 0) == 0) {
+            std::cerr << "Unknown option: " << arg << "\n";
+            return EXIT_FAILURE;
+        }
+        else inputs.push_back(arg);
+    }
+    if (inputs.empty()) {
+        std::cerr << "usage: TextureCooker [--bc1 | --bc3 | --auto] [--fast] <image> [<image> ...]\n";
+        return EXIT_FAILURE;
+    }
+
+    ThreadPool pool(std::max(1u, std::thread::hardware_concurrency()));
+    std::cout << "Cooking " << inputs.size() << " texture(s) on " << pool.size() << " thread(s)\n";
+
+    int failures = 0;
+    for (const std::string& in : inputs)
+        if (!cook(pool, in, fmt, mode)) failures++;
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,98 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <stdexcept>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+
+#include "GpuAllocator.hpp"
+
+// --- Per-frame uniform ring ------------------------------------------------
+// One persistently mapped, host-coherent buffer split into a region per frame
+// in flight. push() copies a UBO into the current frame's region and returns
+// its dynamic offset, aligned to minUniformBufferOffsetAlignment, so every
+// draw can share one VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC descriptor set.
+// A region is rewound by beginFrame() once that frame's fence has signalled.
+
+class UniformRing {
+public:
+    void init(VkPhysicalDevice gpu, VkDevice dev, GpuAllocator& alloc, uint32_t framesInFlight,
+        VkDeviceSize maxSliceBytes, uint32_t slicesPerFrame)
+    {
+        device = dev;
+        allocator = &alloc;
+
+        VkPhysicalDeviceProperties props{};
+        vkGetPhysicalDeviceProperties(gpu, &props);
+        align = std::max<VkDeviceSize>(props.limits.minUniformBufferOffsetAlignment, 1);
+        if (maxSliceBytes > props.limits.maxUniformBufferRange)
+            throw std::runtime_error("UniformRing: slice exceeds maxUniformBufferRange");
+
+        sliceBytes = alignUp(maxSliceBytes);
+        frameBytes = sliceBytes * slicesPerFrame;
+        frameOffsets.resize(framesInFlight);
+        for (uint32_t f = 0; f < framesInFlight; ++f) frameOffsets[f] = f * frameBytes;
+
+        VkBufferCreateInfo bi{ VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
+        bi.size = frameBytes * framesInFlight;
+        bi.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+        bi.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        if (vkCreateBuffer(device, &bi, nullptr, &ringBuffer) != VK_SUCCESS)
+            throw std::runtime_error("UniformRing: failed to create buffer");
+        VkMemoryRequirements req{}; vkGetBufferMemoryRequirements(device, ringBuffer, &req);
+        memory = allocator->allocate(req,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, false);
+        vkBindBufferMemory(device, ringBuffer, memory.memory, memory.offset);
+        mapped = static_cast<char*>(memory.mapped);
+    }
+
+    void destroy() {
+        if (!device) return;
+        vkDestroyBuffer(device, ringBuffer, nullptr);
+        allocator->free(memory);
+        device = VK_NULL_HANDLE;
+    }
+
+    // Call after waiting on `frame`'s fence, before the first push() of the frame.
+    void beginFrame(uint32_t frame) {
+        current = frame;
+        head = 0;
+    }
+
+    // Copy `size` bytes into the current frame's region. Returns the dynamic
+    // offset to pass to vkCmdBindDescriptorSets.
+    uint32_t push(const void* data, VkDeviceSize size) {
+        if (size > sliceBytes) throw std::runtime_error("UniformRing: push larger than the slice size");
+        if (head + size > frameBytes) throw std::runtime_error("UniformRing: frame region full");
+        VkDeviceSize offset = frameOffsets[current] + head;
+        memcpy(mapped + offset, data, (size_t)size);
+        head += alignUp(size);
+        if (head > peak) peak = head;
+        return (uint32_t)offset;
+    }
+
+    template <typename T>
+    uint32_t push(const T& value) { return push(&value, sizeof(T)); }
+
+    VkBuffer buffer() const { return ringBuffer; }
+    // Range for the descriptor: the largest slice a single draw may read
+    VkDeviceSize range() const { return sliceBytes; }
+    VkDeviceSize alignment() const { return align; }
+    VkDeviceSize bytesPerFrame() const { return frameBytes; }
+    VkDeviceSize peakBytes() const { return peak; }
+
+private:
+    VkDevice device = VK_NULL_HANDLE;
+    GpuAllocator* allocator = nullptr;
+    VkBuffer ringBuffer = VK_NULL_HANDLE;
+    GpuAllocation memory;
+    char* mapped = nullptr;
+
+    VkDeviceSize align = 1, sliceBytes = 0, frameBytes = 0;
+    std::vector<VkDeviceSize> frameOffsets;
+    uint32_t current = 0;
+    VkDeviceSize head = 0, peak = 0;
+
+    VkDeviceSize alignUp(VkDeviceSize v) const { return (v + align - 1) / align * align; }
+};
@@ -0,0 +1,272 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <stdexcept>
+#include <cstring>
+#include <cstdint>
+
+#include "GpuAllocator.hpp"
+
+// --- Batched upload queue -------------------------------------------------
+// Collects staging copies and layout transitions into one command buffer and
+// submits them together behind a fence, instead of one submit + vkQueueWaitIdle
+// per operation. Staging memory comes from a persistently mapped ring that is
+// rewound once the batch using it has retired.
+
+class UploadBatcher {
+public:
+    struct StagingSlice {
+        VkBuffer     buffer = VK_NULL_HANDLE;
+        VkDeviceSize offset = 0;
+        void*        data = nullptr;
+    };
+
+    struct Stats {
+        uint32_t     submits = 0;     // vkQueueSubmit calls
+        uint32_t     waits = 0;       // fence waits
+        uint32_t     copies = 0;      // buffer->buffer and buffer->image copies
+        uint32_t     transitions = 0; // image layout transitions
+        uint32_t     barrierBatches = 0; // vkCmdPipelineBarrier2 calls the transitions were merged into
+        VkDeviceSize stagedBytes = 0;
+
+        // The old path paid one submit and one vkQueueWaitIdle per copy/transition.
+        uint32_t legacySubmits() const { return copies + transitions; }
+    };
+
+    static constexpr VkDeviceSize DEFAULT_RING_SIZE = 32ull * 1024 * 1024;
+
+    void init(VkDevice dev, VkQueue q, uint32_t queueFamily, GpuAllocator& alloc,
+        VkDeviceSize ringSize = DEFAULT_RING_SIZE)
+    {
+        device = dev;
+        queue = q;
+        allocator = &alloc;
+
+        VkCommandPoolCreateInfo pi{ VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO };
+        pi.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+        pi.queueFamilyIndex = queueFamily;
+        if (vkCreateCommandPool(device, &pi, nullptr, &pool) != VK_SUCCESS)
+            throw std::runtime_error("UploadBatcher: failed to create command pool");
+
+        VkCommandBufferAllocateInfo ai{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO };
+        ai.commandPool = pool;
+        ai.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        ai.commandBufferCount = 1;
+        if (vkAllocateCommandBuffers(device, &ai, &cmdBuffer) != VK_SUCCESS)
+            throw std::runtime_error("UploadBatcher: failed to allocate command buffer");
+
+        VkFenceCreateInfo fi{ VK_STRUCTURE_TYPE_FENCE_CREATE_INFO };
+        if (vkCreateFence(device, &fi, nullptr, &fence) != VK_SUCCESS)
+            throw std::runtime_error("UploadBatcher: failed to create fence");
+
+        ringCapacity = ringSize;
+        ringBuffer = createStagingBuffer(ringCapacity, ringMemory);
+    }
+
+    void destroy() {
+        if (!device) return;
+        flush();
+        releaseOverflow();
+        vkDestroyBuffer(device, ringBuffer, nullptr);
+        allocator->free(ringMemory);
+        vkDestroyFence(device, fence, nullptr);
+        vkDestroyCommandPool(device, pool, nullptr);
+        device = VK_NULL_HANDLE;
+    }
+
+    // Reserve `size` bytes of mapped staging memory for the current batch.
+    StagingSlice stage(VkDeviceSize size, VkDeviceSize alignment = 16) {
+        if (size > ringCapacity) {
+            // too big for the ring: a one-off buffer that lives until the batch retires
+            Overflow o{};
+            o.buffer = createStagingBuffer(size, o.memory);
+            overflow.push_back(o);
+            stats.stagedBytes += size;
+            return { o.buffer, 0, o.memory.mapped };
+        }
+
+        VkDeviceSize offset = (ringHead + alignment - 1) / alignment * alignment;
+        if (offset + size > ringCapacity) {
+            // ring exhausted: retire what we have and start over
+            flush();
+            offset = 0;
+        }
+        ringHead = offset + size;
+        stats.stagedBytes += size;
+        return { ringBuffer, offset, static_cast<char*>(ringMemory.mapped) + offset };
+    }
+
+    // Reserve several slices that stay valid together until the next flush,
+    // e.g. to let worker threads fill them concurrently. Flushes at most once,
+    // up front; whatever still doesn't fit gets its own overflow buffer.
+    std::vector<StagingSlice> stageBatch(const std::vector<VkDeviceSize>& sizes, VkDeviceSize alignment = 16) {
+        VkDeviceSize total = 0;
+        for (VkDeviceSize s : sizes) total += (s + alignment - 1) / alignment * alignment;
+        if (ringHead + total > ringCapacity && ringHead > 0) flush();
+
+        std::vector<StagingSlice> slices;
+        slices.reserve(sizes.size());
+        for (VkDeviceSize size : sizes) {
+            VkDeviceSize offset = (ringHead + alignment - 1) / alignment * alignment;
+            if (offset + size > ringCapacity) {
+                Overflow o{};
+                o.buffer = createStagingBuffer(size, o.memory);
+                overflow.push_back(o);
+                slices.push_back({ o.buffer, 0, o.memory.mapped });
+            }
+            else {
+                ringHead = offset + size;
+                slices.push_back({ ringBuffer, offset, static_cast<char*>(ringMemory.mapped) + offset });
+            }
+            stats.stagedBytes += size;
+        }
+        return slices;
+    }
+
+    void uploadBuffer(const void* src, VkDeviceSize size, VkBuffer dst, VkDeviceSize dstOffset = 0) {
+        StagingSlice s = stage(size);
+        memcpy(s.data, src, (size_t)size);
+        copyBuffer(s.buffer, s.offset, dst, dstOffset, size);
+    }
+
+    void copyBuffer(VkBuffer src, VkDeviceSize srcOffset, VkBuffer dst, VkDeviceSize dstOffset, VkDeviceSize size) {
+        VkCommandBuffer cb = recording();
+        VkBufferCopy region{};
+        region.srcOffset = srcOffset;
+        region.dstOffset = dstOffset;
+        region.size = size;
+        vkCmdCopyBuffer(cb, src, dst, 1, &region);
+        stats.copies++;
+    }
+
+    void copyBufferToImage(VkBuffer src, VkDeviceSize srcOffset, VkImage dst, uint32_t w, uint32_t h,
+        uint32_t mipLevel = 0)
+    {
+        VkCommandBuffer cb = recording();
+        VkBufferImageCopy r{};
+        r.bufferOffset = srcOffset;
+        r.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        r.imageSubresource.mipLevel = mipLevel;
+        r.imageSubresource.layerCount = 1;
+        r.imageExtent = { w, h, 1 };
+        vkCmdCopyBufferToImage(cb, src, dst, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &r);
+        stats.copies++;
+    }
+
+    // Layout transitions are queued and emitted as one merged barrier right
+    // before the next command that depends on them.
+    void imageBarrier(const VkImageMemoryBarrier2& b) {
+        pendingBarriers.push_back(b);
+        stats.transitions++;
+    }
+
+    // Open command buffer of the current batch, with queued barriers flushed;
+    // for callers that record their own transfer commands.
+    VkCommandBuffer recording() {
+        if (!open) {
+            VkCommandBufferBeginInfo bi{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+            bi.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+            vkBeginCommandBuffer(cmdBuffer, &bi);
+            open = true;
+        }
+        emitBarriers();
+        return cmdBuffer;
+    }
+
+    // Submit everything recorded so far and wait for it once.
+    void flush() {
+        if (!open && pendingBarriers.empty()) return;
+        VkCommandBuffer cb = recording();
+
+        // make every transfer write visible to whatever reads the data next
+        VkMemoryBarrier2 mb{ VK_STRUCTURE_TYPE_MEMORY_BARRIER_2 };
+        mb.srcStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT;
+        mb.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+        mb.dstStageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+        mb.dstAccessMask = VK_ACCESS_2_MEMORY_READ_BIT;
+        VkDependencyInfo dep{ VK_STRUCTURE_TYPE_DEPENDENCY_INFO };
+        dep.memoryBarrierCount = 1;
+        dep.pMemoryBarriers = &mb;
+        vkCmdPipelineBarrier2(cb, &dep);
+
+        vkEndCommandBuffer(cb);
+        open = false;
+
+        VkCommandBufferSubmitInfo cbsi{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO };
+        cbsi.commandBuffer = cb;
+        VkSubmitInfo2 si{ VK_STRUCTURE_TYPE_SUBMIT_INFO_2 };
+        si.commandBufferInfoCount = 1;
+        si.pCommandBufferInfos = &cbsi;
+        if (vkQueueSubmit2(queue, 1, &si, fence) != VK_SUCCESS)
+            throw std::runtime_error("UploadBatcher: submit failed");
+        stats.submits++;
+
+        vkWaitForFences(device, 1, &fence, VK_TRUE, UINT64_MAX);
+        vkResetFences(device, 1, &fence);
+        vkResetCommandBuffer(cb, 0);
+        stats.waits++;
+
+        ringHead = 0;
+        releaseOverflow();
+    }
+
+    const Stats& getStats() const { return stats; }
+
+private:
+    struct Overflow {
+        VkBuffer buffer = VK_NULL_HANDLE;
+        GpuAllocation memory;
+    };
+
+    VkDevice device = VK_NULL_HANDLE;
+    VkQueue queue = VK_NULL_HANDLE;
+    GpuAllocator* allocator = nullptr;
+
+    VkCommandPool pool = VK_NULL_HANDLE;
+    VkCommandBuffer cmdBuffer = VK_NULL_HANDLE;
+    VkFence fence = VK_NULL_HANDLE;
+    bool open = false;
+
+    VkBuffer ringBuffer = VK_NULL_HANDLE;
+    GpuAllocation ringMemory;
+    VkDeviceSize ringCapacity = 0;
+    VkDeviceSize ringHead = 0;
+    std::vector<Overflow> overflow;
+
+    std::vector<VkImageMemoryBarrier2> pendingBarriers;
+    Stats stats;
+
+    VkBuffer createStagingBuffer(VkDeviceSize size, GpuAllocation& mem) {
+        VkBufferCreateInfo bi{ VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
+        bi.size = size;
+        bi.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+        bi.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        VkBuffer buf;
+        if (vkCreateBuffer(device, &bi, nullptr, &buf) != VK_SUCCESS)
+            throw std::runtime_error("UploadBatcher: failed to create staging buffer");
+        VkMemoryRequirements req{}; vkGetBufferMemoryRequirements(device, buf, &req);
+        mem = allocator->allocate(req,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            false, AllocStrategy::Linear);
+        vkBindBufferMemory(device, buf, mem.memory, mem.offset);
+        return buf;
+    }
+
+    void releaseOverflow() {
+        for (auto& o : overflow) {
+            vkDestroyBuffer(device, o.buffer, nullptr);
+            allocator->free(o.memory);
+        }
+        overflow.clear();
+    }
+
+    void emitBarriers() {
+        if (pendingBarriers.empty()) return;
+        VkDependencyInfo dep{ VK_STRUCTURE_TYPE_DEPENDENCY_INFO };
+        dep.imageMemoryBarrierCount = (uint32_t)pendingBarriers.size();
+        dep.pImageMemoryBarriers = pendingBarriers.data();
+        vkCmdPipelineBarrier2(cmdBuffer, &dep);
+        pendingBarriers.clear();
+        stats.barrierBatches++;
+    }
+};
@@ -0,0 +1,243 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <glm/glm.hpp>
+#include <array>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+#include <cstring>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define VERTEX_FORMATS_SSE 1
+#if defined(__F16C__) || defined(__AVX2__)
+#include <immintrin.h>
+#define VERTEX_FORMATS_F16C 1
+#endif
+#endif
+
+// --- Compact vertex formats --------------------------------------------------
+// CompactVertex<Pos> stores the attributes of a full-float vertex (pos, color,
+// normal, uv; 44 bytes) in 24 or 20 bytes:
+//   pos    glm::vec3 as is, or Unorm16x4 relative to the mesh's PositionBounds
+//          (the shader computes bias + q * scale from the scene UBO)
+//   color  RGBA8 unorm
+//   normal octahedral, 2 x snorm16, decoded in the vertex shader
+//   uv     2 x half
+// Each attribute's VkFormat follows from its C++ type (VertexAttribFormat), and
+// VertexLayout<V> is the attribute table built from those at compile time.
+//
+// encodeVertices() converts from any struct with glm pos/color/normal/uv
+// members. With SSE2 four vertices are encoded per iteration (half floats use
+// F16C where the target has it); the remainder, and non-SSE targets, take the
+// scalar path, which rounds the same way.
+
+struct Half2     { uint16_t x, y; };
+struct Snorm16x2 { int16_t x, y; };
+struct Unorm8x4  { uint8_t r, g, b, a; };
+struct Unorm16x4 { uint16_t x, y, z, w; };
+
+template <class T> struct VertexAttribFormat;
+template <> struct VertexAttribFormat<glm::vec2> { static constexpr VkFormat value = VK_FORMAT_R32G32_SFLOAT; };
+template <> struct VertexAttribFormat<glm::vec3> { static constexpr VkFormat value = VK_FORMAT_R32G32B32_SFLOAT; };
+template <> struct VertexAttribFormat<Half2>     { static constexpr VkFormat value = VK_FORMAT_R16G16_SFLOAT; };
+template <> struct VertexAttribFormat<Snorm16x2> { static constexpr VkFormat value = VK_FORMAT_R16G16_SNORM; };
+template <> struct VertexAttribFormat<Unorm8x4>  { static constexpr VkFormat value = VK_FORMAT_R8G8B8A8_UNORM; };
+template <> struct VertexAttribFormat<Unorm16x4> { static constexpr VkFormat value = VK_FORMAT_R16G16B16A16_UNORM; };
+
+template <class T>
+constexpr VkVertexInputAttributeDescription vertexAttribute(uint32_t location, size_t offset) {
+    return { location, 0, VertexAttribFormat<T>::value, (uint32_t)offset };
+}
+
+// Specialised per vertex type: `static constexpr std::array<...> attributes`.
+template <class V> struct VertexLayout;
+
+template <class V>
+constexpr VkVertexInputBindingDescription vertexBinding() {
+    return { 0, (uint32_t)sizeof(V), VK_VERTEX_INPUT_RATE_VERTEX };
+}
+
+template <class Pos>
+struct CompactVertex {
+    Pos       pos;
+    Unorm8x4  color;
+    Snorm16x2 normal;
+    Half2     uv;
+};
+using CompactVertexF = CompactVertex<glm::vec3>;   // float position
+using CompactVertexQ = CompactVertex<Unorm16x4>;   // quantized position
+static_assert(sizeof(CompactVertexF) == 24, "CompactVertexF layout");
+static_assert(sizeof(CompactVertexQ) == 20, "CompactVertexQ layout");
+
+template <class Pos>
+struct VertexLayout<CompactVertex<Pos>> {
+    using V = CompactVertex<Pos>;
+    static constexpr std::array<VkVertexInputAttributeDescription, 4> attributes{ {
+        vertexAttribute<Pos>(0, offsetof(V, pos)),
+        vertexAttribute<Unorm8x4>(1, offsetof(V, color)),
+        vertexAttribute<Snorm16x2>(2, offsetof(V, normal)),
+        vertexAttribute<Half2>(3, offsetof(V, uv)),
+    } };
+};
+
+// Dequantization for Unorm16x4 positions: pos = min + q * extent.
+struct PositionBounds {
+    glm::vec3 min{ 0.0f }, extent{ 1.0f };
+};
+
+template <class S>
+PositionBounds positionBounds(const S* src, size_t count) {
+    if (count == 0) return {};
+    glm::vec3 lo = src[0].pos, hi = src[0].pos;
+    for (size_t i = 1; i < count; ++i) {
+        lo = glm::min(lo, src[i].pos);
+        hi = glm::max(hi, src[i].pos);
+    }
+    return { lo, hi - lo };
+}
+
+// IEEE binary16, round to nearest even.
+inline uint16_t floatToHalf(float f) {
+    uint32_t x;
+    std::memcpy(&x, &f, 4);
+    uint32_t sign = (x >> 16) & 0x8000u, a = x & 0x7FFFFFFFu;
+    if (a >= 0x7F800000u) return (uint16_t)(sign | 0x7C00u | (a > 0x7F800000u ? 0x200u : 0u));   // inf / nan
+    if (a >= 0x477FF000u) return (uint16_t)(sign | 0x7C00u);                                     // rounds past 65504
+    if (a < 0x38800000u) {                                                                        // half subnormal
+        if (a <= 0x33000000u) return (uint16_t)sign;
+        uint32_t shift = 126u - (a >> 23), mant = (a & 0x007FFFFFu) | 0x00800000u;
+        uint32_t h = mant >> shift, rem = mant & ((1u << shift) - 1u), halfway = 1u << (shift - 1u);
+        if (rem > halfway || (rem == halfway && (h & 1u))) h++;
+        return (uint16_t)(sign | h);
+    }
+    uint32_t h = (a - 0x38000000u) >> 13, rem = a & 0x1FFFu;
+    if (rem > 0x1000u || (rem == 0x1000u && (h & 1u))) h++;
+    return (uint16_t)(sign | h);
+}
+
+inline Snorm16x2 octEncode(glm::vec3 n) {
+    float l1 = std::fabs(n.x) + std::fabs(n.y) + std::fabs(n.z);
+    float inv = 1.0f / l1;
+    float px = n.x * inv, py = n.y * inv;
+    if (n.z < 0.0f) {
+        float fx = (1.0f - std::fabs(py)) * (px >= 0.0f ? 1.0f : -1.0f);
+        float fy = (1.0f - std::fabs(px)) * (py >= 0.0f ? 1.0f : -1.0f);
+        px = fx;
+        py = fy;
+    }
+    auto q = [](float v) { return (int16_t)std::nearbyint(std::clamp(v, -1.0f, 1.0f) * 32767.0f); };
+    return { q(px), q(py) };
+}
+
+inline glm::vec3 octDecode(Snorm16x2 e) {
+    glm::vec3 n(std::max(e.x / 32767.0f, -1.0f), std::max(e.y / 32767.0f, -1.0f), 0.0f);
+    n.z = 1.0f - std::fabs(n.x) - std::fabs(n.y);
+    float t = std::max(-n.z, 0.0f);
+    n.x += n.x >= 0.0f ? -t : t;
+    n.y += n.y >= 0.0f ? -t : t;
+    return glm::normalize(n);
+}
+
+inline void encodePosition(glm::vec3 p, const PositionBounds&, glm::vec3& out) { out = p; }
+
+inline void encodePosition(glm::vec3 p, const PositionBounds& b, Unorm16x4& out) {
+    auto q = [](float v, float lo, float ext) {
+        float t = ext > 0.0f ? (v - lo) / ext : 0.0f;
+        return (uint16_t)std::nearbyint(std::clamp(t, 0.0f, 1.0f) * 65535.0f);
+    };
+    out = { q(p.x, b.min.x, b.extent.x), q(p.y, b.min.y, b.extent.y), q(p.z, b.min.z, b.extent.z), 0 };
+}
+
+template <class Pos, class S>
+void encodeVertexScalar(const S& s, const PositionBounds& b, CompactVertex<Pos>& d) {
+    encodePosition(s.pos, b, d.pos);
+    auto c = [](float v) { return (uint8_t)std::nearbyint(std::clamp(v, 0.0f, 1.0f) * 255.0f); };
+    d.color = { c(s.color.r), c(s.color.g), c(s.color.b), 255 };
+    d.normal = octEncode(s.normal);
+    d.uv = { floatToHalf(s.uv.x), floatToHalf(s.uv.y) };
+}
+
+template <class Pos, class S>
+void encodeVertices(const S* src, size_t count, const PositionBounds& bounds, CompactVertex<Pos>* dst, bool simd = true) {
+    size_t i = 0;
+#ifdef VERTEX_FORMATS_SSE
+    const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f), minusOne = _mm_set1_ps(-1.0f);
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+    auto clamp = [](__m128 v, __m128 lo, __m128 hi) { return _mm_min_ps(_mm_max_ps(v, lo), hi); };
+    auto gather = [&](size_t base, auto field) {
+        return _mm_setr_ps(field(src[base]), field(src[base + 1]), field(src[base + 2]), field(src[base + 3]));
+    };
+    for (; simd && i + 4 <= count; i += 4) {
+        alignas(16) int32_t ox[4], oy[4], cr[4], cg[4], cb[4];
+
+        // octahedral normals
+        __m128 nx = gather(i, [](const S& v) { return v.normal.x; });
+        __m128 ny = gather(i, [](const S& v) { return v.normal.y; });
+        __m128 nz = gather(i, [](const S& v) { return v.normal.z; });
+        __m128 ax = _mm_and_ps(nx, absMask), ay = _mm_and_ps(ny, absMask), az = _mm_and_ps(nz, absMask);
+        __m128 inv = _mm_div_ps(one, _mm_add_ps(_mm_add_ps(ax, ay), az));
+        __m128 px = _mm_mul_ps(nx, inv), py = _mm_mul_ps(ny, inv);
+        __m128 sx = _mm_cmpge_ps(px, zero), sy = _mm_cmpge_ps(py, zero);
+        sx = _mm_or_ps(_mm_and_ps(sx, one), _mm_andnot_ps(sx, minusOne));
+        sy = _mm_or_ps(_mm_and_ps(sy, one), _mm_andnot_ps(sy, minusOne));
+        __m128 fx = _mm_mul_ps(_mm_sub_ps(one, _mm_and_ps(py, absMask)), sx);
+        __m128 fy = _mm_mul_ps(_mm_sub_ps(one, _mm_and_ps(px, absMask)), sy);
+        __m128 lower = _mm_cmplt_ps(nz, zero);
+        px = _mm_or_ps(_mm_and_ps(lower, fx), _mm_andnot_ps(lower, px));
+        py = _mm_or_ps(_mm_and_ps(lower, fy), _mm_andnot_ps(lower, py));
+        const __m128 s16 = _mm_set1_ps(32767.0f);
+        _mm_store_si128((__m128i*)ox, _mm_cvtps_epi32(_mm_mul_ps(clamp(px, minusOne, one), s16)));
+        _mm_store_si128((__m128i*)oy, _mm_cvtps_epi32(_mm_mul_ps(clamp(py, minusOne, one), s16)));
+
+        // color
+        const __m128 s8 = _mm_set1_ps(255.0f);
+        _mm_store_si128((__m128i*)cr, _mm_cvtps_epi32(_mm_mul_ps(clamp(gather(i, [](const S& v) { return v.color.r; }), zero, one), s8)));
+        _mm_store_si128((__m128i*)cg, _mm_cvtps_epi32(_mm_mul_ps(clamp(gather(i, [](const S& v) { return v.color.g; }), zero, one), s8)));
+        _mm_store_si128((__m128i*)cb, _mm_cvtps_epi32(_mm_mul_ps(clamp(gather(i, [](const S& v) { return v.color.b; }), zero, one), s8)));
+
+        // uv
+        alignas(16) uint16_t uv[8];
+#ifdef VERTEX_FORMATS_F16C
+        __m128i lo = _mm_cvtps_ph(_mm_setr_ps(src[i].uv.x, src[i].uv.y, src[i + 1].uv.x, src[i + 1].uv.y), _MM_FROUND_TO_NEAREST_INT);
+        __m128i hi = _mm_cvtps_ph(_mm_setr_ps(src[i + 2].uv.x, src[i + 2].uv.y, src[i + 3].uv.x, src[i + 3].uv.y), _MM_FROUND_TO_NEAREST_INT);
+        _mm_store_si128((__m128i*)uv, _mm_unpacklo_epi64(lo, hi));
+#else
+        for (int k = 0; k < 4; ++k) {
+            uv[k * 2] = floatToHalf(src[i + k].uv.x);
+            uv[k * 2 + 1] = floatToHalf(src[i + k].uv.y);
+        }
+#endif
+
+        // position
+        if constexpr (std::is_same_v<Pos, Unorm16x4>) {
+            alignas(16) int32_t q[3][4];
+            const float* lo3 = &bounds.min.x;
+            const float* ext3 = &bounds.extent.x;
+            for (int c = 0; c < 3; ++c) {
+                __m128 p = _mm_setr_ps(src[i].pos[c], src[i + 1].pos[c], src[i + 2].pos[c], src[i + 3].pos[c]);
+                __m128 t = ext3[c] > 0.0f ? _mm_div_ps(_mm_sub_ps(p, _mm_set1_ps(lo3[c])), _mm_set1_ps(ext3[c])) : zero;
+                _mm_store_si128((__m128i*)q[c], _mm_cvtps_epi32(_mm_mul_ps(clamp(t, zero, one), _mm_set1_ps(65535.0f))));
+            }
+            for (int k = 0; k < 4; ++k)
+                dst[i + k].pos = { (uint16_t)q[0][k], (uint16_t)q[1][k], (uint16_t)q[2][k], 0 };
+        }
+        else {
+            for (int k = 0; k < 4; ++k) dst[i + k].pos = src[i + k].pos;
+        }
+
+        for (int k = 0; k < 4; ++k) {
+            CompactVertex<Pos>& d = dst[i + k];
+            d.color = { (uint8_t)cr[k], (uint8_t)cg[k], (uint8_t)cb[k], 255 };
+            d.normal = { (int16_t)ox[k], (int16_t)oy[k] };
+            d.uv = { uv[k * 2], uv[k * 2 + 1] };
+        }
+    }
+#else
+    (void)simd;
+#endif
+    for (; i < count; ++i) encodeVertexScalar(src[i], bounds, dst[i]);
+}
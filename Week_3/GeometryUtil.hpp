@@ -2,8 +2,20 @@
 #include <vector>
 #include <cstdint>
 #include <cmath>
+#include <cstddef>
 #include <glm/glm.hpp>
 
+#if defined(__AVX__)
+#include <immintrin.h>
+#define GEOMETRY_SIMD_AVX 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define GEOMETRY_SIMD_SSE 1
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define GEOMETRY_SIMD_NEON 1
+#endif
+
 struct Vertex {
     glm::vec3 pos;
     glm::vec3 color;
@@ -133,8 +145,8 @@ inline MeshData createSphereStrip(float r, uint32_t sliceCount, uint32_t stackCo
         md.indices.push_back(RESTART_INDEX);
     }
 
-    // middle bands
-    for (uint32_t i = 0; i + 1 < interior; ++i) {
+    // middle bands: one between each pair of the stackCount - 1 rings
+    for (uint32_t i = 0; i < interior; ++i) {
         for (uint32_t j = 0; j <= sliceCount; ++j) {
             uint32_t i0 = base + i * ring + j;
             uint32_t i1 = i0 + ring;
@@ -157,3 +169,250 @@ inline MeshData createSphereStrip(float r, uint32_t sliceCount, uint32_t stackCo
 
     return md;
 }
+
+// --- Batched generators --------------------------------------------------------
+// Same meshes and index order as the generators above, plus normals and UVs,
+// written as SoA streams into buffers sized up front. Every stream row is an
+// affine function of a lane index or of a sin/cos ring that is computed once
+// per mesh, so the per-vertex work is three kernels (fill, ramp, scaled ring)
+// run GeoSimd::WIDTH lanes at a time: AVX 8, SSE2 / NEON 4, otherwise 1.
+
+struct GeoSimd {
+#if defined(GEOMETRY_SIMD_AVX)
+    using V = __m256;
+    static constexpr size_t WIDTH = 8;
+    static constexpr const char* NAME = "AVX";
+    static V set1(float a) { return _mm256_set1_ps(a); }
+    static V add(V a, V b) { return _mm256_add_ps(a, b); }
+    static V mul(V a, V b) { return _mm256_mul_ps(a, b); }
+    static V load(const float* p) { return _mm256_loadu_ps(p); }
+    static void store(float* p, V a) { _mm256_storeu_ps(p, a); }
+    static V lanes() { return _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7); }
+#elif defined(GEOMETRY_SIMD_SSE)
+    using V = __m128;
+    static constexpr size_t WIDTH = 4;
+    static constexpr const char* NAME = "SSE2";
+    static V set1(float a) { return _mm_set1_ps(a); }
+    static V add(V a, V b) { return _mm_add_ps(a, b); }
+    static V mul(V a, V b) { return _mm_mul_ps(a, b); }
+    static V load(const float* p) { return _mm_loadu_ps(p); }
+    static void store(float* p, V a) { _mm_storeu_ps(p, a); }
+    static V lanes() { return _mm_setr_ps(0, 1, 2, 3); }
+#elif defined(GEOMETRY_SIMD_NEON)
+    using V = float32x4_t;
+    static constexpr size_t WIDTH = 4;
+    static constexpr const char* NAME = "NEON";
+    static V set1(float a) { return vdupq_n_f32(a); }
+    static V add(V a, V b) { return vaddq_f32(a, b); }
+    static V mul(V a, V b) { return vmulq_f32(a, b); }
+    static V load(const float* p) { return vld1q_f32(p); }
+    static void store(float* p, V a) { vst1q_f32(p, a); }
+    static V lanes() { static const float l[4] = { 0, 1, 2, 3 }; return vld1q_f32(l); }
+#else
+    using V = float;
+    static constexpr size_t WIDTH = 1;
+    static constexpr const char* NAME = "scalar";
+    static V set1(float a) { return a; }
+    static V add(V a, V b) { return a + b; }
+    static V mul(V a, V b) { return a * b; }
+    static V load(const float* p) { return *p; }
+    static void store(float* p, V a) { *p = a; }
+    static V lanes() { return 0.0f; }
+#endif
+};
+
+// out[k] = a
+inline void geoFill(float* out, size_t count, float a) {
+    size_t k = 0;
+    const GeoSimd::V va = GeoSimd::set1(a);
+    for (; k + GeoSimd::WIDTH <= count; k += GeoSimd::WIDTH) GeoSimd::store(out + k, va);
+    for (; k < count; ++k) out[k] = a;
+}
+
+// out[k] = a + b * k
+inline void geoRamp(float* out, size_t count, float a, float b) {
+    size_t k = 0;
+    const GeoSimd::V va = GeoSimd::set1(a), vb = GeoSimd::set1(b), step = GeoSimd::set1((float)GeoSimd::WIDTH);
+    GeoSimd::V idx = GeoSimd::lanes();
+    for (; k + GeoSimd::WIDTH <= count; k += GeoSimd::WIDTH) {
+        GeoSimd::store(out + k, GeoSimd::add(va, GeoSimd::mul(vb, idx)));
+        idx = GeoSimd::add(idx, step);
+    }
+    for (; k < count; ++k) out[k] = a + b * (float)k;
+}
+
+// out[k] = b * ring[k]
+inline void geoScaled(float* out, size_t count, float b, const float* ring) {
+    size_t k = 0;
+    const GeoSimd::V vb = GeoSimd::set1(b);
+    for (; k + GeoSimd::WIDTH <= count; k += GeoSimd::WIDTH)
+        GeoSimd::store(out + k, GeoSimd::mul(vb, GeoSimd::load(ring + k)));
+    for (; k < count; ++k) out[k] = b * ring[k];
+}
+
+struct MeshStreams {
+    std::vector<float> px, py, pz;   // position
+    std::vector<float> nx, ny, nz;   // unit normal
+    std::vector<float> u, v;
+    std::vector<uint32_t> indices;   // triangle strips separated by RESTART_INDEX
+
+    void resize(size_t vertexCount, size_t indexCount) {
+        for (std::vector<float>* s : { &px, &py, &pz, &nx, &ny, &nz, &u, &v }) s->resize(vertexCount);
+        indices.resize(indexCount);
+    }
+    size_t vertexCount() const { return px.size(); }
+
+    // One vertex's worth of every stream, for the caps and poles.
+    void set(size_t i, glm::vec3 p, glm::vec3 n, glm::vec2 t) {
+        px[i] = p.x; py[i] = p.y; pz[i] = p.z;
+        nx[i] = n.x; ny[i] = n.y; nz[i] = n.z;
+        u[i] = t.x; v[i] = t.y;
+    }
+
+    // Every stream at vertex `first`, for filling one row of a surface.
+    struct Row { float* p[3]; float* n[3]; float* t[2]; };
+    Row row(size_t first) {
+        return { { &px[first], &py[first], &pz[first] }, { &nx[first], &ny[first], &nz[first] }, { &u[first], &v[first] } };
+    }
+};
+
+// cos/sin of j * 2pi / sliceCount for j = 0..sliceCount, as the scalar generators compute them.
+inline void geoRing(uint32_t sliceCount, std::vector<float>& cosRing, std::vector<float>& sinRing) {
+    cosRing.resize(sliceCount + 1);
+    sinRing.resize(sliceCount + 1);
+    for (uint32_t j = 0; j <= sliceCount; ++j) {
+        float theta = j * 2.0f * 3.1415926535f / sliceCount;
+        cosRing[j] = std::cos(theta);
+        sinRing[j] = std::sin(theta);
+    }
+}
+
+// Caps shared by the cylinder and sphere: a fan of (center, a + j, a + j + 1)
+// strips, or the reverse winding for the lower cap.
+inline uint32_t* geoCapIndices(uint32_t* out, uint32_t center, uint32_t ringStart, uint32_t sliceCount, bool upper) {
+    for (uint32_t j = 0; j < sliceCount; ++j) {
+        *out++ = center;
+        *out++ = ringStart + j + (upper ? 0 : 1);
+        *out++ = ringStart + j + (upper ? 1 : 0);
+        *out++ = RESTART_INDEX;
+    }
+    return out;
+}
+
+// Strips joining `bands` consecutive rings of `ring` vertices from `base`.
+inline uint32_t* geoBandIndices(uint32_t* out, uint32_t base, uint32_t ring, uint32_t bands) {
+    for (uint32_t i = 0; i < bands; ++i) {
+        for (uint32_t j = 0; j < ring; ++j) {
+            *out++ = base + i * ring + j;
+            *out++ = base + (i + 1) * ring + j;
+        }
+        *out++ = RESTART_INDEX;
+    }
+    return out;
+}
+
+inline MeshStreams createGridStreams(float width, float depth, uint32_t m, uint32_t n) {
+    MeshStreams ms;
+    ms.resize((size_t)m * n, (size_t)(n - 1) * (2 * m + 1));
+
+    const float dx = width / (m - 1);
+    const float dz = depth / (n - 1);
+    const float x0 = -width * 0.5f;
+    const float z0 = -depth * 0.5f;
+
+    for (uint32_t j = 0; j < n; ++j) {
+        MeshStreams::Row r = ms.row((size_t)j * m);
+        geoRamp(r.p[0], m, x0, dx);
+        geoFill(r.p[1], m, 0.0f);
+        geoFill(r.p[2], m, z0 + j * dz);
+        geoFill(r.n[0], m, 0.0f);
+        geoFill(r.n[1], m, 1.0f);
+        geoFill(r.n[2], m, 0.0f);
+        geoRamp(r.t[0], m, 0.0f, 1.0f / (m - 1));
+        geoFill(r.t[1], m, (float)j / (n - 1));
+    }
+
+    geoBandIndices(ms.indices.data(), 0, m, n - 1);
+    return ms;
+}
+
+inline MeshStreams createCylinderStreams(float bottomR, float topR, float height, uint32_t sliceCount, uint32_t stackCount) {
+    const uint32_t ring = sliceCount + 1;
+    MeshStreams ms;
+    ms.resize((size_t)(stackCount + 1) * ring + 2, (size_t)stackCount * (2 * ring + 1) + 2 * (size_t)sliceCount * 4);
+
+    std::vector<float> cosRing, sinRing;
+    geoRing(sliceCount, cosRing, sinRing);
+
+    // side normal: (cos, (bottomR - topR) / height, sin), normalized
+    const float slope = (bottomR - topR) / height;
+    const float k = 1.0f / std::sqrt(1.0f + slope * slope);
+    const float stackHeight = height / stackCount;
+    const float radiusStep = (topR - bottomR) / stackCount;
+
+    for (uint32_t i = 0; i <= stackCount; ++i) {
+        float y = -0.5f * height + i * stackHeight;
+        float r = bottomR + i * radiusStep;
+        MeshStreams::Row row = ms.row((size_t)i * ring);
+        geoScaled(row.p[0], ring, r, cosRing.data());
+        geoFill(row.p[1], ring, y);
+        geoScaled(row.p[2], ring, r, sinRing.data());
+        geoScaled(row.n[0], ring, k, cosRing.data());
+        geoFill(row.n[1], ring, slope * k);
+        geoScaled(row.n[2], ring, k, sinRing.data());
+        geoRamp(row.t[0], ring, 0.0f, 1.0f / sliceCount);
+        geoFill(row.t[1], ring, (float)i / stackCount);
+    }
+
+    const uint32_t topCenter = (stackCount + 1) * ring, bottomCenter = topCenter + 1;
+    ms.set(topCenter, { 0.0f, +0.5f * height, 0.0f }, { 0.0f, 1.0f, 0.0f }, { 0.5f, 1.0f });
+    ms.set(bottomCenter, { 0.0f, -0.5f * height, 0.0f }, { 0.0f, -1.0f, 0.0f }, { 0.5f, 0.0f });
+
+    uint32_t* out = geoBandIndices(ms.indices.data(), 0, ring, stackCount);
+    out = geoCapIndices(out, topCenter, stackCount * ring, sliceCount, true);
+    geoCapIndices(out, bottomCenter, 0, sliceCount, false);
+    return ms;
+}
+
+inline MeshStreams createSphereStreams(float r, uint32_t sliceCount, uint32_t stackCount) {
+    const uint32_t ring = sliceCount + 1;
+    const uint32_t rings = stackCount - 1;
+    const uint32_t interior = (stackCount >= 2 ? stackCount - 2 : 0);
+    MeshStreams ms;
+    ms.resize((size_t)rings * ring + 2,
+        (size_t)sliceCount * 4 + (size_t)interior * (2 * ring + 1) + (interior > 0 ? (size_t)sliceCount * 4 : 0));
+
+    std::vector<float> cosRing, sinRing;
+    geoRing(sliceCount, cosRing, sinRing);
+
+    const uint32_t top = 0, base = 1, south = base + rings * ring;
+    ms.set(top, { 0.0f, +r, 0.0f }, { 0.0f, 1.0f, 0.0f }, { 0.5f, 0.0f });
+    for (uint32_t i = 1; i <= rings; ++i) {
+        float phi = 3.1415926535f * i / stackCount;
+        float cp = std::cos(phi), sp = std::sin(phi);
+        MeshStreams::Row row = ms.row(base + (size_t)(i - 1) * ring);
+        geoScaled(row.p[0], ring, r * sp, cosRing.data());
+        geoFill(row.p[1], ring, r * cp);
+        geoScaled(row.p[2], ring, r * sp, sinRing.data());
+        geoScaled(row.n[0], ring, sp, cosRing.data());
+        geoFill(row.n[1], ring, cp);
+        geoScaled(row.n[2], ring, sp, sinRing.data());
+        geoRamp(row.t[0], ring, 0.0f, 1.0f / sliceCount);
+        geoFill(row.t[1], ring, (float)i / stackCount);
+    }
+    ms.set(south, { 0.0f, -r, 0.0f }, { 0.0f, -1.0f, 0.0f }, { 0.5f, 1.0f });
+
+    uint32_t* out = geoCapIndices(ms.indices.data(), top, base, sliceCount, true);
+    out = geoBandIndices(out, base, ring, interior);
+    if (interior > 0) geoCapIndices(out, south, south - ring, sliceCount, false);
+    return ms;
+}
+
+// Interleaves streams into the pos + color MeshData the scalar generators return.
+inline MeshData toMeshData(const MeshStreams& ms, glm::vec3 color) {
+    MeshData md;
+    md.vertices.resize(ms.vertexCount());
+    for (size_t i = 0; i < ms.vertexCount(); ++i) md.vertices[i] = { { ms.px[i], ms.py[i], ms.pz[i] }, color };
+    md.indices = ms.indices;
+    return md;
+}